@@ -23,11 +23,21 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iomanip>
 #include <ppl.h>
 
 int main(int argc, char** argv)
 {
     CLI::CLSettings settings = CLI::processCommandLine(argc, argv);
+    if (settings.mergeShards) {
+        CLI::mergeShardFiles(settings);
+        return 0;
+    }
     if (settings.missingStructureFilePath) {
         std::cout << "Structure file path input is missing! Abort.\n";
         return 1;
@@ -46,6 +56,22 @@ namespace CLI {
             return settings;
         }
 
+        //merge <shard files> --output-file-path <path>
+        if (std::string_view{ argv[1] } == "merge") {
+            settings.mergeShards = true;
+            for (int i = 2; i < argc; i++) {
+                std::string_view component = std::string_view{ argv[i] };
+                if (component == "--output-file-path" && argc > i + 1) {
+                    settings.generateOutput = true;
+                    settings.outputFilePath = std::string{ argv[++i] };
+                }
+                else {
+                    settings.shardFilePaths.push_back(std::string{ component });
+                }
+            }
+            return settings;
+        }
+
         for (int i = 1; i < argc; i++) {
             std::string_view component = std::string_view{ argv[i] };
             if (component == "--structure-file-path" && argc >= i + 1) {
@@ -66,24 +92,129 @@ namespace CLI {
                 settings.generateOutput = true;
                 settings.outputFilePath = std::string{ argv[i + 1] };
             }
+            if (component == "--store-file-path" && argc >= i + 1) {
+                settings.generateStore = true;
+                settings.storeFilePath = std::string{ argv[i + 1] };
+            }
+            if (component == "--open-store" && argc >= i + 1) {
+                settings.openStoreFilePath = std::string{ argv[i + 1] };
+            }
             if (component == "--target-talent-count" && argc >= i + 1) {
                 settings.targetTalentCount = std::stoi(std::string{ argv[i + 1] });
             }
             if (component == "--parallel" || component == "--concurrent") {
                 settings.solveParallel = true;
             }
+            if (component == "--no-solve-cache") {
+                settings.useSolveCache = false;
+            }
+            if (component == "--solve-cache-budget" && argc >= i + 1) {
+                settings.solveCacheBudget = std::stoull(std::string{ argv[i + 1] });
+            }
+            if (component == "--memory-budget" && argc >= i + 1) {
+                settings.memoryBudget = std::stoull(std::string{ argv[i + 1] });
+            }
+            if (component == "--progress-interval" && argc >= i + 1) {
+                settings.progressInterval = std::stoi(std::string{ argv[i + 1] });
+            }
+            if (component == "--checkpoint-interval" && argc >= i + 1) {
+                settings.checkpointInterval = std::stoi(std::string{ argv[i + 1] });
+            }
+            if (component == "--resume") {
+                settings.resumeSolve = true;
+            }
+            if (component == "--count-only") {
+                settings.countOnly = true;
+            }
+            if (component == "--shard" && argc >= i + 1) {
+                //i/N with 1 <= i <= N, a shard count of 0 marks an invalid input
+                std::vector<std::string> shardParts = Engine::splitString(std::string{ argv[i + 1] }, "/");
+                settings.shard.count = 0;
+                if (shardParts.size() == 2) {
+                    settings.shard.index = std::stoi(shardParts[0]) - 1;
+                    settings.shard.count = std::stoi(shardParts[1]);
+                }
+            }
+            if (component == "--sample" && argc >= i + 1) {
+                settings.sampleCount = std::stoull(std::string{ argv[i + 1] });
+            }
+            if (component == "--top-k" && argc >= i + 1) {
+                settings.topK = std::stoull(std::string{ argv[i + 1] });
+            }
+            if (component == "--scores-file-path" && argc >= i + 1) {
+                settings.scoresFilePath = std::string{ argv[i + 1] };
+            }
+            if (component == "--seed" && argc >= i + 1) {
+                settings.sampleSeedProvided = true;
+                settings.sampleSeed = std::stoull(std::string{ argv[i + 1] });
+            }
+        }
+        if (settings.resumeSolve && settings.checkpointInterval <= 0) {
+            //resumed solves keep checkpointing in case they get interrupted again
+            settings.checkpointInterval = static_cast<int>(SOLVE_CHECKPOINT_DEFAULT_INTERVAL);
+        }
+        if (settings.sampleCount > 0 && !settings.sampleSeedProvided) {
+            //print the seed so a random run can be repeated
+            std::random_device rd;
+            settings.sampleSeed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
         }
 
         return settings;
     }
 
     void runCombinationCount(CLSettings settings) {
+        if (settings.openStoreFilePath != "") {
+            outputCombinationStore(settings);
+            return;
+        }
+        if (settings.shard.count < 1 || settings.shard.index < 0 || settings.shard.index >= settings.shard.count) {
+            std::cout << "Invalid shard, use --shard i/N with 1 <= i <= N.\n";
+            return;
+        }
+        if (settings.shard.count > 1 && (settings.generateStore || settings.topK > 0 || settings.sampleCount > 0)) {
+            std::cout << "Shards only support text output (--output-file-path) and counting.\n";
+            return;
+        }
+        if (settings.countOnly && (settings.generateOutput || settings.generateStore || settings.filterProvided || settings.shard.count > 1
+            || settings.topK > 0 || settings.sampleCount > 0)) {
+            std::cout << "Count only runs don't support output files, filters, shards, best builds and random samples.\n";
+            return;
+        }
+        Engine::setSolverMemoryBudget(settings.memoryBudget);
         printSettings(settings);
-        std::vector<RunDetails> allRunDetails = generateRunDetails(settings);
+        if (settings.topK > 0) {
+            try {
+                settings.talentScores = Engine::loadTalentScores(settings.scoresFilePath);
+            }
+            catch (std::logic_error& e) {
+                std::cout << e.what() << "\n";
+                return;
+            }
+        }
+        Engine::setSolveCacheEnabled(settings.useSolveCache);
+        if (settings.solveCacheBudget > 0) {
+            Engine::setSolveCacheDiskBudget(settings.solveCacheBudget * 1024 * 1024);
+        }
+        std::vector<RunDetails> allRunDetails;
+        try {
+            allRunDetails = generateRunDetails(settings);
+        }
+        catch (std::logic_error& e) {
+            std::cout << e.what() << "\n";
+            return;
+        }
         if (allRunDetails.size() == 0) {
             std::cout << "No valid trees found in input or input file is corrupt.\n";
             return;
         }
+        if (settings.topK > 0 || settings.sampleCount > 0) {
+            for (auto& details : allRunDetails) {
+                if (details.filterExpression) {
+                    std::cout << "Filter expressions are not supported for best builds (--top-k) and random samples (--sample).\n";
+                    return;
+                }
+            }
+        }
         startThreadedCombinationCount(allRunDetails, settings);
         outputCombinations(allRunDetails, settings);
     }
@@ -105,7 +236,35 @@ namespace CLI {
         else {
             std::cout << "No file output will be generated.\n";
         }
-        std::cout << "Target talent count:\t" << settings.targetTalentCount << "\n";
+        if (settings.generateStore) {
+            std::cout << "Combination store path:\t" << settings.storeFilePath << "\n";
+        }
+        std::cout << "Target talent count:\t" << settings.targetTalentCount << (settings.countOnly ? " (count only)" : "") << "\n";
+        if (settings.topK > 0) {
+            std::cout << "Best builds:\t\t" << settings.topK << " per tree (scores " << settings.scoresFilePath << ")\n";
+        }
+        if (settings.sampleCount > 0) {
+            std::cout << "Random samples:\t\t" << settings.sampleCount << " per tree (seed " << settings.sampleSeed << ")\n";
+        }
+        std::cout << "Memory budget:\t\t" << Engine::getSolverMemoryBudget() << " bytes\n";
+        if (settings.progressInterval > 0) {
+            std::cout << "Progress interval:\t" << settings.progressInterval << " s\n";
+        }
+        if (settings.checkpointInterval > 0) {
+            std::cout << "Checkpoint interval:\t" << settings.checkpointInterval << " s" << (settings.resumeSolve ? " (resume)" : "") << "\n";
+        }
+        else {
+            std::cout << "Checkpoints disabled.\n";
+        }
+        if (settings.shard.count > 1) {
+            std::cout << "Shard:\t\t\t" << settings.shard.index + 1 << " of " << settings.shard.count << "\n";
+        }
+        if (settings.useSolveCache) {
+            std::cout << "Solve cache:\t\t" << Engine::getSolveCacheDirectory().string() << "\n";
+        }
+        else {
+            std::cout << "Solve cache disabled.\n";
+        }
     }
 
     std::vector<RunDetails> generateRunDetails(CLSettings settings) {
@@ -155,7 +314,7 @@ namespace CLI {
             }
         }
 
-        // check if filter provided, if not, update skillsets to empty, if yes, set up filter skillsets
+        // check if filter provided, if not, update skillsets to empty, if yes, set up filter skillsets or filter expressions ("expr:" prefix)
         if (settings.filterProvided) {
             if (settings.rawFilter != "") {
                 std::vector<std::string> filters = Engine::splitString(settings.rawFilter, ";");
@@ -166,6 +325,11 @@ namespace CLI {
                     if (i >= filters.size()) {
                         break;
                     }
+                    if (filters[i].rfind("expr:", 0) == 0) {
+                        allRunDetails[i].filterExpression = std::make_shared<Engine::FilterExpression>(
+                            Engine::parseFilterExpression(allRunDetails[i].tree, filters[i].substr(5)));
+                        continue;
+                    }
                     std::vector<std::string> filterParts = Engine::splitString(filters[i], ":");
                     bool positionalIndexing = filterParts[0].find(',') == std::string::npos;
                     if (positionalIndexing) {
@@ -239,6 +403,13 @@ namespace CLI {
                             line = line.substr(0, line.size() - 1);
                         }
 
+                        if (line.rfind("expr:", 0) == 0) {
+                            allRunDetails[treeIndex].filterExpression = std::make_shared<Engine::FilterExpression>(
+                                Engine::parseFilterExpression(allRunDetails[treeIndex].tree, line.substr(5)));
+                            treeIndex++;
+                            continue;
+                        }
+
                         std::vector<std::string> skillsetParts = Engine::splitString(line, ":");
 
                         //we can ignore the name + meta info at index 0
@@ -267,129 +438,459 @@ namespace CLI {
     }
 
     void startThreadedCombinationCount(std::vector<RunDetails>& allRunDetails, CLSettings& settings) {
+        for (auto& details : allRunDetails) {
+            details.solveHandle = std::make_shared<Engine::SolveHandle>();
+        }
+        //progress lines go to stderr so they don't mix with the results
+        std::mutex progressMutex;
+        std::condition_variable progressCondition;
+        bool solvesDone = false;
+        std::thread progressThread;
+        if (settings.progressInterval > 0) {
+            progressThread = std::thread([&]() {
+                std::unique_lock<std::mutex> lock(progressMutex);
+                while (!progressCondition.wait_for(lock, std::chrono::seconds(settings.progressInterval), [&]() { return solvesDone; })) {
+                    printSolveProgress(allRunDetails);
+                }
+                });
+        }
         if (settings.solveParallel) {
             Concurrency::parallel_for(size_t(0), allRunDetails.size(), [&](size_t i) {
-                bool dummyProgress = true;
-                Engine::clearTree(allRunDetails[i].tree);
-                Engine::countConfigurationsFiltered(
-                    allRunDetails[i].tree,
-                    allRunDetails[i].filter,
-                    allRunDetails[i].targetTalentCount,
-                    allRunDetails[i].treeDAGInfo,
-                    dummyProgress,
-                    allRunDetails[i].safetyGuardTriggered
-                );
+                solveTree(allRunDetails[i], settings, i, allRunDetails.size(), 1);
+                allRunDetails[i].solveHandle->markFinished();
                 });
         }
         else {
             for (size_t i = 0; i < allRunDetails.size(); i++) {
-                bool dummyProgress = true;
-                Engine::clearTree(allRunDetails[i].tree);
-                Engine::countConfigurationsFiltered(
-                    allRunDetails[i].tree,
-                    allRunDetails[i].filter,
-                    allRunDetails[i].targetTalentCount,
-                    allRunDetails[i].treeDAGInfo,
-                    dummyProgress,
-                    allRunDetails[i].safetyGuardTriggered
-                );
+                solveTree(allRunDetails[i], settings, i, allRunDetails.size(), 0);
+                allRunDetails[i].solveHandle->markFinished();
+            }
+        }
+        if (progressThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                solvesDone = true;
             }
+            progressCondition.notify_all();
+            progressThread.join();
         }
+        for (auto& details : allRunDetails) {
+            if (details.error != "") {
+                std::cout << details.tree.name << ":\t" << details.error << "\n";
+                continue;
+            }
+            std::cout << details.tree.name << ":\t" << Engine::getCombinationsSumString(*details.treeDAGInfo) << (settings.topK > 0 ? " best combinations" : (settings.sampleCount > 0 ? " sampled combinations" : " combinations"));
+            std::cout << (details.treeDAGInfo->loadedFromSolveCache ? " (from solve cache)" : "");
+            Engine::SolveCheckpoint* checkpoint = details.solveHandle->getCheckpoint();
+            std::cout << (checkpoint != nullptr && checkpoint->isResumed() ? " (resumed from checkpoint)" : "");
+            if (settings.shard.count > 1) {
+                std::cout << " (shard " << settings.shard.index + 1 << "/" << settings.shard.count << ")";
+            }
+            if (details.topBuilds.scores.size() > 0) {
+                std::cout << " (scores " << details.topBuilds.scores.front() << " to " << details.topBuilds.scores.back() << ")";
+            }
+            std::cout << (details.safetyGuardTriggered ? " (canceled)\n" : "\n");
+        }
+    }
 
-        //generate bit to talent index table
-        for (size_t i = 0; i < allRunDetails.size(); i++) {
+    /*
+    Prints one progress line per running solve to stderr (finished root subtrees, visited nodes, found combinations and the ETA).
+    Solves that didn't start yet or are already finished are skipped.
+    */
+    void printSolveProgress(std::vector<RunDetails>& allRunDetails) {
+        for (auto& details : allRunDetails) {
+            Engine::SolveHandle& handle = *details.solveHandle;
+            if (handle.isFinished() || handle.getTaskCount() == 0) {
+                continue;
+            }
+            std::cerr << details.tree.name << ":\t" << std::fixed << std::setprecision(1) << 100.0 * handle.getProgress() << "% ("
+                << handle.getFinishedTaskCount() << "/" << handle.getTaskCount() << " subtrees), "
+                << handle.getVisitedNodes() << " nodes, " << handle.getResultCount() << " combinations, ";
+            double secondsLeft = handle.getEstimatedSecondsLeft();
+            if (secondsLeft < 0.0) {
+                std::cerr << "ETA unknown\n";
+            }
+            else {
+                std::cerr << "ETA " << std::setprecision(0) << secondsLeft << "s\n";
+            }
+            std::cerr.unsetf(std::ios::floatfield);
+            std::cerr << std::setprecision(6);
+        }
+    }
 
-            std::map<int, int> expandedToCompactIndexMap;
-            for (auto& talent : allRunDetails[i].tree.orderedTalents) {
-                for (int j = 0; j < talent.second->maxPoints; j++) {
-                    //this indexing is taken from TalentTrees.cpp expand talent tree routine and represents an arbitrary indexing
-                    //for multipoint talents that doesn't collide for a use in a map
-                    //TTMNOTE: If this changes, also change TalentTrees.cpp->expandTalentAndAdvance and TreeSolver.cpp->filterSolvedSkillsets
-                    if (j == 0) {
-                        expandedToCompactIndexMap[talent.second->index] = talent.second->index;
-                    }
-                    else {
-                        expandedToCompactIndexMap[(talent.second->index + 1) * allRunDetails[i].tree.maxTalentPoints + (j - 1)] = talent.second->index;
-                    }
+    /*
+    Solves a single tree with the streaming solver, combinations are written to a partial output file right away (see outputCombinations)
+    and/or into a combination store or only counted if no output is generated. Text output always uses a single solver thread per tree
+    since multiple threads would push combinations in no particular order and the output should not depend on the scheduling
+    (combination stores are sorted anyway).
+    Full solves are checkpointed if a checkpoint interval is set, with resumeSolve they continue from the checkpoint of an interrupted run
+    and produce the same output.
+    Sharded solves only solve the task slots of their shard (see Engine::SolveShard) and mark every slot in the partial output file.
+    Count only runs don't enumerate anything and report the exact number of builds, which can exceed 64 bit for wide trees.
+    */
+    void solveTree(RunDetails& details, CLSettings& settings, size_t treeIndex, size_t treeCount, int threadCount) {
+        bool dummyProgress = true;
+        Engine::clearTree(details.tree);
+        std::vector<Engine::CombinationSink*> sinks;
+        std::ofstream partialOutFile;
+        std::unique_ptr<CombinationFileSink> fileSink;
+        std::unique_ptr<Engine::CombinationStoreSink> storeSink;
+        if (settings.generateOutput) {
+            partialOutFile.open(getPartialOutputFilePath(settings, treeIndex));
+            fileSink = std::make_unique<CombinationFileSink>(details, partialOutFile);
+            sinks.push_back(fileSink.get());
+            threadCount = 1;
+        }
+        if (settings.generateStore) {
+            storeSink = std::make_unique<Engine::CombinationStoreSink>(getStoreFilePath(settings, treeIndex, treeCount), details.tree, details.targetTalentCount, true);
+            sinks.push_back(storeSink.get());
+        }
+        Engine::CallbackCombinationSink countSink([](const Engine::SIND*, int) { return true; });
+        if (sinks.size() == 0) {
+            sinks.push_back(&countSink);
+        }
+        CombinationSinkGroup sink(sinks);
+        if (settings.topK > 0) {
+            Engine::countConfigurationsTopK(
+                details.tree,
+                details.filter,
+                details.targetTalentCount,
+                settings.talentScores,
+                settings.topK,
+                sink,
+                details.treeDAGInfo,
+                details.topBuilds,
+                dummyProgress
+            );
+            details.safetyGuardTriggered = details.treeDAGInfo->safetyGuardTriggered;
+            return;
+        }
+        if (settings.sampleCount > 0) {
+            //every tree gets its own seed so trees with the same structure don't get the same builds
+            try {
+                Engine::sampleConfigurations(
+                    details.tree,
+                    details.filter,
+                    details.targetTalentCount,
+                    settings.sampleCount,
+                    settings.sampleSeed + treeIndex,
+                    sink,
+                    details.treeDAGInfo,
+                    dummyProgress
+                );
+            }
+            catch (std::logic_error& e) {
+                details.error = e.what();
+                return;
+            }
+            details.safetyGuardTriggered = details.treeDAGInfo->safetyGuardTriggered;
+            return;
+        }
+        if (settings.countOnly) {
+            //the other solves only keep the builds with exactly the target talent count, so only that bucket is reported
+            Engine::countConfigurationsCountOnly(details.tree, details.targetTalentCount, details.treeDAGInfo, dummyProgress, details.safetyGuardTriggered);
+            Engine::TreeDAGInfo& treeDAG = *details.treeDAGInfo;
+            for (int i = 0; i < details.targetTalentCount - 1; i++) {
+                treeDAG.combinationCounts[i] = 0;
+                if (treeDAG.exactCombinationCounts.size() > 0) {
+                    treeDAG.exactCombinationCounts[i] = 0;
                 }
             }
+            treeDAG.allCombinationsSum = details.targetTalentCount > 0 ? treeDAG.combinationCounts[details.targetTalentCount - 1] : 0;
+            return;
+        }
+        if (settings.shard.count > 1) {
+            details.solveHandle->setShard(settings.shard);
+        }
+        if (settings.checkpointInterval > 0) {
+            details.solveHandle->setCheckpoint(std::make_shared<Engine::SolveCheckpoint>(
+                getCheckpointFilePath(settings, details, treeIndex, treeCount), settings.resumeSolve, settings.checkpointInterval));
+        }
+        Engine::countConfigurationsStreaming(
+            details.tree,
+            details.filter,
+            details.targetTalentCount,
+            true,
+            sink,
+            details.treeDAGInfo,
+            dummyProgress,
+            details.safetyGuardTriggered,
+            threadCount,
+            details.solveHandle,
+            details.filterExpression
+        );
+    }
 
-            // normally, TTM indices will already be in that order but since arbitrary
-            // unique indices are allowed we're gonna make sure to adhere to this ordering now
-            Engine::TalentVec resortedTalents;
-            resortedTalents.reserve(allRunDetails[i].treeDAGInfo->sortedTalents.size());
-            for (auto& talent : allRunDetails[i].treeDAGInfo->sortedTalents) {
-                resortedTalents.push_back(talent);
-            }
-            std::sort(resortedTalents.begin(), resortedTalents.end(),
-                [](const Engine::Talent_s& a, const Engine::Talent_s& b) -> bool
-                {
-                    if (a->row != b->row) {
-                        return a->row < b->row;
-                    }
-                    return a->column < b->column;
-                });
+    /*
+    Generates the bit to talent index table (positional talent index of every bit of a combination) and the switch talent bits.
+    */
+    void createBitToIndexTable(RunDetails& details, const Engine::TreeDAGInfo& treeDAG) {
+        Engine::CombinationStoreMetadata metadata = Engine::createCombinationStoreMetadata(details.tree, treeDAG, details.targetTalentCount, true);
+        details.bitToIndexVec = metadata.bitToIndexVec;
+        details.switchBitToIndexVec = metadata.switchBitToIndexVec;
+    }
 
-            std::map<int, int> compactToPositionalIndexMap;
-            int positionalIndex = 0;
-            for (int j = 0; j < static_cast<int>(resortedTalents.size()); j++) {
-                int compactIndex = expandedToCompactIndexMap[resortedTalents[j]->index];
-                if (!compactToPositionalIndexMap.count(compactIndex)) {
-                    compactToPositionalIndexMap[compactIndex] = positionalIndex++;
+    std::string getPartialOutputFilePath(CLSettings& settings, size_t treeIndex) {
+        return settings.outputFilePath + ".part" + std::to_string(treeIndex);
+    }
+
+    /*
+    Multiple trees write one combination store each, the tree index is appended to the store path.
+    */
+    std::string getStoreFilePath(CLSettings& settings, size_t treeIndex, size_t treeCount) {
+        if (treeCount == 1) {
+            return settings.storeFilePath;
+        }
+        return settings.storeFilePath + "." + std::to_string(treeIndex);
+    }
+
+    /*
+    Checkpoints are keyed on the solve (see Engine::getSolveCheckpointPath). Trees of a run with the same structure can be solved at the
+    same time (--parallel), so with multiple trees the tree index is appended to the checkpoint path as well. Shards of the same tree can
+    run on the same machine, so they get their own checkpoint files, too.
+    */
+    std::filesystem::path getCheckpointFilePath(CLSettings& settings, RunDetails& details, size_t treeIndex, size_t treeCount) {
+        std::string path = Engine::getSolveCheckpointPath(
+            details.tree, details.targetTalentCount, true, details.filter, details.filterExpression.get()).string();
+        if (treeCount > 1) {
+            path += "." + std::to_string(treeIndex);
+        }
+        if (settings.shard.count > 1) {
+            path += ".shard" + std::to_string(settings.shard.index + 1) + "of" + std::to_string(settings.shard.count);
+        }
+        return path;
+    }
+
+    CombinationSinkGroup::CombinationSinkGroup(std::vector<Engine::CombinationSink*> sinks)
+        : sinks(sinks) {
+    }
+
+    void CombinationSinkGroup::begin(const Engine::TreeDAGInfo& treeDAG) {
+        for (auto& sink : sinks) {
+            sink->begin(treeDAG);
+        }
+    }
+
+    void CombinationSinkGroup::beginTask(size_t task) {
+        for (auto& sink : sinks) {
+            sink->beginTask(task);
+        }
+    }
+
+    bool CombinationSinkGroup::push(Engine::CombinationBlock& block) {
+        bool proceed = true;
+        for (auto& sink : sinks) {
+            proceed &= sink->push(block);
+        }
+        return proceed;
+    }
+
+    void CombinationSinkGroup::finish() {
+        for (auto& sink : sinks) {
+            sink->finish();
+        }
+    }
+
+    CombinationFileSink::CombinationFileSink(RunDetails& details, std::ofstream& outFile)
+        : details(details), outFile(outFile) {
+    }
+
+    void CombinationFileSink::begin(const Engine::TreeDAGInfo& treeDAG) {
+        createBitToIndexTable(details, treeDAG);
+        indexWords = treeDAG.indexWords;
+        for (size_t i = 0; i < details.bitToIndexVec.size() - 1; i++) {
+            outFile << details.bitToIndexVec[i] << "/";
+        }
+        outFile << details.bitToIndexVec[details.bitToIndexVec.size() - 1] << "\n";
+    }
+
+    void CombinationFileSink::beginTask(size_t task) {
+        outFile << "#task " << task << "\n";
+    }
+
+    bool CombinationFileSink::push(Engine::CombinationBlock& block) {
+        for (size_t i = 0; i < block.combinations.size(); i += indexWords) {
+            const Engine::SIND* comb = &block.combinations[i];
+            outFile << Engine::skillsetIndexToString(comb, indexWords);
+            for (auto& bitIndexPair : details.switchBitToIndexVec) {
+                if (Engine::isTalentSelected(comb, bitIndexPair.first)) {
+                    outFile << "," << bitIndexPair.second;
                 }
             }
+            outFile << "\n";
+        }
+        return true;
+    }
 
-            std::vector<int> bitToIndexVec;
-            bitToIndexVec.reserve(allRunDetails[i].treeDAGInfo->sortedTalents.size());
-            for (auto& talent : allRunDetails[i].treeDAGInfo->sortedTalents) {
-                bitToIndexVec.push_back(compactToPositionalIndexMap[expandedToCompactIndexMap[talent->index]]);
+    /*
+    Combines the partial output files of all trees (in tree order) into the output file.
+    Sharded runs write a shard file instead: a "#shard i/N" line, then per tree a "#tree <name>" line, the partial output file (the
+    bit to index line and the combinations of every task slot of the shard behind a "#task <slot>" line) and an "#end" line.
+    */
+    void outputCombinations(std::vector<RunDetails>& allRunDetails, CLSettings& settings) {
+        if (!settings.generateOutput) {
+            return;
+        }
+        bool sharded = settings.shard.count > 1;
+        std::ofstream outFile{ settings.outputFilePath };
+        if (sharded) {
+            outFile << "#shard " << settings.shard.index + 1 << "/" << settings.shard.count << "\n";
+        }
+        for (size_t i = 0; i < allRunDetails.size(); i++) {
+            std::string partialOutputFilePath = getPartialOutputFilePath(settings, i);
+            if (sharded) {
+                outFile << "#tree " << allRunDetails[i].tree.name << "\n";
             }
+            {
+                std::ifstream partialOutFile{ partialOutputFilePath };
+                outFile << partialOutFile.rdbuf();
+            }
+            outFile << (sharded ? "#end\n" : "\n");
+            std::filesystem::remove(partialOutputFilePath);
+        }
+    }
 
-            allRunDetails[i].bitToIndexVec = bitToIndexVec;
+    ShardFileReader::ShardFileReader(const std::string& path)
+        : file(path) {
+        next();
+    }
+
+    bool ShardFileReader::isOpen() const {
+        return file.is_open();
+    }
 
-            std::vector<Engine::SIND> switchBits;
-            for (size_t bit = 0; bit < allRunDetails[i].treeDAGInfo->sortedTalents.size(); bit++) {
-                if (allRunDetails[i].treeDAGInfo->sortedTalents[bit]->type == Engine::TalentType::SWITCH) {
-                    switchBits.push_back(bit);
+    bool ShardFileReader::atEnd() const {
+        return end;
+    }
+
+    const std::string& ShardFileReader::peek() const {
+        return line;
+    }
+
+    std::string ShardFileReader::next() {
+        std::string current = std::move(line);
+        line.clear();
+        end = !std::getline(file, line);
+        return current;
+    }
+
+    /*
+    merge subcommand: combines the shard files of a sharded run (one file per shard, see outputCombinations) into the output file an
+    unsharded run would have written. Task slot t of a tree is in shard t % N, so the slots are copied round robin until the first
+    missing slot, which has to be the end of the tree in every shard file (otherwise a shard was canceled or is from another run).
+    */
+    void mergeShardFiles(CLSettings& settings) {
+        if (!settings.generateOutput || settings.shardFilePaths.size() == 0) {
+            std::cout << "Usage: merge <shard files> --output-file-path <path>\n";
+            return;
+        }
+        size_t shardCount = settings.shardFilePaths.size();
+        std::vector<std::unique_ptr<ShardFileReader>> readers(shardCount);
+        for (auto& path : settings.shardFilePaths) {
+            std::unique_ptr<ShardFileReader> reader = std::make_unique<ShardFileReader>(path);
+            std::string shardLine = reader->next();
+            size_t index = 0;
+            size_t count = 0;
+            if (shardLine.rfind("#shard ", 0) == 0) {
+                std::vector<std::string> shardParts = Engine::splitString(shardLine.substr(7), "/");
+                try {
+                    index = shardParts.size() == 2 ? std::stoull(shardParts[0]) : 0;
+                    count = shardParts.size() == 2 ? std::stoull(shardParts[1]) : 0;
+                }
+                catch (std::logic_error&) {
+                    count = 0;
                 }
             }
+            if (!reader->isOpen() || count != shardCount || index < 1 || index > count || readers[index - 1]) {
+                std::cout << path << " is not a shard file of this merge (expected " << shardCount << " different shards of one run).\n";
+                return;
+            }
+            readers[index - 1] = std::move(reader);
+        }
 
-
-            for (auto& comb : allRunDetails[i].treeDAGInfo->allCombinations[0]) {
-                std::vector<int> assignedSwitchIndices;
-                for (auto& bit : switchBits) {
-                    bool checkBit = (comb) & (1ULL << bit);
-                    if (checkBit) {
-                        assignedSwitchIndices.push_back(
-                            compactToPositionalIndexMap[expandedToCompactIndexMap[allRunDetails[i].treeDAGInfo->sortedTalents[bit]->index]]
-                        );
-                    }
+        std::ofstream outFile{ settings.outputFilePath };
+        size_t treeCount = 0;
+        size_t combinationCount = 0;
+        while (!readers[0]->atEnd()) {
+            std::string treeLine = readers[0]->peek();
+            std::string header;
+            for (size_t shard = 0; shard < shardCount; shard++) {
+                if (readers[shard]->next() != treeLine || treeLine.rfind("#tree ", 0) != 0) {
+                    std::cout << "Shard files don't contain the same trees.\n";
+                    return;
+                }
+                std::string shardHeader = readers[shard]->next();
+                if (shard > 0 && shardHeader != header) {
+                    std::cout << "Shard files were created from different tree structures (" << treeLine.substr(6) << ").\n";
+                    return;
+                }
+                header = shardHeader;
+            }
+            outFile << header << "\n";
+            for (size_t slot = 0; readers[slot % shardCount]->peek() != "#end"; slot++) {
+                ShardFileReader& reader = *readers[slot % shardCount];
+                if (reader.next() != "#task " + std::to_string(slot)) {
+                    std::cout << "Shard " << slot % shardCount + 1 << " is missing task " << slot << " of " << treeLine.substr(6) << ".\n";
+                    return;
                 }
-                allRunDetails[i].assignedSwitchIndices.push_back(assignedSwitchIndices);
+                while (!reader.atEnd() && reader.peek()[0] != '#') {
+                    outFile << reader.next() << "\n";
+                    combinationCount++;
+                }
+            }
+            for (size_t shard = 0; shard < shardCount; shard++) {
+                if (readers[shard]->next() != "#end") {
+                    std::cout << "Shard files end at different tasks of " << treeLine.substr(6) << ", a shard was canceled or failed.\n";
+                    return;
+                }
+            }
+            outFile << "\n";
+            treeCount++;
+        }
+        for (size_t shard = 1; shard < shardCount; shard++) {
+            if (!readers[shard]->atEnd()) {
+                std::cout << "Shard files don't contain the same trees.\n";
+                return;
             }
         }
+        std::cout << "Merged " << shardCount << " shards:\t" << treeCount << " trees, " << combinationCount << " combinations\n";
     }
 
-    void outputCombinations(std::vector<RunDetails>& allRunDetails, CLSettings& settings) {
-        if (!settings.generateOutput) {
+    /*
+    Reopens a combination store without solving the tree again, prints the combination count of every bucket and
+    writes the combinations into the output file in the same format as a regular solve (in sorted order).
+    */
+    void outputCombinationStore(CLSettings& settings) {
+        Engine::CombinationStoreReader reader(settings.openStoreFilePath);
+        const Engine::CombinationStoreMetadata& metadata = reader.getMetadata();
+        std::cout << "Combination store:\t" << settings.openStoreFilePath << "\n";
+        std::cout << "Talent points limit:\t" << metadata.talentPointsLimit << (metadata.onlyLimitSolve ? " (only limit)" : "") << "\n";
+        for (size_t bucket = 0; bucket < reader.getBucketCount(); bucket++) {
+            std::cout << reader.getBucketTalentPoints(bucket) << " talent points:\t" << reader.getCombinationCount(bucket) << " combinations\n";
+        }
+        std::cout << "Total:\t" << reader.getTotalCombinationCount() << " combinations";
+        std::cout << (metadata.safetyGuardTriggered ? " (canceled)\n" : "\n");
+        if (!settings.generateOutput || metadata.bitToIndexVec.size() == 0) {
             return;
         }
+
         std::ofstream outFile{ settings.outputFilePath };
-        for(RunDetails& details : allRunDetails){
-            for (size_t i = 0; i < details.bitToIndexVec.size() - 1; i++) {
-                outFile << details.bitToIndexVec[i] << "/";
-            }
-            outFile << details.bitToIndexVec[details.bitToIndexVec.size() - 1] << "\n";
-            for (size_t i = 0; i < details.treeDAGInfo->allCombinations[0].size(); i++) {
-                Engine::SIND& comb = details.treeDAGInfo->allCombinations[0][i];
-                outFile << comb;
-                for (int j = 0; j < static_cast<int>(details.assignedSwitchIndices[i].size()); j++) {
-                    outFile << "," << details.assignedSwitchIndices[i][j];
+        for (size_t i = 0; i < metadata.bitToIndexVec.size() - 1; i++) {
+            outFile << metadata.bitToIndexVec[i] << "/";
+        }
+        outFile << metadata.bitToIndexVec[metadata.bitToIndexVec.size() - 1] << "\n";
+        for (size_t bucket = 0; bucket < reader.getBucketCount(); bucket++) {
+            reader.forEachCombination(bucket, [&](const Engine::SIND* comb) {
+                outFile << Engine::skillsetIndexToString(comb, metadata.indexWords);
+                for (auto& bitIndexPair : metadata.switchBitToIndexVec) {
+                    if (Engine::isTalentSelected(comb, bitIndexPair.first)) {
+                        outFile << "," << bitIndexPair.second;
+                    }
                 }
                 outFile << "\n";
-            }
-            outFile << "\n";
+                return true;
+                });
         }
+        outFile << "\n";
     }
 }
-
@@ -1,8 +1,15 @@
 #pragma once
 
 #include <string>
+#include <fstream>
 #include "TalentTrees.h"
 #include "TreeSolver.h"
+#include "CombinationStore.h"
+#include "SolveCache.h"
+#include "CombinationRanker.h"
+#include "TopBuildSearch.h"
+#include "FilterExpression.h"
+#include "SolveCheckpoint.h"
 
 namespace CLI {
 	struct CLSettings {
@@ -14,8 +21,37 @@ namespace CLI {
 		std::string filterFilePath;
 		std::string rawFilter;
 		std::string outputFilePath;
+		bool generateStore = false;
+		std::string storeFilePath;
+		std::string openStoreFilePath;
 		int targetTalentCount = 1;
 		bool solveParallel = false;
+		bool useSolveCache = true;
+		//disk budget of the solve cache in MB, 0 keeps the default
+		std::uintmax_t solveCacheBudget = 0;
+		//memory budget of the solvers in bytes (combination stores spill to disk beyond it), 0 keeps the default
+		size_t memoryBudget = 0;
+		//seconds between progress lines on stderr, 0 disables them
+		int progressInterval = 5;
+		//seconds between checkpoints of a solve (see SolveCheckpoint), 0 disables them (default since every record holds the combinations
+		//found so far), resumeSolve continues from the last checkpoint and enables them with the default interval if none is given
+		int checkpointInterval = 0;
+		bool resumeSolve = false;
+		//--count-only counts the builds without enumerating them (exact counts, even beyond 64 bit)
+		bool countOnly = false;
+		//--shard i/N solves only one shard of every tree (see Engine::SolveShard), the output file is then a shard file for merge
+		Engine::SolveShard shard;
+		//merge subcommand: shard files that are combined into the output file
+		bool mergeShards = false;
+		std::vector<std::string> shardFilePaths;
+		//number of random builds per tree instead of a full solve, 0 solves the tree
+		size_t sampleCount = 0;
+		bool sampleSeedProvided = false;
+		std::uint64_t sampleSeed = 0;
+		//number of best builds per tree according to the talent scores instead of a full solve, 0 solves the tree
+		size_t topK = 0;
+		std::string scoresFilePath;
+		Engine::TalentScores talentScores;
 	};
 
 	struct RunDetails {
@@ -23,10 +59,68 @@ namespace CLI {
 		std::shared_ptr<Engine::TreeDAGInfo> treeDAGInfo;
 		int targetTalentCount = 1;
 		std::shared_ptr<Engine::TalentSkillset> filter;
+		//filters that start with "expr:" are filter expressions (see FilterExpression.h) instead of filter skillsets
+		std::shared_ptr<Engine::FilterExpression> filterExpression;
 		Engine::SIND excludeFilter = 0;
 		bool safetyGuardTriggered = false;
 		std::vector<int> bitToIndexVec;
-		std::vector<std::vector<int>> assignedSwitchIndices;
+		//bit of every switch talent and its positional index
+		std::vector<std::pair<int, int>> switchBitToIndexVec;
+		//only filled for top K searches
+		Engine::TopBuildResult topBuilds;
+		//reason the tree couldn't be solved (e.g. too many builds to sample), reported instead of the result
+		std::string error;
+		std::shared_ptr<Engine::SolveHandle> solveHandle;
+	};
+
+	/*
+	Writes the combinations of a streaming solve to the output file of a single tree (header line with the bit to index table
+	followed by one line per combination), so results never have to be held in memory.
+	*/
+	class CombinationFileSink : public Engine::CombinationSink {
+	public:
+		CombinationFileSink(RunDetails& details, std::ofstream& outFile);
+		void begin(const Engine::TreeDAGInfo& treeDAG) override;
+		void beginTask(size_t task) override;
+		bool push(Engine::CombinationBlock& block) override;
+
+	private:
+		RunDetails& details;
+		std::ofstream& outFile;
+		int indexWords = 1;
+	};
+
+	/*
+	Forwards every call to all sinks in order, sinks must not take the combinations of a block.
+	*/
+	class CombinationSinkGroup : public Engine::CombinationSink {
+	public:
+		explicit CombinationSinkGroup(std::vector<Engine::CombinationSink*> sinks);
+		void begin(const Engine::TreeDAGInfo& treeDAG) override;
+		void beginTask(size_t task) override;
+		bool push(Engine::CombinationBlock& block) override;
+		void finish() override;
+
+	private:
+		std::vector<Engine::CombinationSink*> sinks;
+	};
+
+	/*
+	Line reader of a shard file with one line lookahead, so merging can stop in front of the next marker line.
+	*/
+	class ShardFileReader {
+	public:
+		explicit ShardFileReader(const std::string& path);
+		bool isOpen() const;
+		bool atEnd() const;
+		//next line without consuming it (empty at the end of the file)
+		const std::string& peek() const;
+		std::string next();
+
+	private:
+		std::ifstream file;
+		std::string line;
+		bool end = false;
 	};
 
 	CLSettings processCommandLine(int argc, char** argv);
@@ -34,5 +128,13 @@ namespace CLI {
 	void printSettings(CLSettings settings);
 	std::vector<RunDetails> generateRunDetails(CLSettings settings);
 	void startThreadedCombinationCount(std::vector<RunDetails>& allRunDetails, CLSettings& settings);
+	void solveTree(RunDetails& details, CLSettings& settings, size_t treeIndex, size_t treeCount, int threadCount);
+	void printSolveProgress(std::vector<RunDetails>& allRunDetails);
+	void createBitToIndexTable(RunDetails& details, const Engine::TreeDAGInfo& treeDAG);
+	std::string getPartialOutputFilePath(CLSettings& settings, size_t treeIndex);
+	std::string getStoreFilePath(CLSettings& settings, size_t treeIndex, size_t treeCount);
+	std::filesystem::path getCheckpointFilePath(CLSettings& settings, RunDetails& details, size_t treeIndex, size_t treeCount);
+	void outputCombinationStore(CLSettings& settings);
 	void outputCombinations(std::vector<RunDetails>& allRunDetails, CLSettings& settings);
+	void mergeShardFiles(CLSettings& settings);
 }
\ No newline at end of file
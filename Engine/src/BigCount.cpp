@@ -0,0 +1,132 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "BigCount.h"
+
+#include <algorithm>
+
+namespace Engine {
+    BigCount::BigCount(std::uint64_t value) {
+        while (value > 0) {
+            limbs.push_back(static_cast<std::uint32_t>(value));
+            value >>= 32;
+        }
+    }
+
+    BigCount& BigCount::operator+=(const BigCount& other) {
+        if (limbs.size() < other.limbs.size()) {
+            limbs.resize(other.limbs.size(), 0);
+        }
+        std::uint64_t carry = 0;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            std::uint64_t sum = static_cast<std::uint64_t>(limbs[i]) + (i < other.limbs.size() ? other.limbs[i] : 0) + carry;
+            limbs[i] = static_cast<std::uint32_t>(sum);
+            carry = sum >> 32;
+            if (carry == 0 && i >= other.limbs.size()) {
+                break;
+            }
+        }
+        if (carry > 0) {
+            limbs.push_back(static_cast<std::uint32_t>(carry));
+        }
+        return *this;
+    }
+
+    BigCount BigCount::operator*(const BigCount& other) const {
+        BigCount result;
+        if (isZero() || other.isZero()) {
+            return result;
+        }
+        result.limbs.assign(limbs.size() + other.limbs.size(), 0);
+        for (size_t i = 0; i < limbs.size(); i++) {
+            std::uint64_t carry = 0;
+            for (size_t j = 0; j < other.limbs.size(); j++) {
+                //fits since (2^32 - 1)^2 + 2 * (2^32 - 1) = 2^64 - 1
+                std::uint64_t product = static_cast<std::uint64_t>(limbs[i]) * other.limbs[j] + result.limbs[i + j] + carry;
+                result.limbs[i + j] = static_cast<std::uint32_t>(product);
+                carry = product >> 32;
+            }
+            result.limbs[i + other.limbs.size()] = static_cast<std::uint32_t>(carry);
+        }
+        result.trim();
+        return result;
+    }
+
+    bool BigCount::operator==(const BigCount& other) const {
+        return limbs == other.limbs;
+    }
+
+    bool BigCount::operator!=(const BigCount& other) const {
+        return limbs != other.limbs;
+    }
+
+    bool BigCount::isZero() const {
+        return limbs.empty();
+    }
+
+    bool BigCount::fitsUInt64() const {
+        return limbs.size() <= 2;
+    }
+
+    std::uint64_t BigCount::toUInt64() const {
+        if (!fitsUInt64()) {
+            return UINT64_MAX;
+        }
+        std::uint64_t value = 0;
+        for (size_t i = limbs.size(); i > 0; i--) {
+            value = (value << 32) | limbs[i - 1];
+        }
+        return value;
+    }
+
+    /*
+    Decimal representation, the value is divided by 10^9 repeatedly and every remainder gives nine digits.
+    */
+    std::string BigCount::toString() const {
+        if (isZero()) {
+            return "0";
+        }
+        std::vector<std::uint32_t> quotient = limbs;
+        std::string digits;
+        while (quotient.size() > 0) {
+            std::uint64_t remainder = 0;
+            for (size_t i = quotient.size(); i > 0; i--) {
+                std::uint64_t current = (remainder << 32) | quotient[i - 1];
+                quotient[i - 1] = static_cast<std::uint32_t>(current / 1000000000);
+                remainder = current % 1000000000;
+            }
+            while (quotient.size() > 0 && quotient.back() == 0) {
+                quotient.pop_back();
+            }
+            for (int i = 0; i < 9 && (quotient.size() > 0 || remainder > 0); i++) {
+                digits.push_back(static_cast<char>('0' + remainder % 10));
+                remainder /= 10;
+            }
+        }
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    void BigCount::trim() {
+        while (limbs.size() > 0 && limbs.back() == 0) {
+            limbs.pop_back();
+        }
+    }
+}
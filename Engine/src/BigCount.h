@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace Engine {
+    /*
+    Unsigned integer of arbitrary size for build counts that don't fit into 64 bit (see countCombinationsDP). Only the operations the
+    count only solvers need are supported. Counts that fit are kept in the fixed width CombinationCount by the solvers, this type is
+    only used once a count overflowed.
+    */
+    class BigCount {
+    public:
+        BigCount() = default;
+        BigCount(std::uint64_t value);
+
+        BigCount& operator+=(const BigCount& other);
+        BigCount operator*(const BigCount& other) const;
+        bool operator==(const BigCount& other) const;
+        bool operator!=(const BigCount& other) const;
+
+        bool isZero() const;
+        bool fitsUInt64() const;
+        //saturates at UINT64_MAX if the value doesn't fit
+        std::uint64_t toUInt64() const;
+        std::string toString() const;
+
+    private:
+        void trim();
+
+        //32 bit limbs with the least significant one first and without leading zero limbs, zero has no limbs
+        std::vector<std::uint32_t> limbs;
+    };
+}
@@ -0,0 +1,411 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "CombinationBitmapIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace Engine {
+    static inline size_t countRows(SIND bits) {
+        return std::bitset<64>(bits).count();
+    }
+
+    static inline int lowestRowIndex(SIND bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    /*
+    Builds the containers of all buckets, chunks are distributed over threadCount threads (hardware concurrency if <= 0).
+    */
+    CombinationBitmapIndex::CombinationBitmapIndex(const TreeDAGInfo& treeDAG, int threadCount)
+        : talentCount(static_cast<int>(treeDAG.sortedTalents.size())), indexWords(treeDAG.indexWords) {
+        std::vector<std::pair<size_t, size_t>> tasks;
+        buckets.resize(treeDAG.allCombinations.size());
+        for (size_t b = 0; b < buckets.size(); b++) {
+            Bucket& bucket = buckets[b];
+            bucket.rowCount = treeDAG.allCombinations[b].size() / indexWords;
+            size_t chunkCount = (bucket.rowCount + BITMAP_INDEX_CHUNK_ROWS - 1) / BITMAP_INDEX_CHUNK_ROWS;
+            bucket.chunks.resize(chunkCount);
+            for (size_t c = 0; c < chunkCount; c++) {
+                bucket.chunks[c].firstRow = c * BITMAP_INDEX_CHUNK_ROWS;
+                bucket.chunks[c].rowCount = std::min(BITMAP_INDEX_CHUNK_ROWS, bucket.rowCount - c * BITMAP_INDEX_CHUNK_ROWS);
+                tasks.push_back({ b, c });
+            }
+        }
+
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        }
+        threadCount = std::max(1, std::min(threadCount, static_cast<int>(tasks.size())));
+        std::atomic<size_t> nextTask = 0;
+        auto worker = [&]() {
+            std::vector<SIND> denseBits(static_cast<size_t>(talentCount) * BITMAP_INDEX_CHUNK_WORDS);
+            size_t task;
+            while ((task = nextTask.fetch_add(1)) < tasks.size()) {
+                buildChunk(treeDAG.allCombinations[tasks[task].first], buckets[tasks[task].first].chunks[tasks[task].second], denseBits);
+            }
+        };
+        if (threadCount <= 1) {
+            worker();
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    /*
+    Sets the row bits of every talent in a dense bitmap per talent first and converts them into array or bitmap containers afterwards.
+    */
+    void CombinationBitmapIndex::buildChunk(const std::vector<SIND>& combinations, Chunk& chunk, std::vector<SIND>& denseBits) const {
+        std::fill(denseBits.begin(), denseBits.end(), 0);
+        for (size_t row = 0; row < chunk.rowCount; row++) {
+            const SIND* skillsetIndex = &combinations[(chunk.firstRow + row) * indexWords];
+            SIND rowBit = 1ULL << (row & 63);
+            size_t rowWord = row >> 6;
+            for (int w = 0; w < indexWords; w++) {
+                SIND talents = skillsetIndex[w];
+                while (talents != 0) {
+                    int bit = w * 64 + lowestRowIndex(talents);
+                    denseBits[bit * BITMAP_INDEX_CHUNK_WORDS + rowWord] |= rowBit;
+                    talents &= talents - 1;
+                }
+            }
+        }
+
+        chunk.talents.resize(talentCount);
+        for (int bit = 0; bit < talentCount; bit++) {
+            const SIND* bits = &denseBits[bit * BITMAP_INDEX_CHUNK_WORDS];
+            Container& container = chunk.talents[bit];
+            container.cardinality = 0;
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                container.cardinality += countRows(bits[w]);
+            }
+            if (container.cardinality == 0) {
+                continue;
+            }
+            if (container.cardinality <= BITMAP_INDEX_ARRAY_LIMIT) {
+                container.rows.reserve(container.cardinality);
+                for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                    SIND word = bits[w];
+                    while (word != 0) {
+                        container.rows.push_back(static_cast<std::uint16_t>(w * 64 + lowestRowIndex(word)));
+                        word &= word - 1;
+                    }
+                }
+            }
+            else {
+                container.bits.assign(bits, bits + BITMAP_INDEX_CHUNK_WORDS);
+            }
+        }
+    }
+
+    void CombinationBitmapIndex::andContainer(SIND* bits, const Container& container) {
+        if (container.bits.size() > 0) {
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                bits[w] &= container.bits[w];
+            }
+            return;
+        }
+        //sparse container: collect the row mask of every word and keep only those rows
+        size_t pos = 0;
+        for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+            SIND mask = 0;
+            while (pos < container.rows.size() && (container.rows[pos] >> 6) == w) {
+                mask |= 1ULL << (container.rows[pos] & 63);
+                pos++;
+            }
+            bits[w] &= mask;
+        }
+    }
+
+    void CombinationBitmapIndex::andNotContainer(SIND* bits, const Container& container) {
+        if (container.bits.size() > 0) {
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                bits[w] &= ~container.bits[w];
+            }
+            return;
+        }
+        for (std::uint16_t row : container.rows) {
+            bits[row >> 6] &= ~(1ULL << (row & 63));
+        }
+    }
+
+    void CombinationBitmapIndex::orContainer(SIND* bits, const Container& container) {
+        if (container.bits.size() > 0) {
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                bits[w] |= container.bits[w];
+            }
+            return;
+        }
+        for (std::uint16_t row : container.rows) {
+            bits[row >> 6] |= 1ULL << (row & 63);
+        }
+    }
+
+    /*
+    Result bitmap and 4 scratch bitmaps for evaluateChunk.
+    */
+    std::vector<SIND> CombinationBitmapIndex::createQueryBuffer() {
+        return std::vector<SIND>(5 * BITMAP_INDEX_CHUNK_WORDS);
+    }
+
+    /*
+    Evaluates the filter for all rows of a chunk, result holds the bitmap of the matching rows afterwards
+    (same semantics as checkSkillsetFilter, scratch needs room for 4 chunk bitmaps).
+    */
+    void CombinationBitmapIndex::evaluateChunk(const Chunk& chunk, const CombinationFilterBits& filter, SIND* result, SIND* scratch) const {
+        SIND* rowMask = scratch;
+        std::memset(rowMask, 0, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+        for (size_t w = 0; w < chunk.rowCount / 64; w++) {
+            rowMask[w] = ~0ULL;
+        }
+        if (chunk.rowCount % 64 != 0) {
+            rowMask[chunk.rowCount / 64] = (1ULL << (chunk.rowCount % 64)) - 1;
+        }
+        std::memcpy(result, rowMask, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+
+        for (int bit : filter.includeBits) {
+            andContainer(result, chunk.talents[bit]);
+        }
+        for (int bit : filter.excludeBits) {
+            andNotContainer(result, chunk.talents[bit]);
+        }
+        if (filter.orBits.size() > 0) {
+            SIND* orRows = scratch + BITMAP_INDEX_CHUNK_WORDS;
+            std::memset(orRows, 0, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+            for (int bit : filter.orBits) {
+                orContainer(orRows, chunk.talents[bit]);
+            }
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                result[w] &= orRows[w];
+            }
+        }
+        if (filter.oneBits.size() > 0) {
+            //rows that match at least one group and rows that match at least two groups
+            SIND* once = scratch + BITMAP_INDEX_CHUNK_WORDS;
+            SIND* twice = scratch + 2 * BITMAP_INDEX_CHUNK_WORDS;
+            SIND* group = scratch + 3 * BITMAP_INDEX_CHUNK_WORDS;
+            std::memset(once, 0, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+            std::memset(twice, 0, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+            for (auto& groupBits : filter.oneBits) {
+                std::memcpy(group, rowMask, sizeof(SIND) * BITMAP_INDEX_CHUNK_WORDS);
+                for (int bit : groupBits.first) {
+                    andContainer(group, chunk.talents[bit]);
+                }
+                for (int bit : groupBits.second) {
+                    andNotContainer(group, chunk.talents[bit]);
+                }
+                for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                    twice[w] |= once[w] & group[w];
+                    once[w] |= group[w];
+                }
+            }
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                result[w] &= once[w] & ~twice[w];
+            }
+        }
+    }
+
+    size_t CombinationBitmapIndex::getBucketCount() const {
+        return buckets.size();
+    }
+
+    size_t CombinationBitmapIndex::getRowCount(size_t bucket) const {
+        return buckets.at(bucket).rowCount;
+    }
+
+    /*
+    Number of combinations of a bucket that contain the talent bit.
+    */
+    size_t CombinationBitmapIndex::getTalentRowCount(size_t bucket, int bit) const {
+        size_t count = 0;
+        for (auto& chunk : buckets.at(bucket).chunks) {
+            count += chunk.talents[bit].cardinality;
+        }
+        return count;
+    }
+
+    size_t CombinationBitmapIndex::getMemoryUsage() const {
+        size_t memory = 0;
+        for (auto& bucket : buckets) {
+            for (auto& chunk : bucket.chunks) {
+                for (auto& container : chunk.talents) {
+                    memory += sizeof(Container) + container.rows.capacity() * sizeof(std::uint16_t) + container.bits.capacity() * sizeof(SIND);
+                }
+            }
+        }
+        return memory;
+    }
+
+    size_t CombinationBitmapIndex::countFiltered(size_t bucket, const CombinationFilterBits& filter) const {
+        const Bucket& entry = buckets.at(bucket);
+        if (filter.isEmpty()) {
+            return entry.rowCount;
+        }
+        std::vector<SIND> buffer = createQueryBuffer();
+        size_t count = 0;
+        for (auto& chunk : entry.chunks) {
+            evaluateChunk(chunk, filter, buffer.data(), buffer.data() + BITMAP_INDEX_CHUNK_WORDS);
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                count += countRows(buffer[w]);
+            }
+        }
+        return count;
+    }
+
+    /*
+    Appends the (sorted) row indices of all combinations of a bucket that pass the filter to rows.
+    */
+    void CombinationBitmapIndex::getFilteredRows(size_t bucket, const CombinationFilterBits& filter, std::vector<size_t>& rows) const {
+        const Bucket& entry = buckets.at(bucket);
+        std::vector<SIND> buffer = createQueryBuffer();
+        for (auto& chunk : entry.chunks) {
+            evaluateChunk(chunk, filter, buffer.data(), buffer.data() + BITMAP_INDEX_CHUNK_WORDS);
+            for (size_t w = 0; w < BITMAP_INDEX_CHUNK_WORDS; w++) {
+                SIND word = buffer[w];
+                while (word != 0) {
+                    rows.push_back(chunk.firstRow + w * 64 + lowestRowIndex(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+
+    static void appendMaskBits(const SIND* words, int indexWords, int talentCount, std::vector<int>& bits) {
+        for (int bit = 0; bit < talentCount && bit < indexWords * 64; bit++) {
+            if ((words[bit >> 6] >> (bit & 63)) & 1ULL) {
+                bits.push_back(bit);
+            }
+        }
+    }
+
+    template<typename IndexType>
+    static CombinationFilterBits createCombinationFilterBitsImpl(const TalentTree& tree, const TreeDAGInfo& treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        BasicSkillsetFilterMasks<IndexType> masks = createSkillsetFilterMasks<IndexType>(tree, treeDAG, filter);
+        const int indexWords = SkillsetIndexTraits<IndexType>::words;
+        const int talentCount = static_cast<int>(treeDAG.sortedTalents.size());
+        CombinationFilterBits filterBits;
+        appendMaskBits(getMaskWords(masks.includeFilter), indexWords, talentCount, filterBits.includeBits);
+        appendMaskBits(getMaskWords(masks.excludeFilter), indexWords, talentCount, filterBits.excludeBits);
+        appendMaskBits(getMaskWords(masks.orFilter), indexWords, talentCount, filterBits.orBits);
+        for (auto& filterPair : masks.oneFilter) {
+            std::pair<std::vector<int>, std::vector<int>> groupBits;
+            appendMaskBits(getMaskWords(filterPair.first), indexWords, talentCount, groupBits.first);
+            appendMaskBits(getMaskWords(filterPair.second), indexWords, talentCount, groupBits.second);
+            filterBits.oneBits.push_back(groupBits);
+        }
+        return filterBits;
+    }
+
+    /*
+    Converts a filter skillset into filter bits (see createSkillsetFilterMasks).
+    */
+    CombinationFilterBits createCombinationFilterBits(const TalentTree& tree, const TreeDAGInfo& treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        switch (treeDAG.indexWords) {
+        case 1: return createCombinationFilterBitsImpl<SIND>(tree, treeDAG, filter);
+        case 2: return createCombinationFilterBitsImpl<SIND128>(tree, treeDAG, filter);
+        case 4: return createCombinationFilterBitsImpl<SIND256>(tree, treeDAG, filter);
+        default: throw std::logic_error("Unsupported skillset index width");
+        }
+    }
+
+    /*
+    Creates the bitmap index of a solved tree (skipped if the solve has more than BITMAP_INDEX_COMBINATION_LIMIT combinations). The
+    index is published atomically, so it can be created on a background thread while the tree DAG is filtered and counted.
+    */
+    void createCombinationBitmapIndex(std::shared_ptr<TreeDAGInfo> treeDAG, int threadCount) {
+        size_t combinationCount = 0;
+        for (auto& combinations : treeDAG->allCombinations) {
+            combinationCount += combinations.size() / treeDAG->indexWords;
+        }
+        if (combinationCount > BITMAP_INDEX_COMBINATION_LIMIT) {
+            return;
+        }
+        std::atomic_store(&treeDAG->bitmapIndex, std::make_shared<const CombinationBitmapIndex>(*treeDAG, threadCount));
+    }
+
+    /*
+    Counts the combinations of every talent point bucket that pass the filter without materializing them, uses the bitmap index
+    if the tree has one and scans allCombinations otherwise.
+    */
+    std::vector<size_t> countFilteredSkillsets(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        CombinationFilterBits filterBits = createCombinationFilterBits(tree, *treeDAG, filter);
+        std::vector<size_t> counts(treeDAG->allCombinations.size(), 0);
+        std::shared_ptr<const CombinationBitmapIndex> bitmapIndex = std::atomic_load(&treeDAG->bitmapIndex);
+        if (bitmapIndex) {
+            for (size_t b = 0; b < counts.size(); b++) {
+                counts[b] = bitmapIndex->countFiltered(b, filterBits);
+            }
+            return counts;
+        }
+        for (size_t b = 0; b < counts.size(); b++) {
+            const std::vector<SIND>& combinations = treeDAG->allCombinations[b];
+            for (size_t i = 0; i < combinations.size(); i += treeDAG->indexWords) {
+                const SIND* skillsetIndex = &combinations[i];
+                bool valid = true;
+                for (int bit : filterBits.includeBits) {
+                    valid &= isTalentSelected(skillsetIndex, bit);
+                }
+                for (int bit : filterBits.excludeBits) {
+                    valid &= !isTalentSelected(skillsetIndex, bit);
+                }
+                if (filterBits.orBits.size() > 0) {
+                    bool anySelected = false;
+                    for (int bit : filterBits.orBits) {
+                        anySelected |= isTalentSelected(skillsetIndex, bit);
+                    }
+                    valid &= anySelected;
+                }
+                if (filterBits.oneBits.size() > 0) {
+                    int matches = 0;
+                    for (auto& groupBits : filterBits.oneBits) {
+                        bool match = true;
+                        for (int bit : groupBits.first) {
+                            match &= isTalentSelected(skillsetIndex, bit);
+                        }
+                        for (int bit : groupBits.second) {
+                            match &= !isTalentSelected(skillsetIndex, bit);
+                        }
+                        matches += match ? 1 : 0;
+                    }
+                    valid &= matches == 1;
+                }
+                counts[b] += valid ? 1 : 0;
+            }
+        }
+        return counts;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//rows of a bucket are split into chunks of this many rows, every talent has one container per chunk (roaring bitmap layout)
+constexpr size_t BITMAP_INDEX_CHUNK_ROWS = 65536;
+constexpr size_t BITMAP_INDEX_CHUNK_WORDS = BITMAP_INDEX_CHUNK_ROWS / 64;
+//containers with at most this many rows are stored as sorted row arrays, denser ones as bitmaps
+constexpr size_t BITMAP_INDEX_ARRAY_LIMIT = 4096;
+//solves with more combinations than this don't get a bitmap index since it needs roughly as much memory as the combinations itself
+constexpr size_t BITMAP_INDEX_COMBINATION_LIMIT = 200000000;
+
+namespace Engine {
+    /*
+    Column oriented index over the solved combinations of a TreeDAGInfo: for every talent bit and talent point bucket a compressed
+    bitmap of the combination rows (index into allCombinations[bucket]) that contain the talent. Filter queries are evaluated as
+    bitmap AND/OR/ANDNOT operations per chunk and counted with popcounts instead of scanning all combinations.
+    */
+    class CombinationBitmapIndex {
+    public:
+        CombinationBitmapIndex(const TreeDAGInfo& treeDAG, int threadCount = 0);
+
+        size_t getBucketCount() const;
+        size_t getRowCount(size_t bucket) const;
+        size_t getTalentRowCount(size_t bucket, int bit) const;
+        size_t getMemoryUsage() const;
+
+        size_t countFiltered(size_t bucket, const CombinationFilterBits& filter) const;
+        void getFilteredRows(size_t bucket, const CombinationFilterBits& filter, std::vector<size_t>& rows) const;
+
+    private:
+        struct Container {
+            size_t cardinality = 0;
+            //sorted rows (relative to the chunk) for sparse containers, bits is empty then
+            std::vector<std::uint16_t> rows;
+            std::vector<SIND> bits;
+        };
+        struct Chunk {
+            size_t firstRow = 0;
+            size_t rowCount = 0;
+            std::vector<Container> talents;
+        };
+        struct Bucket {
+            size_t rowCount = 0;
+            std::vector<Chunk> chunks;
+        };
+
+        void buildChunk(const std::vector<SIND>& combinations, Chunk& chunk, std::vector<SIND>& denseBits) const;
+        void evaluateChunk(const Chunk& chunk, const CombinationFilterBits& filter, SIND* result, SIND* scratch) const;
+        static void andContainer(SIND* bits, const Container& container);
+        static void andNotContainer(SIND* bits, const Container& container);
+        static void orContainer(SIND* bits, const Container& container);
+        static std::vector<SIND> createQueryBuffer();
+
+        int talentCount = 0;
+        int indexWords = 1;
+        std::vector<Bucket> buckets;
+    };
+
+    CombinationFilterBits createCombinationFilterBits(const TalentTree& tree, const TreeDAGInfo& treeDAG, std::shared_ptr<TalentSkillset> filter);
+    void createCombinationBitmapIndex(std::shared_ptr<TreeDAGInfo> treeDAG, int threadCount = 0);
+    std::vector<size_t> countFilteredSkillsets(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter);
+}
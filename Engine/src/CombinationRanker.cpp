@@ -0,0 +1,821 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "CombinationRanker.h"
+#include "CombinationBitmapIndex.h"
+#include "CombinationStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Engine {
+    static inline int lowestTalentBit(SIND bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    struct CombinationRanker::PathCounts {
+        virtual ~PathCounts() = default;
+        virtual CombinationCount getCombinationCount() const = 0;
+        virtual size_t getStateCount() const = 0;
+        virtual bool hasOverflow() const = 0;
+        virtual CombinationCount rank(const SIND* skillsetIndex) const = 0;
+        virtual void unrank(CombinationCount index, SIND* skillsetIndex) const = 0;
+        virtual void countTalentInclusions(int forcedTalent, std::vector<CombinationCount>& inclusionCounts) const = 0;
+    };
+
+    /*
+    Path counts of one skillset index width, the state table holds the number of completions of every state (see createTreeStateTable).
+    Included talents can't be skipped and excluded talents can't be taken. Counts saturate at UINT64_MAX and set overflow.
+    */
+    template<typename IndexType>
+    struct BasicPathCounts : CombinationRanker::PathCounts {
+        int talentPoints = 0;
+        bool overflow = false;
+        BasicTreeStateTable<IndexType, CombinationCount> table;
+
+        BasicPathCounts(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const CombinationFilterBits& filter)
+            : talentPoints(talentPoints),
+            table(createTreeStateTable<IndexType, CombinationCount>(sortedTreeDAG, talentPoints, filter.includeBits, filter.excludeBits, 0, 1,
+                [this](size_t, CombinationCount skipCount, CombinationCount takeCount) {
+                    if (skipCount > UINT64_MAX - takeCount) {
+                        overflow = true;
+                        return UINT64_MAX;
+                    }
+                    return skipCount + takeCount;
+                })) {
+        }
+
+        CombinationCount getCount(size_t level, const IndexType& mask, int talentPointsSpent) const {
+            return table.getValue(level, mask, talentPointsSpent);
+        }
+
+        CombinationCount getCombinationCount() const override {
+            return getCount(0, table.masks.rootMask, 0);
+        }
+
+        size_t getStateCount() const override {
+            return table.getStateCount();
+        }
+
+        bool hasOverflow() const override {
+            return overflow;
+        }
+
+        CombinationCount rank(const SIND* skillsetIndex) const override {
+            IndexType mask = table.masks.rootMask;
+            int talentPointsSpent = 0;
+            CombinationCount index = 0;
+            for (size_t i = 0; i < table.levels.size(); i++) {
+                IndexType skipMask = table.getSkipMask(i, mask);
+                bool skippable = table.isSkippable(i);
+                if (!isTalentSelected(skillsetIndex, static_cast<int>(i))) {
+                    if (!skippable) {
+                        throw std::logic_error("Skillset index does not pass the filter of the ranker");
+                    }
+                    mask = skipMask;
+                    continue;
+                }
+                if (!isTalentSelected(getMaskWords(mask), static_cast<int>(i)) || talentPointsSpent < table.pointsRequired[i] || talentPointsSpent >= talentPoints) {
+                    throw std::logic_error("Skillset index is not a valid build of this tree");
+                }
+                if (!table.isTakeable(i, mask, talentPointsSpent)) {
+                    throw std::logic_error("Skillset index does not pass the filter of the ranker");
+                }
+                //every build that skips this talent comes first
+                index += skippable ? getCount(i + 1, skipMask, talentPointsSpent) : 0;
+                mask = table.getTakeMask(i, mask);
+                talentPointsSpent++;
+            }
+            if (talentPointsSpent != talentPoints) {
+                throw std::logic_error("Skillset index has the wrong amount of talent points");
+            }
+            return index;
+        }
+
+        void unrank(CombinationCount index, SIND* skillsetIndex) const override {
+            if (index >= getCombinationCount()) {
+                throw std::logic_error("Combination index out of range");
+            }
+            for (int w = 0; w < SkillsetIndexTraits<IndexType>::words; w++) {
+                skillsetIndex[w] = 0;
+            }
+            IndexType mask = table.masks.rootMask;
+            int talentPointsSpent = 0;
+            for (size_t i = 0; i < table.levels.size(); i++) {
+                IndexType skipMask = table.getSkipMask(i, mask);
+                CombinationCount skipCount = table.isSkippable(i) ? getCount(i + 1, skipMask, talentPointsSpent) : 0;
+                if (index < skipCount) {
+                    mask = skipMask;
+                    continue;
+                }
+                index -= skipCount;
+                skillsetIndex[i >> 6] |= 1ULL << (i & 63);
+                mask = table.getTakeMask(i, mask);
+                talentPointsSpent++;
+            }
+        }
+
+        //counts the builds that contain each talent, only builds that contain forcedTalent are counted if it is >= 0 (talents before it
+        //are counted as if there was no condition then since the builds that skip them can still take forcedTalent later)
+        void countTalentInclusions(int forcedTalent, std::vector<CombinationCount>& inclusionCounts) const override {
+            inclusionCounts.assign(table.levels.size(), 0);
+            if (getCombinationCount() == 0) {
+                return;
+            }
+            //number of ways to reach every state from the root, states without any completion are dropped right away, so a talent
+            //is contained in (ways to reach the state) * (completions after taking it) builds
+            std::unordered_map<IndexType, std::vector<CombinationCount>, SkillsetIndexHash> states;
+            states[table.masks.rootMask] = std::vector<CombinationCount>(talentPoints + 1, 0);
+            states[table.masks.rootMask][0] = 1;
+            for (size_t i = 0; i < table.levels.size(); i++) {
+                std::unordered_map<IndexType, std::vector<CombinationCount>, SkillsetIndexHash> nextStates;
+                nextStates.reserve(2 * states.size());
+                bool skippable = table.isSkippable(i) && static_cast<int>(i) != forcedTalent;
+                for (auto& maskCountsPair : states) {
+                    const IndexType& mask = maskCountsPair.first;
+                    const std::vector<CombinationCount>& counts = maskCountsPair.second;
+                    IndexType skipMask = table.getSkipMask(i, mask);
+                    IndexType takeMask = table.getTakeMask(i, mask);
+                    for (int s = 0; s <= talentPoints; s++) {
+                        if (counts[s] == 0) {
+                            continue;
+                        }
+                        if (skippable && getCount(i + 1, skipMask, s) > 0) {
+                            std::vector<CombinationCount>& skipCounts = nextStates[skipMask];
+                            if (skipCounts.size() == 0) {
+                                skipCounts.resize(talentPoints + 1, 0);
+                            }
+                            skipCounts[s] += counts[s];
+                        }
+                        if (!table.isTakeable(i, mask, s)) {
+                            continue;
+                        }
+                        CombinationCount completions = getCount(i + 1, takeMask, s + 1);
+                        if (completions == 0) {
+                            continue;
+                        }
+                        inclusionCounts[i] += counts[s] * completions;
+                        std::vector<CombinationCount>& takeCounts = nextStates[takeMask];
+                        if (takeCounts.size() == 0) {
+                            takeCounts.resize(talentPoints + 1, 0);
+                        }
+                        takeCounts[s + 1] += counts[s];
+                    }
+                }
+                states = std::move(nextStates);
+            }
+        }
+    };
+
+    CombinationRanker::CombinationRanker(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const CombinationFilterBits& filter)
+        : talentPoints(talentPoints), indexWords(getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size())) {
+        if (talentPoints <= 0) {
+            throw std::logic_error("Combination ranker needs at least one talent point");
+        }
+        dispatchSkillsetIndexType(indexWords, [&](auto indexTag) {
+            pathCounts = std::make_unique<BasicPathCounts<decltype(indexTag)>>(sortedTreeDAG, talentPoints, filter);
+        });
+    }
+
+    CombinationRanker::~CombinationRanker() = default;
+
+    int CombinationRanker::getTalentPoints() const {
+        return talentPoints;
+    }
+
+    int CombinationRanker::getIndexWords() const {
+        return indexWords;
+    }
+
+    CombinationCount CombinationRanker::getCombinationCount() const {
+        return pathCounts->getCombinationCount();
+    }
+
+    size_t CombinationRanker::getStateCount() const {
+        return pathCounts->getStateCount();
+    }
+
+    bool CombinationRanker::hasOverflow() const {
+        return pathCounts->hasOverflow();
+    }
+
+    CombinationCount CombinationRanker::rank(const SIND* skillsetIndex) const {
+        return pathCounts->rank(skillsetIndex);
+    }
+
+    void CombinationRanker::unrank(CombinationCount index, SIND* skillsetIndex) const {
+        pathCounts->unrank(index, skillsetIndex);
+    }
+
+    void CombinationRanker::unrankRange(CombinationCount first, size_t count, std::vector<SIND>& combinations) const {
+        CombinationCount combinationCount = getCombinationCount();
+        if (first >= combinationCount) {
+            return;
+        }
+        if (count > combinationCount - first) {
+            count = static_cast<size_t>(combinationCount - first);
+        }
+        size_t offset = combinations.size();
+        combinations.resize(offset + count * indexWords);
+        for (size_t i = 0; i < count; i++) {
+            pathCounts->unrank(first + i, &combinations[offset + i * indexWords]);
+        }
+    }
+
+    std::vector<CombinationCount> CombinationRanker::getTalentInclusionCounts() const {
+        std::vector<CombinationCount> inclusionCounts;
+        pathCounts->countTalentInclusions(-1, inclusionCounts);
+        return inclusionCounts;
+    }
+
+    std::vector<CombinationCount> CombinationRanker::getTalentPairCounts() const {
+        std::vector<CombinationCount> inclusionCounts;
+        pathCounts->countTalentInclusions(-1, inclusionCounts);
+        size_t talentCount = inclusionCounts.size();
+        std::vector<CombinationCount> pairCounts(talentCount * talentCount, 0);
+        std::vector<CombinationCount> conditionedCounts;
+        for (size_t i = 0; i < talentCount; i++) {
+            if (inclusionCounts[i] == 0) {
+                continue;
+            }
+            pathCounts->countTalentInclusions(static_cast<int>(i), conditionedCounts);
+            for (size_t j = i + 1; j < talentCount; j++) {
+                pairCounts[i * talentCount + j] = conditionedCounts[j];
+            }
+        }
+        return pairCounts;
+    }
+
+    CombinationSampler::CombinationSampler(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const CombinationFilterBits& filter, std::uint64_t seed)
+        : ranker(sortedTreeDAG, talentPoints, filter), filter(filter), rng(seed) {
+        if (ranker.hasOverflow()) {
+            throw std::logic_error("Tree has too many builds with " + std::to_string(talentPoints) + " talent points to sample them uniformly");
+        }
+        needsRejection = filter.orBits.size() > 0 || filter.oneBits.size() > 0;
+    }
+
+    int CombinationSampler::getIndexWords() const {
+        return ranker.getIndexWords();
+    }
+
+    CombinationCount CombinationSampler::getCandidateCount() const {
+        return ranker.getCombinationCount();
+    }
+
+    size_t CombinationSampler::sample(size_t count, std::vector<SIND>& combinations) {
+        CombinationCount candidateCount = ranker.getCombinationCount();
+        if (candidateCount == 0 || count == 0) {
+            return 0;
+        }
+        int indexWords = ranker.getIndexWords();
+        std::vector<CombinationCount> indices;
+        if (!needsRejection) {
+            //Floyd's algorithm draws a uniformly random subset without retrying duplicates, the shuffle randomizes its order
+            if (count > candidateCount) {
+                count = static_cast<size_t>(candidateCount);
+            }
+            std::unordered_set<CombinationCount> selected;
+            selected.reserve(count);
+            for (CombinationCount j = candidateCount - count; j < candidateCount; j++) {
+                CombinationCount index = std::uniform_int_distribution<CombinationCount>(0, j)(rng);
+                index = selected.insert(index).second ? index : j;
+                selected.insert(index);
+                indices.push_back(index);
+            }
+            std::shuffle(indices.begin(), indices.end(), rng);
+            size_t offset = combinations.size();
+            combinations.resize(offset + indices.size() * indexWords);
+            for (size_t i = 0; i < indices.size(); i++) {
+                ranker.unrank(indices[i], &combinations[offset + i * indexWords]);
+            }
+            return indices.size();
+        }
+
+        std::uniform_int_distribution<CombinationCount> distribution(0, candidateCount - 1);
+        std::unordered_set<CombinationCount> drawn;
+        std::vector<SIND> skillsetIndex(indexWords);
+        size_t sampled = 0;
+        size_t attempts = count * SAMPLER_ATTEMPTS_PER_SAMPLE;
+        for (size_t attempt = 0; attempt < attempts && sampled < count && drawn.size() < candidateCount; attempt++) {
+            CombinationCount index = distribution(rng);
+            if (!drawn.insert(index).second) {
+                continue;
+            }
+            ranker.unrank(index, skillsetIndex.data());
+            if (!filter.matches(skillsetIndex.data())) {
+                continue;
+            }
+            combinations.insert(combinations.end(), skillsetIndex.begin(), skillsetIndex.end());
+            sampled++;
+        }
+        return sampled;
+    }
+
+    /*
+    Sampling counterpart of countConfigurationsStreaming: creates the sorted DAG of the tree and pushes sampleCount uniformly random
+    valid builds with exactly talentPoints talent points that pass the filter to the sink (in blocks like a streaming solve).
+    The same seed always yields the same builds for the same tree and filter.
+    */
+    void sampleConfigurations(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPoints,
+        size_t sampleCount,
+        std::uint64_t seed,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress) {
+
+        inProgress = true;
+        std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
+        tree.unspentTalentPoints = talentPoints;
+        //expand notes in tree
+        expandTreeTalents(*processedTree);
+
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        setSafetyGuard(sortedTreeDAG);
+        sortedTreeDAG.processedTree = processedTree;
+
+        //collect all switch talent choices
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            if (indexTalentPair.second->type == Engine::TalentType::SWITCH) {
+                sortedTreeDAG.switchTalentChoices.push_back({ indexTalentPair.first, 1 });
+            }
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        //the sampler throws before anything reaches the sink if the builds can't be sampled uniformly
+        std::unique_ptr<CombinationSampler> sampler;
+        if (talentPoints > 0) {
+            try {
+                sampler = std::make_unique<CombinationSampler>(sortedTreeDAG, talentPoints, createCombinationFilterBits(tree, sortedTreeDAG, filter), seed);
+            }
+            catch (std::logic_error&) {
+                inProgress = false;
+                throw;
+            }
+        }
+        sink.begin(sortedTreeDAG);
+        size_t sampledCount = 0;
+        if (sampler) {
+            CombinationBlock block;
+            block.talentPoints = talentPoints;
+            block.indexWords = sortedTreeDAG.indexWords;
+            sampler->sample(sampleCount, block.combinations);
+            sampledCount = block.combinations.size() / block.indexWords;
+            for (size_t first = 0; first < block.combinations.size(); first += SOLVER_STREAM_BLOCK_SIZE * block.indexWords) {
+                size_t last = (std::min)(first + SOLVER_STREAM_BLOCK_SIZE * block.indexWords, block.combinations.size());
+                CombinationBlock part;
+                part.talentPoints = talentPoints;
+                part.indexWords = block.indexWords;
+                part.combinations.assign(block.combinations.begin() + first, block.combinations.begin() + last);
+                if (!sink.push(part)) {
+                    sortedTreeDAG.safetyGuardTriggered = true;
+                    break;
+                }
+            }
+        }
+        sink.finish();
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        sortedTreeDAG.allCombinations.resize(1);
+        sortedTreeDAG.allCombinationsSum = sampledCount;
+        sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        inProgress = false;
+
+        treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
+    }
+
+    /*
+    Returns the ranker of the bucket with talentPoints talent points of a ranked tree DAG (see countConfigurationsRanked), rankers
+    are only created when a bucket is browsed the first time since every one of them stores its own path counts. Buckets with more
+    builds than a CombinationCount can index can't be ranked and return nullptr.
+    */
+    std::shared_ptr<CombinationRanker> getCombinationRanker(TreeDAGInfo& treeDAG, int talentPoints) {
+        if (talentPoints <= 0 || static_cast<size_t>(talentPoints) > treeDAG.combinationRankers.size()) {
+            return nullptr;
+        }
+        if (static_cast<size_t>(talentPoints) <= treeDAG.exactCombinationCounts.size() && !treeDAG.exactCombinationCounts[talentPoints - 1].fitsUInt64()) {
+            return nullptr;
+        }
+        std::shared_ptr<CombinationRanker>& ranker = treeDAG.combinationRankers[talentPoints - 1];
+        if (ranker == nullptr) {
+            ranker = std::make_shared<CombinationRanker>(treeDAG, talentPoints);
+        }
+        return ranker->hasOverflow() ? nullptr : ranker;
+    }
+
+    /*
+    Prepares a tree for browsing without solving: counts all buckets like the count only solver and sets up (lazily created)
+    combination rankers instead of enumerating any build, so trees whose solve would trigger the safety guard can still be paged
+    through. allCombinations stays empty and filters can't be applied to a ranked tree DAG.
+    */
+    void countConfigurationsRanked(
+        TalentTree tree,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered) {
+
+        inProgress = true;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<TreeDAGInfo> rankedTreeDAG;
+        bool countInProgress = false;
+        countConfigurationsCountOnly(tree, talentPointsLimit, rankedTreeDAG, countInProgress, safetyGuardTriggered);
+        rankedTreeDAG->combinationRankers.resize(talentPointsLimit > 0 ? talentPointsLimit : 0);
+        if (onlyLimitSolve && talentPointsLimit > 0) {
+            //empty buckets are not listed, so only the limit bucket can be browsed
+            for (int i = 0; i < talentPointsLimit - 1; i++) {
+                rankedTreeDAG->combinationCounts[i] = 0;
+                rankedTreeDAG->weightedCombinationCounts[i] = 0;
+                if (rankedTreeDAG->exactCombinationCounts.size() > 0) {
+                    rankedTreeDAG->exactCombinationCounts[i] = 0;
+                    rankedTreeDAG->exactWeightedCombinationCounts[i] = 0;
+                }
+            }
+            rankedTreeDAG->allCombinationsSum = rankedTreeDAG->combinationCounts[talentPointsLimit - 1];
+        }
+        //the highest bucket is almost always the one that gets browsed first
+        getCombinationRanker(*rankedTreeDAG, talentPointsLimit);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        rankedTreeDAG->elapsedTime = ms_double.count() / 1000.0;
+        inProgress = false;
+
+        treeDAGInfo = rankedTreeDAG;
+    }
+
+    bool isBrowseOnly(const TreeDAGInfo& treeDAG) {
+        return treeDAG.combinationRankers.size() > 0 || treeDAG.combinationStore != nullptr;
+    }
+
+    /*
+    Bucket of the spilled combination store of a tree DAG (see TreeDAGInfo::combinationStore) that holds the bucket of filteredCombinations,
+    the store doesn't list empty buckets.
+    */
+    static bool findStoreBucket(const TreeDAGInfo& treeDAG, size_t bucket, size_t& storeBucket) {
+        if (treeDAG.combinationStore == nullptr) {
+            return false;
+        }
+        for (size_t i = 0; i < treeDAG.combinationStore->getBucketCount(); i++) {
+            if (treeDAG.combinationStore->getBucketTalentPoints(i) == static_cast<int>(bucket) + 1) {
+                storeBucket = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    Number of combinations of a bucket of filteredCombinations, ranked tree DAGs report their counted (unfiltered) buckets and spilled
+    tree DAGs the buckets of their combination store.
+    */
+    CombinationCount getFilteredCombinationCount(const TreeDAGInfo& treeDAG, size_t bucket) {
+        if (treeDAG.combinationRankers.size() > 0) {
+            return bucket < treeDAG.combinationCounts.size() ? treeDAG.combinationCounts[bucket] : 0;
+        }
+        if (treeDAG.combinationStore != nullptr) {
+            size_t storeBucket;
+            return findStoreBucket(treeDAG, bucket, storeBucket) ? treeDAG.combinationStore->getCombinationCount(storeBucket) : 0;
+        }
+        if (bucket >= treeDAG.filteredCombinations.size()) {
+            return 0;
+        }
+        return getCombinationCount(treeDAG, treeDAG.filteredCombinations[bucket]);
+    }
+
+    /*
+    Exact decimal version of getFilteredCombinationCount, counted buckets can exceed 64 bit (see TreeDAGInfo::exactCombinationCounts).
+    */
+    std::string getFilteredCombinationCountString(const TreeDAGInfo& treeDAG, size_t bucket) {
+        if (treeDAG.combinationRankers.size() > 0 && bucket < treeDAG.exactCombinationCounts.size()) {
+            return treeDAG.exactCombinationCounts[bucket].toString();
+        }
+        return std::to_string(getFilteredCombinationCount(treeDAG, bucket));
+    }
+
+    /*
+    Appends count combinations of a bucket of filteredCombinations starting at first, ranked tree DAGs unrank them instead and spilled
+    tree DAGs read them from their combination store.
+    */
+    void getFilteredCombinations(TreeDAGInfo& treeDAG, size_t bucket, CombinationCount first, size_t count, std::vector<SIND>& combinations) {
+        if (treeDAG.combinationRankers.size() > 0) {
+            std::shared_ptr<CombinationRanker> ranker = getCombinationRanker(treeDAG, static_cast<int>(bucket) + 1);
+            if (ranker != nullptr) {
+                ranker->unrankRange(first, count, combinations);
+            }
+            return;
+        }
+        if (treeDAG.combinationStore != nullptr) {
+            size_t storeBucket;
+            if (findStoreBucket(treeDAG, bucket, storeBucket)) {
+                try {
+                    //the reader replaces the contents of its output
+                    std::vector<SIND> storeCombinations;
+                    treeDAG.combinationStore->readCombinations(storeBucket, static_cast<size_t>(first), count, storeCombinations);
+                    combinations.insert(combinations.end(), storeCombinations.begin(), storeCombinations.end());
+                }
+                catch (std::exception&) {
+                }
+            }
+            return;
+        }
+        if (bucket >= treeDAG.filteredCombinations.size()) {
+            return;
+        }
+        const std::vector<SIND>& filtered = treeDAG.filteredCombinations[bucket];
+        size_t combinationCount = getCombinationCount(treeDAG, filtered);
+        if (first >= combinationCount) {
+            return;
+        }
+        size_t last = first + count < combinationCount ? static_cast<size_t>(first) + count : combinationCount;
+        combinations.insert(
+            combinations.end(),
+            filtered.begin() + static_cast<size_t>(first) * treeDAG.indexWords,
+            filtered.begin() + last * treeDAG.indexWords);
+    }
+
+    /*
+    Ranker of a bucket of a spilled tree DAG if the store holds all of its builds (the solve wasn't canceled), nullptr otherwise.
+    */
+    static std::shared_ptr<CombinationRanker> getSpilledBucketRanker(const TreeDAGInfo& treeDAG, size_t bucket) {
+        size_t storeBucket;
+        if (!findStoreBucket(treeDAG, bucket, storeBucket) || treeDAG.safetyGuardTriggered) {
+            return nullptr;
+        }
+        std::shared_ptr<CombinationRanker> ranker = std::make_shared<CombinationRanker>(treeDAG, static_cast<int>(bucket) + 1);
+        if (ranker->hasOverflow() || ranker->getCombinationCount() != treeDAG.combinationStore->getCombinationCount(storeBucket)) {
+            return nullptr;
+        }
+        return ranker;
+    }
+
+    /*
+    Number of builds of a bucket of filteredCombinations that contain each talent (indexed like sortedTalents), so the result of
+    including (count) or excluding (bucket count - count) any single talent is known without filtering once per talent.
+    Filtered buckets are scanned once with one counter per talent, ranked tree DAGs run a forward pass over the path counts instead.
+    */
+    std::vector<CombinationCount> getTalentInclusionCounts(TreeDAGInfo& treeDAG, size_t bucket) {
+        if (treeDAG.combinationRankers.size() > 0) {
+            std::shared_ptr<CombinationRanker> ranker = getCombinationRanker(treeDAG, static_cast<int>(bucket) + 1);
+            if (ranker == nullptr) {
+                return std::vector<CombinationCount>(treeDAG.sortedTalents.size(), 0);
+            }
+            return ranker->getTalentInclusionCounts();
+        }
+        std::vector<CombinationCount> inclusionCounts(64 * static_cast<size_t>(treeDAG.indexWords), 0);
+        if (treeDAG.combinationStore != nullptr) {
+            //complete spilled buckets hold every build, so the counts come from a ranker like for counted buckets
+            std::shared_ptr<CombinationRanker> ranker = getSpilledBucketRanker(treeDAG, bucket);
+            if (ranker != nullptr) {
+                return ranker->getTalentInclusionCounts();
+            }
+            size_t storeBucket;
+            if (findStoreBucket(treeDAG, bucket, storeBucket)) {
+                try {
+                    treeDAG.combinationStore->forEachCombination(storeBucket, [&](const SIND* skillsetIndex) {
+                        for (int w = 0; w < treeDAG.indexWords; w++) {
+                            for (SIND bits = skillsetIndex[w]; bits != 0; bits &= bits - 1) {
+                                inclusionCounts[64 * static_cast<size_t>(w) + lowestTalentBit(bits)]++;
+                            }
+                        }
+                        return true;
+                        });
+                }
+                catch (std::exception&) {
+                }
+            }
+        }
+        else if (bucket < treeDAG.filteredCombinations.size()) {
+            const std::vector<SIND>& filtered = treeDAG.filteredCombinations[bucket];
+            for (size_t i = 0; i < filtered.size(); i += treeDAG.indexWords) {
+                for (int w = 0; w < treeDAG.indexWords; w++) {
+                    for (SIND bits = filtered[i + w]; bits != 0; bits &= bits - 1) {
+                        inclusionCounts[64 * static_cast<size_t>(w) + lowestTalentBit(bits)]++;
+                    }
+                }
+            }
+        }
+        inclusionCounts.resize(treeDAG.sortedTalents.size());
+        return inclusionCounts;
+    }
+
+    /*
+    Talent inclusion counts per talent of the (unexpanded) tree, entry r of a talent is the number of builds of the bucket with at
+    least r + 1 points in it (switch talents have a single entry), see getTalentInclusionCounts.
+    */
+    std::map<int, std::vector<CombinationCount>> getTalentPointInclusionCounts(const TalentTree& tree, TreeDAGInfo& treeDAG, size_t bucket) {
+        std::vector<CombinationCount> inclusionCounts = getTalentInclusionCounts(treeDAG, bucket);
+        //same expanded indexing as skillsetIndexToSkillset
+        std::map<int, std::pair<int, int>> expandedToCompactIndexRankMap;
+        std::map<int, std::vector<CombinationCount>> talentPointInclusionCounts;
+        for (auto& talent : tree.orderedTalents) {
+            int ranks = talent.second->type == TalentType::SWITCH ? 1 : talent.second->maxPoints;
+            talentPointInclusionCounts[talent.second->index] = std::vector<CombinationCount>(ranks, 0);
+            for (int i = 0; i < ranks; i++) {
+                if (i == 0) {
+                    expandedToCompactIndexRankMap[talent.second->index] = { talent.second->index, 0 };
+                }
+                else {
+                    expandedToCompactIndexRankMap[(talent.second->index + 1) * tree.maxTalentPoints + (i - 1)] = { talent.second->index, i };
+                }
+            }
+        }
+        for (size_t i = 0; i < treeDAG.sortedTalents.size(); i++) {
+            auto indexRankIt = expandedToCompactIndexRankMap.find(treeDAG.sortedTalents[i]->index);
+            if (indexRankIt == expandedToCompactIndexRankMap.end()) {
+                continue;
+            }
+            talentPointInclusionCounts[indexRankIt->second.first][indexRankIt->second.second] = inclusionCounts[i];
+        }
+        return talentPointInclusionCounts;
+    }
+
+    /*
+    Adds the talent pair counts of rows first to first + rowCount - 1 to the upper triangle of pairCounts. Rows are transposed in tiles of
+    COOCCURRENCE_TILE_WORDS * 64 into one bit column per talent, so every talent pair of a tile costs COOCCURRENCE_TILE_WORDS popcounts of
+    the AND of two columns instead of one check per pair and build.
+    */
+    static void addTalentPairCounts(
+        const std::vector<SIND>& combinations,
+        int indexWords,
+        size_t talentCount,
+        size_t first,
+        size_t rowCount,
+        std::vector<CombinationCount>& pairCounts)
+    {
+        const size_t tileRows = 64 * COOCCURRENCE_TILE_WORDS;
+        std::vector<SIND> columns(talentCount * COOCCURRENCE_TILE_WORDS);
+        std::vector<size_t> activeTalents;
+        for (size_t tileFirst = first; tileFirst < first + rowCount; tileFirst += tileRows) {
+            size_t tileRowCount = std::min(tileRows, first + rowCount - tileFirst);
+            std::fill(columns.begin(), columns.end(), 0);
+            for (size_t row = 0; row < tileRowCount; row++) {
+                const SIND* skillsetIndex = &combinations[(tileFirst + row) * indexWords];
+                SIND rowBit = 1ULL << (row & 63);
+                size_t rowWord = row >> 6;
+                for (int w = 0; w < indexWords; w++) {
+                    for (SIND bits = skillsetIndex[w]; bits != 0; bits &= bits - 1) {
+                        columns[(64 * static_cast<size_t>(w) + lowestTalentBit(bits)) * COOCCURRENCE_TILE_WORDS + rowWord] |= rowBit;
+                    }
+                }
+            }
+            //talents that don't appear in the tile can't be part of any pair
+            activeTalents.clear();
+            for (size_t t = 0; t < talentCount; t++) {
+                const SIND* column = &columns[t * COOCCURRENCE_TILE_WORDS];
+                if (std::any_of(column, column + COOCCURRENCE_TILE_WORDS, [](SIND word) { return word != 0; })) {
+                    activeTalents.push_back(t);
+                }
+            }
+            for (size_t a = 0; a < activeTalents.size(); a++) {
+                const SIND* columnA = &columns[activeTalents[a] * COOCCURRENCE_TILE_WORDS];
+                CombinationCount* pairRow = &pairCounts[activeTalents[a] * talentCount];
+                for (size_t b = a; b < activeTalents.size(); b++) {
+                    const SIND* columnB = &columns[activeTalents[b] * COOCCURRENCE_TILE_WORDS];
+                    size_t count = 0;
+                    for (size_t k = 0; k < COOCCURRENCE_TILE_WORDS; k++) {
+                        count += std::bitset<64>(columnA[k] & columnB[k]).count();
+                    }
+                    pairRow[activeTalents[b]] += count;
+                }
+            }
+        }
+    }
+
+    /*
+    Counts how often every pair of talents appears together in the builds of a bucket of filteredCombinations (e.g. to see which talents
+    are coupled by the paths of the tree). Filtered buckets are split into tasks of COOCCURRENCE_TASK_ROWS rows that are counted on
+    threadCount threads (hardware concurrency if <= 0) with bit transposed tiles (see addTalentPairCounts). Ranked and count only tree
+    DAGs have no stored combinations, their counts come from forward passes over the path counts of a ranker (see getTalentPairCounts).
+    */
+    TalentCooccurrenceMatrix getTalentCooccurrenceMatrix(TreeDAGInfo& treeDAG, size_t bucket, int threadCount) {
+        TalentCooccurrenceMatrix matrix;
+        matrix.talentCount = static_cast<int>(treeDAG.sortedTalents.size());
+        size_t talentCount = treeDAG.sortedTalents.size();
+        matrix.counts.assign(talentCount * talentCount, 0);
+        std::shared_ptr<CombinationRanker> ranker;
+        if (treeDAG.combinationRankers.size() > 0) {
+            ranker = getCombinationRanker(treeDAG, static_cast<int>(bucket) + 1);
+        }
+        else if (treeDAG.combinationStore != nullptr) {
+            ranker = getSpilledBucketRanker(treeDAG, bucket);
+        }
+        else if (treeDAG.combinationCounts.size() > 0 && bucket < treeDAG.combinationCounts.size() && treeDAG.combinationCounts[bucket] > 0
+            && (bucket >= treeDAG.exactCombinationCounts.size() || treeDAG.exactCombinationCounts[bucket].fitsUInt64())) {
+            //count only solves keep the counts but no combinations, buckets whose count overflowed can't be ranked
+            ranker = std::make_shared<CombinationRanker>(treeDAG, static_cast<int>(bucket) + 1);
+        }
+        if (ranker != nullptr && !ranker->hasOverflow()) {
+            matrix.combinationCount = ranker->getCombinationCount();
+            matrix.counts = ranker->getTalentPairCounts();
+            std::vector<CombinationCount> inclusionCounts = ranker->getTalentInclusionCounts();
+            for (size_t i = 0; i < talentCount; i++) {
+                matrix.counts[i * talentCount + i] = inclusionCounts[i];
+            }
+        }
+        else if (treeDAG.combinationStore != nullptr) {
+            //incomplete spilled buckets are streamed from the store in tasks of COOCCURRENCE_TASK_ROWS rows
+            size_t storeBucket;
+            if (findStoreBucket(treeDAG, bucket, storeBucket)) {
+                std::vector<SIND> rows;
+                auto countRows = [&]() {
+                    size_t rowCount = rows.size() / treeDAG.indexWords;
+                    addTalentPairCounts(rows, treeDAG.indexWords, talentCount, 0, rowCount, matrix.counts);
+                    matrix.combinationCount += rowCount;
+                    rows.clear();
+                };
+                try {
+                    treeDAG.combinationStore->forEachCombination(storeBucket, [&](const SIND* skillsetIndex) {
+                        rows.insert(rows.end(), skillsetIndex, skillsetIndex + treeDAG.indexWords);
+                        if (rows.size() == COOCCURRENCE_TASK_ROWS * treeDAG.indexWords) {
+                            countRows();
+                        }
+                        return true;
+                        });
+                    countRows();
+                }
+                catch (std::exception&) {
+                }
+            }
+        }
+        else if (bucket < treeDAG.filteredCombinations.size() && treeDAG.combinationRankers.size() == 0) {
+            const std::vector<SIND>& filtered = treeDAG.filteredCombinations[bucket];
+            size_t rowCount = filtered.size() / treeDAG.indexWords;
+            matrix.combinationCount = rowCount;
+            size_t taskCount = (rowCount + COOCCURRENCE_TASK_ROWS - 1) / COOCCURRENCE_TASK_ROWS;
+            if (threadCount <= 0) {
+                threadCount = static_cast<int>(std::thread::hardware_concurrency());
+            }
+            threadCount = std::max(1, std::min(threadCount, static_cast<int>(taskCount)));
+            std::atomic<size_t> nextTask = 0;
+            std::mutex resultMutex;
+            auto worker = [&]() {
+                std::vector<CombinationCount> pairCounts(talentCount * talentCount, 0);
+                size_t task;
+                while ((task = nextTask.fetch_add(1)) < taskCount) {
+                    size_t first = task * COOCCURRENCE_TASK_ROWS;
+                    addTalentPairCounts(filtered, treeDAG.indexWords, talentCount, first, std::min(COOCCURRENCE_TASK_ROWS, rowCount - first), pairCounts);
+                }
+                std::lock_guard<std::mutex> lock(resultMutex);
+                for (size_t i = 0; i < pairCounts.size(); i++) {
+                    matrix.counts[i] += pairCounts[i];
+                }
+            };
+            if (threadCount <= 1) {
+                worker();
+            }
+            else {
+                std::vector<std::thread> workers;
+                for (int i = 0; i < threadCount; i++) {
+                    workers.emplace_back(worker);
+                }
+                for (auto& t : workers) {
+                    t.join();
+                }
+            }
+        }
+        //only the upper triangle is counted
+        for (size_t i = 0; i < talentCount; i++) {
+            for (size_t j = i + 1; j < talentCount; j++) {
+                matrix.counts[j * talentCount + i] = matrix.counts[i * talentCount + j];
+            }
+        }
+        return matrix;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <random>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//filters with or/one groups are sampled by rejection, sampling gives up after this many draws per requested build
+constexpr size_t SAMPLER_ATTEMPTS_PER_SAMPLE = 1000;
+//co-occurrence counting transposes this many rows (64 per word) at once into one bit column per talent
+constexpr size_t COOCCURRENCE_TILE_WORDS = 8;
+//rows per co-occurrence task, tasks are distributed over the worker threads
+constexpr size_t COOCCURRENCE_TASK_ROWS = 65536;
+
+namespace Engine {
+    /*
+    Bijection between the valid builds of a sorted DAG with exactly talentPoints talent points and the integers 0 to
+    getCombinationCount() - 1 without storing a single build. Uses the states of countCombinationsDP (talents are decided in
+    sorted order, a state is the set of reachable undecided talents plus the talent points spent) and stores for every reachable
+    state the number of ways to complete it, so rank/unrank only need one lookup per talent.
+    Builds are ordered by their skillset index bits from the first sorted talent on where skipping a talent comes before taking it,
+    which is not the order the enumerating solvers produce. The include and exclude bits of a filter restrict the ranked builds,
+    or/one groups are ignored since they don't fit into the states (see CombinationSampler).
+    Path counts saturate at UINT64_MAX, rankers of buckets with more builds than a CombinationCount can index report hasOverflow()
+    and must not be used for ranking or sampling.
+    */
+    class CombinationRanker {
+    public:
+        CombinationRanker(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const CombinationFilterBits& filter = CombinationFilterBits());
+        ~CombinationRanker();
+
+        int getTalentPoints() const;
+        int getIndexWords() const;
+        CombinationCount getCombinationCount() const;
+        size_t getStateCount() const;
+        bool hasOverflow() const;
+
+        //throws if the skillset index is not a valid build with talentPoints talent points
+        CombinationCount rank(const SIND* skillsetIndex) const;
+        //writes indexWords SINDs, throws if index >= getCombinationCount()
+        void unrank(CombinationCount index, SIND* skillsetIndex) const;
+        //appends the builds first to first + count - 1 (clamped to the combination count) in the allCombinations layout
+        void unrankRange(CombinationCount first, size_t count, std::vector<SIND>& combinations) const;
+        //number of ranked builds that contain each talent (indexed like sortedTalents), one forward pass over the path counts
+        std::vector<CombinationCount> getTalentInclusionCounts() const;
+        //number of ranked builds that contain both talent i and j for j > i (row major talentCount x talentCount, rest stays 0),
+        //one forward pass per talent that is forced to be taken
+        std::vector<CombinationCount> getTalentPairCounts() const;
+
+        struct PathCounts;
+
+    private:
+        int talentPoints = 0;
+        int indexWords = 1;
+        std::unique_ptr<PathCounts> pathCounts;
+    };
+
+    /*
+    Draws uniformly random valid builds with exactly talentPoints talent points that pass a filter. Builds are unranked from uniformly
+    random indices of a filtered CombinationRanker, so the cost of a sample only depends on the number of talents and not on the number
+    of builds. Or/one groups of the filter are checked afterwards and failing builds are drawn again. Throws std::logic_error if the
+    candidates don't fit into a CombinationCount since the drawn indices wouldn't be uniform then.
+    */
+    class CombinationSampler {
+    public:
+        CombinationSampler(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const CombinationFilterBits& filter, std::uint64_t seed);
+
+        int getIndexWords() const;
+        //number of builds that pass the include/exclude part of the filter (upper bound of the builds that pass the filter)
+        CombinationCount getCandidateCount() const;
+
+        //appends up to count distinct builds in random order, returns the number of appended builds (less than count if the filter
+        //doesn't have enough builds or rejection sampling gave up)
+        size_t sample(size_t count, std::vector<SIND>& combinations);
+
+    private:
+        CombinationRanker ranker;
+        CombinationFilterBits filter;
+        bool needsRejection = false;
+        std::mt19937_64 rng;
+    };
+
+    /*
+    Pairwise co-occurrence counts of the talents of a talent point bucket (see getTalentCooccurrenceMatrix). Entry (i, j) of the row
+    major counts is the number of builds that contain talent i and j (indexed like sortedTalents), the diagonal holds the inclusion
+    counts (see getTalentInclusionCounts).
+    */
+    struct TalentCooccurrenceMatrix {
+        int talentCount = 0;
+        CombinationCount combinationCount = 0;
+        std::vector<CombinationCount> counts;
+    };
+
+    void sampleConfigurations(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPoints,
+        size_t sampleCount,
+        std::uint64_t seed,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress);
+
+    std::shared_ptr<CombinationRanker> getCombinationRanker(TreeDAGInfo& treeDAG, int talentPoints);
+    void countConfigurationsRanked(
+        TalentTree tree,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered);
+    //ranked and spilled tree DAGs have no combinations in memory, they can be browsed but not filtered
+    bool isBrowseOnly(const TreeDAGInfo& treeDAG);
+    CombinationCount getFilteredCombinationCount(const TreeDAGInfo& treeDAG, size_t bucket);
+    std::string getFilteredCombinationCountString(const TreeDAGInfo& treeDAG, size_t bucket);
+    void getFilteredCombinations(TreeDAGInfo& treeDAG, size_t bucket, CombinationCount first, size_t count, std::vector<SIND>& combinations);
+    std::vector<CombinationCount> getTalentInclusionCounts(TreeDAGInfo& treeDAG, size_t bucket);
+    std::map<int, std::vector<CombinationCount>> getTalentPointInclusionCounts(const TalentTree& tree, TreeDAGInfo& treeDAG, size_t bucket);
+    TalentCooccurrenceMatrix getTalentCooccurrenceMatrix(TreeDAGInfo& treeDAG, size_t bucket, int threadCount = 0);
+}
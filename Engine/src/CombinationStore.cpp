@@ -0,0 +1,1159 @@
+﻿/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "CombinationStore.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Engine {
+    static const char COMBINATION_STORE_MAGIC[8] = { 'T', 'T', 'M', 'C', 'O', 'M', 'B', '\0' };
+
+    /*
+    Fixed size file header, integers are stored in native byte order (little endian on all supported platforms).
+    */
+    struct CombinationStoreHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t indexWords;
+        std::uint32_t blockSize;
+        std::uint32_t bucketCount;
+        std::uint64_t blockCount;
+        std::uint64_t totalCombinations;
+        std::uint64_t metadataOffset;
+        std::uint64_t bucketTableOffset;
+        std::uint64_t blockIndexOffset;
+    };
+    static_assert(sizeof(CombinationStoreHeader) == 64, "combination store header has to be 64 bytes");
+
+    struct CombinationStoreBucketEntry {
+        std::uint32_t talentPoints;
+        std::uint32_t flags;
+        std::uint64_t combinationCount;
+        std::uint64_t firstBlock;
+        std::uint64_t blockCount;
+    };
+    static_assert(sizeof(CombinationStoreBucketEntry) == 32, "combination store bucket entry has to be 32 bytes");
+
+    //block index entries are followed by the first combination of the block (indexWords SINDs)
+    struct CombinationStoreBlockEntry {
+        std::uint64_t dataOffset;
+        std::uint32_t dataSize;
+        std::uint32_t combinationCount;
+    };
+    static_assert(sizeof(CombinationStoreBlockEntry) == 16, "combination store block entry has to be 16 bytes");
+
+    /*
+    Multi word skillset indices are compared and subtracted as unsigned integers with words[indexWords - 1] as most significant word.
+    */
+    static inline bool skillsetIndexLess(const SIND* a, const SIND* b, int indexWords) {
+        for (int i = indexWords - 1; i >= 0; i--) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i];
+            }
+        }
+        return false;
+    }
+
+    static inline bool skillsetIndexEqual(const SIND* a, const SIND* b, int indexWords) {
+        return std::memcmp(a, b, sizeof(SIND) * indexWords) == 0;
+    }
+
+    template<int IndexWords>
+    struct SkillsetIndexWords {
+        SIND words[IndexWords];
+    };
+
+    /*
+    Sorts the combinations in place, multi word skillset indices are swapped as a whole so no index or copy of the bucket is needed.
+    */
+    template<int IndexWords>
+    static void sortSkillsetIndexWords(std::vector<SIND>& combinations) {
+        static_assert(sizeof(SkillsetIndexWords<IndexWords>) == sizeof(SIND) * IndexWords, "skillset index words have to be packed");
+        SkillsetIndexWords<IndexWords>* first = reinterpret_cast<SkillsetIndexWords<IndexWords>*>(combinations.data());
+        std::sort(first, first + combinations.size() / IndexWords, [](const SkillsetIndexWords<IndexWords>& a, const SkillsetIndexWords<IndexWords>& b) {
+            return skillsetIndexLess(a.words, b.words, IndexWords);
+            });
+    }
+
+    static void sortSkillsetIndices(std::vector<SIND>& combinations, int indexWords) {
+        if (indexWords == 1) {
+            std::sort(combinations.begin(), combinations.end());
+        }
+        else if (indexWords == 2) {
+            sortSkillsetIndexWords<2>(combinations);
+        }
+        else {
+            sortSkillsetIndexWords<4>(combinations);
+        }
+    }
+
+    //bucket table flag of buckets that keep the order they were written in (see CombinationStoreWriter::writeUnsortedBucket)
+    static const std::uint32_t COMBINATION_STORE_BUCKET_UNSORTED = 1;
+
+    //current - previous (wraps around if current is smaller)
+    static inline void subtractSkillsetIndices(const SIND* current, const SIND* previous, SIND* difference, int indexWords) {
+        SIND borrow = 0;
+        for (int i = 0; i < indexWords; i++) {
+            SIND wordDifference = current[i] - previous[i];
+            SIND nextBorrow = (current[i] < previous[i]) || (wordDifference < borrow) ? 1 : 0;
+            difference[i] = wordDifference - borrow;
+            borrow = nextBorrow;
+        }
+    }
+
+    static inline void addSkillsetIndices(const SIND* previous, const SIND* delta, SIND* current, int indexWords) {
+        SIND carry = 0;
+        for (int i = 0; i < indexWords; i++) {
+            SIND sum = previous[i] + delta[i];
+            SIND nextCarry = sum < previous[i] ? 1 : 0;
+            current[i] = sum + carry;
+            nextCarry |= current[i] < sum ? 1 : 0;
+            carry = nextCarry;
+        }
+    }
+
+    /*
+    Appends a words wide value as LEB128 varint (7 bits per byte, high bit set if more bytes follow), value is consumed.
+    */
+    static void appendVarint(SIND* value, int words, std::vector<unsigned char>& buffer) {
+        while (true) {
+            unsigned char byte = static_cast<unsigned char>(value[0] & 0x7F);
+            bool remaining = false;
+            for (int i = 0; i < words; i++) {
+                value[i] = (value[i] >> 7) | (i + 1 < words ? value[i + 1] << 57 : 0);
+                remaining |= value[i] != 0;
+            }
+            if (!remaining) {
+                buffer.push_back(byte);
+                return;
+            }
+            buffer.push_back(byte | 0x80);
+        }
+    }
+
+    /*
+    Reads a words wide varint at pos into value (bits beyond words are dropped), returns the position after the varint.
+    */
+    static const unsigned char* readVarint(const unsigned char* pos, const unsigned char* end, SIND* value, int words) {
+        std::memset(value, 0, sizeof(SIND) * words);
+        int shift = 0;
+        while (true) {
+            if (pos >= end) {
+                throw std::logic_error("Combination store block is corrupt");
+            }
+            unsigned char byte = *pos++;
+            SIND bits = byte & 0x7F;
+            int word = shift / 64;
+            int offset = shift % 64;
+            if (word < words) {
+                value[word] |= bits << offset;
+                if (offset > 57 && word + 1 < words) {
+                    value[word + 1] |= bits >> (64 - offset);
+                }
+            }
+            shift += 7;
+            if ((byte & 0x80) == 0) {
+                return pos;
+            }
+        }
+    }
+
+    /*
+    Appends current - previous as varint, current has to be larger than previous.
+    */
+    static void appendDeltaVarint(const SIND* previous, const SIND* current, int indexWords, std::vector<unsigned char>& buffer) {
+        SIND delta[4] = {};
+        subtractSkillsetIndices(current, previous, delta, indexWords);
+        appendVarint(delta, indexWords, buffer);
+    }
+
+    /*
+    Reads a varint delta at pos and adds it to previous, returns the position after the varint.
+    */
+    static const unsigned char* readDeltaVarint(const unsigned char* pos, const unsigned char* end, const SIND* previous, SIND* current, int indexWords) {
+        SIND delta[4] = {};
+        pos = readVarint(pos, end, delta, indexWords);
+        addSkillsetIndices(previous, delta, current, indexWords);
+        return pos;
+    }
+
+    /*
+    Appends the difference of two combinations in any order as varint of (|current - previous| << 1) | sign, which needs one bit more
+    than a skillset index and therefore indexWords + 1 words.
+    */
+    static void appendSignedDeltaVarint(const SIND* previous, const SIND* current, int indexWords, std::vector<unsigned char>& buffer) {
+        SIND magnitude[4] = {};
+        SIND sign = 0;
+        if (skillsetIndexLess(current, previous, indexWords)) {
+            subtractSkillsetIndices(previous, current, magnitude, indexWords);
+            sign = 1;
+        }
+        else {
+            subtractSkillsetIndices(current, previous, magnitude, indexWords);
+        }
+        SIND value[5] = {};
+        value[0] = (magnitude[0] << 1) | sign;
+        for (int i = 1; i <= indexWords; i++) {
+            value[i] = (i < indexWords ? magnitude[i] << 1 : 0) | (magnitude[i - 1] >> 63);
+        }
+        appendVarint(value, indexWords + 1, buffer);
+    }
+
+    static const unsigned char* readSignedDeltaVarint(const unsigned char* pos, const unsigned char* end, const SIND* previous, SIND* current, int indexWords) {
+        SIND value[5];
+        pos = readVarint(pos, end, value, indexWords + 1);
+        SIND magnitude[4];
+        for (int i = 0; i < indexWords; i++) {
+            magnitude[i] = (value[i] >> 1) | (value[i + 1] << 63);
+        }
+        if (value[0] & 1) {
+            subtractSkillsetIndices(previous, magnitude, current, indexWords);
+        }
+        else {
+            addSkillsetIndices(previous, magnitude, current, indexWords);
+        }
+        return pos;
+    }
+
+    template<typename T>
+    static void appendRaw(std::vector<unsigned char>& buffer, const T& value) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void appendIntArray(std::vector<unsigned char>& buffer, const std::vector<int>& values) {
+        appendRaw(buffer, static_cast<std::int32_t>(values.size()));
+        for (int value : values) {
+            appendRaw(buffer, static_cast<std::int32_t>(value));
+        }
+    }
+
+    CombinationStoreWriter::CombinationStoreWriter(const std::filesystem::path& path, const CombinationStoreMetadata& metadata)
+        : indexWords(metadata.indexWords) {
+        if (indexWords != 1 && indexWords != 2 && indexWords != 4) {
+            throw std::logic_error("Combination store only supports skillset indices with 1, 2 or 4 words");
+        }
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path());
+        }
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::logic_error("Could not open combination store file for writing");
+        }
+
+        //header is written with final offsets in finish()
+        CombinationStoreHeader header = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<unsigned char> metadataBuffer;
+        appendRaw(metadataBuffer, static_cast<std::int32_t>(metadata.talentPointsLimit));
+        appendRaw(metadataBuffer, static_cast<std::int32_t>((metadata.onlyLimitSolve ? 1 : 0) | (metadata.safetyGuardTriggered ? 2 : 0)));
+        appendIntArray(metadataBuffer, metadata.sortedTalentIndices);
+        appendIntArray(metadataBuffer, metadata.bitToIndexVec);
+        appendRaw(metadataBuffer, static_cast<std::int32_t>(metadata.switchBitToIndexVec.size()));
+        for (auto& bitIndexPair : metadata.switchBitToIndexVec) {
+            appendRaw(metadataBuffer, static_cast<std::int32_t>(bitIndexPair.first));
+            appendRaw(metadataBuffer, static_cast<std::int32_t>(bitIndexPair.second));
+        }
+        file.write(reinterpret_cast<const char*>(metadataBuffer.data()), metadataBuffer.size());
+        dataOffset = sizeof(CombinationStoreHeader) + metadataBuffer.size();
+    }
+
+    CombinationStoreWriter::~CombinationStoreWriter() {
+        if (!finished && file.is_open()) {
+            //write errors can't leave the destructor, callers that need to know call finish themselves
+            try {
+                finish();
+            }
+            catch (std::exception&) {
+            }
+        }
+    }
+
+    void CombinationStoreWriter::writeBucket(int talentPoints, std::vector<SIND>& combinations) {
+        beginBucket(talentPoints);
+        sortSkillsetIndices(combinations, indexWords);
+        appendSortedCombinations(combinations.data(), combinations.size() / indexWords);
+        endBucket();
+    }
+
+    void CombinationStoreWriter::writeUnsortedBucket(int talentPoints, const std::vector<SIND>& combinations) {
+        beginBucket(talentPoints, false);
+        appendCombinations(combinations.data(), combinations.size() / indexWords);
+        endBucket();
+    }
+
+    void CombinationStoreWriter::beginBucket(int talentPoints, bool sorted) {
+        if (finished) {
+            throw std::logic_error("Combination store was already finished");
+        }
+        if (bucketOpen) {
+            throw std::logic_error("Previous combination store bucket was not ended");
+        }
+        if (buckets.size() > 0 && static_cast<int>(buckets.back().talentPoints) >= talentPoints) {
+            throw std::logic_error("Combination store buckets have to be written in increasing order of talent points");
+        }
+        BucketEntry bucket;
+        bucket.talentPoints = static_cast<std::uint32_t>(talentPoints);
+        bucket.sorted = sorted;
+        bucket.combinationCount = 0;
+        bucket.firstBlock = blockIndex.size() / (sizeof(CombinationStoreBlockEntry) + sizeof(SIND) * indexWords);
+        bucket.blockCount = 0;
+        buckets.push_back(bucket);
+        pendingCombinations.clear();
+        bucketOpen = true;
+    }
+
+    /*
+    Appends combinations to the open sorted bucket, they have to be sorted and larger than every combination appended before.
+    */
+    void CombinationStoreWriter::appendSortedCombinations(const SIND* combinations, size_t count) {
+        if (bucketOpen && !buckets.back().sorted) {
+            throw std::logic_error("Combination store bucket is not sorted");
+        }
+        appendToBucket(combinations, count);
+    }
+
+    /*
+    Appends combinations to the open unsorted bucket in the given order.
+    */
+    void CombinationStoreWriter::appendCombinations(const SIND* combinations, size_t count) {
+        if (bucketOpen && buckets.back().sorted) {
+            throw std::logic_error("Combination store bucket is sorted");
+        }
+        appendToBucket(combinations, count);
+    }
+
+    /*
+    Full blocks are written right away, the rest is kept until the next call or endBucket.
+    */
+    void CombinationStoreWriter::appendToBucket(const SIND* combinations, size_t count) {
+        if (!bucketOpen) {
+            throw std::logic_error("No combination store bucket was begun");
+        }
+        const size_t blockWords = COMBINATION_STORE_BLOCK_SIZE * indexWords;
+        const SIND* current = combinations;
+        const SIND* end = combinations + count * indexWords;
+        while (current < end) {
+            size_t remainingWords = static_cast<size_t>(end - current);
+            if (pendingCombinations.size() == 0 && remainingWords >= blockWords) {
+                writeBlock(current, COMBINATION_STORE_BLOCK_SIZE);
+                buckets.back().blockCount++;
+                current += blockWords;
+                continue;
+            }
+            size_t takenWords = (std::min)(blockWords - pendingCombinations.size(), remainingWords);
+            pendingCombinations.insert(pendingCombinations.end(), current, current + takenWords);
+            current += takenWords;
+            if (pendingCombinations.size() == blockWords) {
+                writeBlock(pendingCombinations.data(), COMBINATION_STORE_BLOCK_SIZE);
+                buckets.back().blockCount++;
+                pendingCombinations.clear();
+            }
+        }
+        buckets.back().combinationCount += count;
+        totalCombinations += count;
+    }
+
+    void CombinationStoreWriter::endBucket() {
+        if (!bucketOpen) {
+            throw std::logic_error("No combination store bucket was begun");
+        }
+        if (pendingCombinations.size() > 0) {
+            writeBlock(pendingCombinations.data(), pendingCombinations.size() / indexWords);
+            buckets.back().blockCount++;
+            pendingCombinations.clear();
+        }
+        bucketOpen = false;
+    }
+
+    void CombinationStoreWriter::writeBlock(const SIND* combinations, size_t count) {
+        blockBuffer.clear();
+        bool sorted = buckets.back().sorted;
+        for (size_t i = 1; i < count; i++) {
+            if (sorted) {
+                appendDeltaVarint(&combinations[(i - 1) * indexWords], &combinations[i * indexWords], indexWords, blockBuffer);
+            }
+            else {
+                appendSignedDeltaVarint(&combinations[(i - 1) * indexWords], &combinations[i * indexWords], indexWords, blockBuffer);
+            }
+        }
+
+        CombinationStoreBlockEntry entry;
+        entry.dataOffset = dataOffset;
+        entry.dataSize = static_cast<std::uint32_t>(blockBuffer.size());
+        entry.combinationCount = static_cast<std::uint32_t>(count);
+        appendRaw(blockIndex, entry);
+        for (int i = 0; i < indexWords; i++) {
+            appendRaw(blockIndex, combinations[i]);
+        }
+
+        file.write(reinterpret_cast<const char*>(blockBuffer.data()), blockBuffer.size());
+        dataOffset += blockBuffer.size();
+    }
+
+    void CombinationStoreWriter::finish() {
+        if (finished) {
+            return;
+        }
+        if (bucketOpen) {
+            endBucket();
+        }
+        finished = true;
+
+        CombinationStoreHeader header = {};
+        std::memcpy(header.magic, COMBINATION_STORE_MAGIC, sizeof(header.magic));
+        header.version = COMBINATION_STORE_VERSION;
+        header.indexWords = static_cast<std::uint32_t>(indexWords);
+        header.blockSize = COMBINATION_STORE_BLOCK_SIZE;
+        header.bucketCount = static_cast<std::uint32_t>(buckets.size());
+        header.blockCount = blockIndex.size() / (sizeof(CombinationStoreBlockEntry) + sizeof(SIND) * indexWords);
+        header.totalCombinations = totalCombinations;
+        header.metadataOffset = sizeof(CombinationStoreHeader);
+        header.bucketTableOffset = dataOffset;
+        header.blockIndexOffset = dataOffset + buckets.size() * sizeof(CombinationStoreBucketEntry);
+
+        for (auto& bucket : buckets) {
+            CombinationStoreBucketEntry entry = {};
+            entry.talentPoints = bucket.talentPoints;
+            entry.flags = bucket.sorted ? 0 : COMBINATION_STORE_BUCKET_UNSORTED;
+            entry.combinationCount = bucket.combinationCount;
+            entry.firstBlock = bucket.firstBlock;
+            entry.blockCount = bucket.blockCount;
+            file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+        file.write(reinterpret_cast<const char*>(blockIndex.data()), blockIndex.size());
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.close();
+        if (file.fail()) {
+            throw std::logic_error("Could not write combination store file");
+        }
+    }
+
+    CombinationStoreReader::CombinationStoreReader(const std::filesystem::path& path) : path(path) {
+        mapFile(path);
+        try {
+            if (dataSize < sizeof(CombinationStoreHeader)) {
+                throw std::logic_error("Combination store file is too small");
+            }
+            CombinationStoreHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            if (std::memcmp(header.magic, COMBINATION_STORE_MAGIC, sizeof(header.magic)) != 0) {
+                throw std::logic_error("File is not a combination store");
+            }
+            if (header.version == 0 || header.version > COMBINATION_STORE_VERSION) {
+                throw std::logic_error("Combination store version is not supported");
+            }
+            if ((header.indexWords != 1 && header.indexWords != 2 && header.indexWords != 4) || header.blockSize == 0) {
+                throw std::logic_error("Combination store header is corrupt");
+            }
+            indexWords = static_cast<int>(header.indexWords);
+            blockSize = header.blockSize;
+            blockCount = static_cast<size_t>(header.blockCount);
+            totalCombinations = static_cast<size_t>(header.totalCombinations);
+            blockIndexOffset = static_cast<size_t>(header.blockIndexOffset);
+            blockIndexStride = sizeof(CombinationStoreBlockEntry) + sizeof(SIND) * indexWords;
+            if (header.bucketTableOffset + header.bucketCount * sizeof(CombinationStoreBucketEntry) > dataSize
+                || blockIndexOffset + blockCount * blockIndexStride > dataSize) {
+                throw std::logic_error("Combination store file is truncated");
+            }
+
+            //metadata
+            const unsigned char* pos = data + header.metadataOffset;
+            const unsigned char* end = data + header.bucketTableOffset;
+            auto readInt = [&]() -> int {
+                if (pos + sizeof(std::int32_t) > end) {
+                    throw std::logic_error("Combination store metadata is corrupt");
+                }
+                std::int32_t value;
+                std::memcpy(&value, pos, sizeof(value));
+                pos += sizeof(value);
+                return static_cast<int>(value);
+            };
+            auto readIntArray = [&](std::vector<int>& values) {
+                int count = readInt();
+                if (count < 0 || static_cast<size_t>(count) > static_cast<size_t>(end - pos) / sizeof(std::int32_t)) {
+                    throw std::logic_error("Combination store metadata is corrupt");
+                }
+                values.resize(count);
+                for (auto& value : values) {
+                    value = readInt();
+                }
+            };
+            metadata.indexWords = indexWords;
+            metadata.talentPointsLimit = readInt();
+            int flags = readInt();
+            metadata.onlyLimitSolve = (flags & 1) != 0;
+            metadata.safetyGuardTriggered = (flags & 2) != 0;
+            readIntArray(metadata.sortedTalentIndices);
+            readIntArray(metadata.bitToIndexVec);
+            int switchCount = readInt();
+            for (int i = 0; i < switchCount; i++) {
+                int bit = readInt();
+                metadata.switchBitToIndexVec.push_back({ bit, readInt() });
+            }
+
+            //bucket table
+            for (std::uint32_t i = 0; i < header.bucketCount; i++) {
+                CombinationStoreBucketEntry entry;
+                std::memcpy(&entry, data + header.bucketTableOffset + i * sizeof(CombinationStoreBucketEntry), sizeof(entry));
+                //every block holds at most blockSize combinations, so the count bounds the blocks a read can touch
+                if (entry.firstBlock > blockCount || entry.blockCount > blockCount - entry.firstBlock
+                    || entry.combinationCount / blockSize + (entry.combinationCount % blockSize != 0 ? 1 : 0) > entry.blockCount) {
+                    throw std::logic_error("Combination store bucket table is corrupt");
+                }
+                BucketEntry bucket;
+                bucket.talentPoints = static_cast<int>(entry.talentPoints);
+                bucket.sorted = (entry.flags & COMBINATION_STORE_BUCKET_UNSORTED) == 0;
+                bucket.combinationCount = static_cast<size_t>(entry.combinationCount);
+                bucket.firstBlock = static_cast<size_t>(entry.firstBlock);
+                bucket.blockCount = static_cast<size_t>(entry.blockCount);
+                buckets.push_back(bucket);
+            }
+        }
+        catch (...) {
+            unmapFile();
+            throw;
+        }
+    }
+
+    CombinationStoreReader::~CombinationStoreReader() {
+        unmapFile();
+    }
+
+    void CombinationStoreReader::mapFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+        HANDLE fileHandle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            throw std::logic_error("Could not open combination store file");
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(fileHandle);
+            throw std::logic_error("Combination store file is empty");
+        }
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        CloseHandle(fileHandle);
+        if (mappingHandle == NULL) {
+            throw std::logic_error("Could not map combination store file");
+        }
+        //the view keeps the mapping alive after the handle is closed
+        void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mappingHandle);
+        if (view == NULL) {
+            throw std::logic_error("Could not map combination store file");
+        }
+        data = static_cast<const unsigned char*>(view);
+        dataSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+        int fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            throw std::logic_error("Could not open combination store file");
+        }
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+            close(fileDescriptor);
+            throw std::logic_error("Combination store file is empty");
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        close(fileDescriptor);
+        if (view == MAP_FAILED) {
+            throw std::logic_error("Could not map combination store file");
+        }
+        data = static_cast<const unsigned char*>(view);
+        dataSize = static_cast<size_t>(fileStat.st_size);
+#endif
+    }
+
+    void CombinationStoreReader::unmapFile() {
+        if (data == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(const_cast<unsigned char*>(data), dataSize);
+#endif
+        data = nullptr;
+        dataSize = 0;
+    }
+
+    const std::filesystem::path& CombinationStoreReader::getPath() const {
+        return path;
+    }
+
+    const CombinationStoreMetadata& CombinationStoreReader::getMetadata() const {
+        return metadata;
+    }
+
+    int CombinationStoreReader::getIndexWords() const {
+        return indexWords;
+    }
+
+    size_t CombinationStoreReader::getBucketCount() const {
+        return buckets.size();
+    }
+
+    int CombinationStoreReader::getBucketTalentPoints(size_t bucket) const {
+        return buckets.at(bucket).talentPoints;
+    }
+
+    size_t CombinationStoreReader::getCombinationCount(size_t bucket) const {
+        return buckets.at(bucket).combinationCount;
+    }
+
+    size_t CombinationStoreReader::getTotalCombinationCount() const {
+        return totalCombinations;
+    }
+
+    bool CombinationStoreReader::isBucketSorted(size_t bucket) const {
+        return buckets.at(bucket).sorted;
+    }
+
+    const unsigned char* CombinationStoreReader::getBlockIndexEntry(size_t block) const {
+        return data + blockIndexOffset + block * blockIndexStride;
+    }
+
+    /*
+    Decodes all combinations of a block into combinations (has to hold blockSize * indexWords SINDs), returns the number of combinations.
+    */
+    size_t CombinationStoreReader::decodeBlock(size_t block, bool sorted, SIND* combinations) const {
+        const unsigned char* indexEntry = getBlockIndexEntry(block);
+        CombinationStoreBlockEntry entry;
+        std::memcpy(&entry, indexEntry, sizeof(entry));
+        if (entry.combinationCount == 0 || entry.combinationCount > blockSize || entry.dataOffset + entry.dataSize > dataSize) {
+            throw std::logic_error("Combination store block index is corrupt");
+        }
+        std::memcpy(combinations, indexEntry + sizeof(entry), sizeof(SIND) * indexWords);
+        const unsigned char* pos = data + entry.dataOffset;
+        const unsigned char* end = pos + entry.dataSize;
+        for (size_t i = 1; i < entry.combinationCount; i++) {
+            if (sorted) {
+                pos = readDeltaVarint(pos, end, &combinations[(i - 1) * indexWords], &combinations[i * indexWords], indexWords);
+            }
+            else {
+                pos = readSignedDeltaVarint(pos, end, &combinations[(i - 1) * indexWords], &combinations[i * indexWords], indexWords);
+            }
+        }
+        return entry.combinationCount;
+    }
+
+    /*
+    Decodes count combinations of a bucket starting at combination first, only the blocks that contain them are decoded.
+    */
+    void CombinationStoreReader::readCombinations(size_t bucket, size_t first, size_t count, std::vector<SIND>& combinations) const {
+        const BucketEntry& entry = buckets.at(bucket);
+        if (first >= entry.combinationCount) {
+            combinations.clear();
+            return;
+        }
+        if (count > entry.combinationCount - first) {
+            count = entry.combinationCount - first;
+        }
+        combinations.resize(count * indexWords);
+        //every block but the last one of a bucket is full
+        std::vector<SIND> blockCombinations(blockSize * indexWords);
+        size_t block = entry.firstBlock + first / blockSize;
+        size_t offset = first % blockSize;
+        size_t copied = 0;
+        while (copied < count) {
+            if (block >= entry.firstBlock + entry.blockCount) {
+                throw std::logic_error("Combination store block index is corrupt");
+            }
+            size_t decoded = decodeBlock(block, entry.sorted, blockCombinations.data());
+            size_t available = decoded > offset ? decoded - offset : 0;
+            size_t take = count - copied < available ? count - copied : available;
+            if (take == 0) {
+                throw std::logic_error("Combination store block index is corrupt");
+            }
+            std::memcpy(&combinations[copied * indexWords], &blockCombinations[offset * indexWords], sizeof(SIND) * indexWords * take);
+            copied += take;
+            offset = 0;
+            block++;
+        }
+    }
+
+    void CombinationStoreReader::readBucket(size_t bucket, std::vector<SIND>& combinations) const {
+        readCombinations(bucket, 0, buckets.at(bucket).combinationCount, combinations);
+    }
+
+    /*
+    Calls visitor for every combination of a bucket in stored order, returns false if the visitor stopped the iteration.
+    */
+    bool CombinationStoreReader::forEachCombination(size_t bucket, const std::function<bool(const SIND*)>& visitor) const {
+        const BucketEntry& entry = buckets.at(bucket);
+        std::vector<SIND> blockCombinations(blockSize * indexWords);
+        for (size_t block = entry.firstBlock; block < entry.firstBlock + entry.blockCount; block++) {
+            size_t decoded = decodeBlock(block, entry.sorted, blockCombinations.data());
+            for (size_t i = 0; i < decoded; i++) {
+                if (!visitor(&blockCombinations[i * indexWords])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /*
+    Binary search over the first combinations in the block index, then decodes the single block that could contain the skillset index.
+    Unsorted buckets are scanned.
+    */
+    bool CombinationStoreReader::contains(size_t bucket, const SIND* skillsetIndex) const {
+        const BucketEntry& entry = buckets.at(bucket);
+        if (entry.blockCount == 0) {
+            return false;
+        }
+        if (!entry.sorted) {
+            return !forEachCombination(bucket, [&](const SIND* combination) {
+                return !skillsetIndexEqual(combination, skillsetIndex, indexWords);
+                });
+        }
+        size_t low = entry.firstBlock;
+        size_t high = entry.firstBlock + entry.blockCount;
+        while (high - low > 1) {
+            size_t mid = low + (high - low) / 2;
+            SIND firstWords[4];
+            std::memcpy(firstWords, getBlockIndexEntry(mid) + sizeof(CombinationStoreBlockEntry), sizeof(SIND) * indexWords);
+            if (skillsetIndexLess(skillsetIndex, firstWords, indexWords)) {
+                high = mid;
+            }
+            else {
+                low = mid;
+            }
+        }
+        std::vector<SIND> blockCombinations(blockSize * indexWords);
+        size_t decoded = decodeBlock(low, true, blockCombinations.data());
+        size_t first = 0;
+        size_t last = decoded;
+        while (first < last) {
+            size_t mid = first + (last - first) / 2;
+            if (skillsetIndexLess(&blockCombinations[mid * indexWords], skillsetIndex, indexWords)) {
+                first = mid + 1;
+            }
+            else {
+                last = mid;
+            }
+        }
+        return first < decoded && skillsetIndexEqual(&blockCombinations[first * indexWords], skillsetIndex, indexWords);
+    }
+
+    CombinationStoreSink::CombinationStoreSink(const std::filesystem::path& path, const TalentTree& tree, int talentPointsLimit, bool onlyLimitSolve, size_t memoryBudget)
+        : path(path), tree(tree), talentPointsLimit(talentPointsLimit), onlyLimitSolve(onlyLimitSolve), memoryBudget(memoryBudget) {
+    }
+
+    CombinationStoreSink::~CombinationStoreSink() {
+        removeSpillFiles();
+    }
+
+    void CombinationStoreSink::begin(const TreeDAGInfo& treeDAG) {
+        metadata = createCombinationStoreMetadata(tree, treeDAG, talentPointsLimit, onlyLimitSolve);
+        if (memoryBudget == 0) {
+            memoryBudget = getSolverMemoryBudget();
+        }
+        removeSpillFiles();
+        buckets.clear();
+        buckets.resize(talentPointsLimit);
+        spilledRuns.clear();
+        spilledRuns.resize(talentPointsLimit);
+        bufferedSINDs = 0;
+        spillCount = 0;
+        spilling = false;
+    }
+
+    /*
+    Collects the block and spills the collected combinations once they reach half of the memory budget. The batch is taken out of the
+    sink and sorted and written without holding the lock, so other solver threads keep pushing meanwhile. Only one batch is spilled at
+    a time (threads that fill the next batch wait for it), so the sink never holds more than the memory budget.
+    */
+    bool CombinationStoreSink::push(CombinationBlock& block) {
+        std::unique_lock<std::mutex> lock(bucketMutex);
+        //only limit stores never contain the other buckets
+        if (onlyLimitSolve && block.talentPoints != talentPointsLimit) {
+            return true;
+        }
+        std::vector<SIND>& bucket = buckets[block.talentPoints - 1];
+        bucket.insert(bucket.end(), block.combinations.begin(), block.combinations.end());
+        bufferedSINDs += block.combinations.size();
+        if (bufferedSINDs * sizeof(SIND) < memoryBudget / 2) {
+            return true;
+        }
+        spillFinished.wait(lock, [&]() { return !spilling; });
+        //another thread might have spilled the batch while this one waited
+        if (bufferedSINDs * sizeof(SIND) < memoryBudget / 2) {
+            return true;
+        }
+        vec2d<SIND> spilledBuckets(buckets.size());
+        spilledBuckets.swap(buckets);
+        bufferedSINDs = 0;
+        size_t run = spillCount++;
+        spilling = true;
+        lock.unlock();
+
+        std::vector<std::filesystem::path> runPaths(spilledBuckets.size());
+        bool spilled = true;
+        try {
+            spillBuckets(spilledBuckets, run, runPaths);
+        }
+        catch (std::logic_error&) {
+            spilled = false;
+        }
+
+        lock.lock();
+        for (size_t i = 0; i < runPaths.size(); i++) {
+            if (!runPaths[i].empty()) {
+                spilledRuns[i].push_back(runPaths[i]);
+            }
+        }
+        if (!spilled) {
+            //store is marked as canceled since the combinations of the failed run are lost
+            metadata.safetyGuardTriggered = true;
+        }
+        spilling = false;
+        spillFinished.notify_all();
+        return spilled;
+    }
+
+    void CombinationStoreSink::finish() {
+        CombinationStoreWriter writer(path, metadata);
+        for (int i = 0; i < talentPointsLimit; i++) {
+            if (onlyLimitSolve && i + 1 != talentPointsLimit) {
+                continue;
+            }
+            if (spilledRuns[i].size() == 0) {
+                writer.writeBucket(i + 1, buckets[i]);
+            }
+            else {
+                writer.beginBucket(i + 1);
+                mergeBucket(writer, i);
+                writer.endBucket();
+            }
+            //release memory of written buckets right away
+            std::vector<SIND>().swap(buckets[i]);
+        }
+        writer.finish();
+        removeSpillFiles();
+    }
+
+    size_t CombinationStoreSink::getSpilledRunCount() const {
+        return spillCount;
+    }
+
+    /*
+    Sorts every non empty bucket of a spilled batch and writes it as a raw run of SINDs into the spill directory (a unique directory in
+    the temp directory that is created by the first spill), runPaths receives the run file of every bucket. Buckets are released as
+    soon as they are written.
+    */
+    void CombinationStoreSink::spillBuckets(vec2d<SIND>& spilledBuckets, size_t run, std::vector<std::filesystem::path>& runPaths) {
+        std::filesystem::path directory = spillDirectory;
+        if (directory.empty()) {
+            directory = std::filesystem::temp_directory_path() / ("ttm_spill_"
+                + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_"
+                + std::to_string(reinterpret_cast<std::uintptr_t>(this)));
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+            if (ec) {
+                throw std::logic_error("Could not create spill directory " + directory.string());
+            }
+            //spills run one at a time, so the directory is only set once
+            spillDirectory = directory;
+        }
+        for (size_t i = 0; i < spilledBuckets.size(); i++) {
+            if (spilledBuckets[i].size() == 0) {
+                continue;
+            }
+            sortSkillsetIndices(spilledBuckets[i], metadata.indexWords);
+            std::filesystem::path runPath = directory / ("run" + std::to_string(run) + "_" + std::to_string(i + 1) + ".bin");
+            std::ofstream runFile(runPath, std::ios::binary | std::ios::trunc);
+            runFile.write(reinterpret_cast<const char*>(spilledBuckets[i].data()), spilledBuckets[i].size() * sizeof(SIND));
+            runFile.close();
+            if (runFile.fail()) {
+                throw std::logic_error("Could not write spill file " + runPath.string());
+            }
+            runPaths[i] = runPath;
+            std::vector<SIND>().swap(spilledBuckets[i]);
+        }
+    }
+
+    /*
+    K-way merge of the spilled runs of a bucket and the combinations that are still in memory into the open bucket of the writer.
+    Runs are read in chunks so the merge stays within the memory budget as well.
+    */
+    void CombinationStoreSink::mergeBucket(CombinationStoreWriter& writer, size_t bucket) {
+        int indexWords = metadata.indexWords;
+        struct MergeRun {
+            std::ifstream file;
+            std::vector<SIND> buffer;
+            size_t position = 0;
+        };
+        std::vector<SIND>& memoryRun = buckets[bucket];
+        sortSkillsetIndices(memoryRun, indexWords);
+        size_t runCount = spilledRuns[bucket].size() + 1;
+        size_t chunkWords = (std::max)(memoryBudget / 4 / sizeof(SIND) / runCount, static_cast<size_t>(COMBINATION_STORE_BLOCK_SIZE));
+        chunkWords -= chunkWords % indexWords;
+
+        std::vector<MergeRun> runs(spilledRuns[bucket].size());
+        auto refill = [&](MergeRun& run) {
+            run.buffer.resize(chunkWords);
+            run.file.read(reinterpret_cast<char*>(run.buffer.data()), chunkWords * sizeof(SIND));
+            run.buffer.resize(static_cast<size_t>(run.file.gcount()) / sizeof(SIND));
+            run.position = 0;
+            return run.buffer.size() > 0;
+        };
+        //heap of run indices, index runs.size() is the in memory run
+        std::vector<size_t> heap;
+        size_t memoryPosition = 0;
+        auto head = [&](size_t run) -> const SIND* {
+            if (run == runs.size()) {
+                return &memoryRun[memoryPosition];
+            }
+            return &runs[run].buffer[runs[run].position];
+        };
+        auto compare = [&](size_t a, size_t b) { return skillsetIndexLess(head(b), head(a), indexWords); };
+        for (size_t i = 0; i < runs.size(); i++) {
+            runs[i].file.open(spilledRuns[bucket][i], std::ios::binary);
+            if (!runs[i].file.is_open()) {
+                throw std::logic_error("Could not open spill file " + spilledRuns[bucket][i].string());
+            }
+            if (refill(runs[i])) {
+                heap.push_back(i);
+            }
+        }
+        if (memoryRun.size() > 0) {
+            heap.push_back(runs.size());
+        }
+        std::make_heap(heap.begin(), heap.end(), compare);
+
+        std::vector<SIND> output;
+        output.reserve(chunkWords);
+        while (heap.size() > 0) {
+            std::pop_heap(heap.begin(), heap.end(), compare);
+            size_t run = heap.back();
+            const SIND* combination = head(run);
+            output.insert(output.end(), combination, combination + indexWords);
+            bool exhausted;
+            if (run == runs.size()) {
+                memoryPosition += indexWords;
+                exhausted = memoryPosition >= memoryRun.size();
+            }
+            else {
+                runs[run].position += indexWords;
+                exhausted = runs[run].position >= runs[run].buffer.size() && !refill(runs[run]);
+            }
+            if (exhausted) {
+                heap.pop_back();
+            }
+            else {
+                std::push_heap(heap.begin(), heap.end(), compare);
+            }
+            if (output.size() >= chunkWords) {
+                writer.appendSortedCombinations(output.data(), output.size() / indexWords);
+                output.clear();
+            }
+        }
+        writer.appendSortedCombinations(output.data(), output.size() / indexWords);
+    }
+
+    void CombinationStoreSink::removeSpillFiles() {
+        if (spillDirectory.empty()) {
+            return;
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(spillDirectory, ec);
+        spillDirectory.clear();
+        for (auto& runs : spilledRuns) {
+            runs.clear();
+        }
+    }
+
+    /*
+    Creates the metadata of a solved tree, the bit to index table maps every bit of a skillset index to the positional index of its
+    (compact) talent where talents are ordered by row first and column second.
+    */
+    CombinationStoreMetadata createCombinationStoreMetadata(const TalentTree& tree, const TreeDAGInfo& treeDAG, int talentPointsLimit, bool onlyLimitSolve) {
+        CombinationStoreMetadata metadata;
+        metadata.indexWords = treeDAG.indexWords;
+        metadata.talentPointsLimit = talentPointsLimit;
+        metadata.onlyLimitSolve = onlyLimitSolve;
+        metadata.safetyGuardTriggered = treeDAG.safetyGuardTriggered;
+        for (auto& talent : treeDAG.sortedTalents) {
+            metadata.sortedTalentIndices.push_back(talent->index);
+        }
+
+        std::map<int, int> expandedToCompactIndexMap;
+        for (auto& talent : tree.orderedTalents) {
+            for (int j = 0; j < talent.second->maxPoints; j++) {
+                //this indexing is taken from TalentTrees.cpp expand talent tree routine and represents an arbitrary indexing
+                //for multipoint talents that doesn't collide for a use in a map
+                //TTMNOTE: If this changes, also change TalentTrees.cpp->expandTalentAndAdvance and TreeSolver.cpp->filterSolvedSkillsets
+                if (j == 0) {
+                    expandedToCompactIndexMap[talent.second->index] = talent.second->index;
+                }
+                else {
+                    expandedToCompactIndexMap[(talent.second->index + 1) * tree.maxTalentPoints + (j - 1)] = talent.second->index;
+                }
+            }
+        }
+
+        // normally, TTM indices will already be in that order but since arbitrary
+        // unique indices are allowed we're gonna make sure to adhere to this ordering now
+        TalentVec resortedTalents = treeDAG.sortedTalents;
+        std::sort(resortedTalents.begin(), resortedTalents.end(),
+            [](const Talent_s& a, const Talent_s& b) -> bool
+            {
+                if (a->row != b->row) {
+                    return a->row < b->row;
+                }
+                return a->column < b->column;
+            });
+
+        std::map<int, int> compactToPositionalIndexMap;
+        int positionalIndex = 0;
+        for (auto& talent : resortedTalents) {
+            int compactIndex = expandedToCompactIndexMap[talent->index];
+            if (!compactToPositionalIndexMap.count(compactIndex)) {
+                compactToPositionalIndexMap[compactIndex] = positionalIndex++;
+            }
+        }
+
+        metadata.bitToIndexVec.reserve(treeDAG.sortedTalents.size());
+        for (auto& talent : treeDAG.sortedTalents) {
+            metadata.bitToIndexVec.push_back(compactToPositionalIndexMap[expandedToCompactIndexMap[talent->index]]);
+        }
+        for (int bit = 0; bit < static_cast<int>(treeDAG.sortedTalents.size()); bit++) {
+            if (treeDAG.sortedTalents[bit]->type == TalentType::SWITCH) {
+                metadata.switchBitToIndexVec.push_back({ bit, metadata.bitToIndexVec[bit] });
+            }
+        }
+        return metadata;
+    }
+
+    /*
+    Writes the (unfiltered) combinations of a solved tree into a combination store, in only limit solves only the last bucket is stored.
+    */
+    void writeCombinationStore(const std::filesystem::path& path, const TalentTree& tree, const TreeDAGInfo& treeDAG, bool onlyLimitSolve) {
+        if (treeDAG.combinationStore != nullptr) {
+            //spilled (or browsed) solves already are a combination store
+            std::error_code ec;
+            if (std::filesystem::equivalent(treeDAG.combinationStore->getPath(), path, ec)) {
+                return;
+            }
+            std::filesystem::copy_file(treeDAG.combinationStore->getPath(), path, std::filesystem::copy_options::overwrite_existing);
+            return;
+        }
+        int talentPointsLimit = static_cast<int>(treeDAG.allCombinations.size());
+        CombinationStoreWriter writer(path, createCombinationStoreMetadata(tree, treeDAG, talentPointsLimit, onlyLimitSolve));
+        for (int i = 0; i < talentPointsLimit; i++) {
+            if (onlyLimitSolve && i + 1 != talentPointsLimit) {
+                continue;
+            }
+            std::vector<SIND> combinations = treeDAG.allCombinations[i];
+            writer.writeBucket(i + 1, combinations);
+        }
+        writer.finish();
+    }
+
+    /*
+    Recreates the TreeDAGInfo of a solve from a combination store without solving the tree again. Throws if the store was created
+    for a tree with a different structure. The metadata of the store is returned in metadata. Stores that don't fit into the solver
+    memory budget aren't decoded but attached as TreeDAGInfo::combinationStore and browsed from disk like a spilled solve.
+    */
+    std::shared_ptr<TreeDAGInfo> loadCombinationStore(const std::filesystem::path& path, TalentTree tree, CombinationStoreMetadata& metadata) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<CombinationStoreReader> reader = std::make_shared<CombinationStoreReader>(path);
+        metadata = reader->getMetadata();
+
+        std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
+        expandTreeTalents(*processedTree);
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        if (sortedTreeDAG.indexWords != reader->getIndexWords() || sortedTreeDAG.sortedTalents.size() != metadata.sortedTalentIndices.size()) {
+            throw std::logic_error("Combination store does not match the talent tree");
+        }
+        for (size_t i = 0; i < sortedTreeDAG.sortedTalents.size(); i++) {
+            if (sortedTreeDAG.sortedTalents[i]->index != metadata.sortedTalentIndices[i]) {
+                throw std::logic_error("Combination store does not match the talent tree");
+            }
+        }
+        setSafetyGuard(sortedTreeDAG);
+        sortedTreeDAG.processedTree = processedTree;
+        sortedTreeDAG.safetyGuardTriggered = metadata.safetyGuardTriggered;
+
+        sortedTreeDAG.allCombinations.resize(metadata.talentPointsLimit);
+        bool browseFromDisk = reader->getTotalCombinationCount() > getSolverMemoryBudget() / (sizeof(SIND) * reader->getIndexWords());
+        for (size_t bucket = 0; bucket < reader->getBucketCount(); bucket++) {
+            int talentPoints = reader->getBucketTalentPoints(bucket);
+            if (talentPoints < 1 || talentPoints > metadata.talentPointsLimit) {
+                throw std::logic_error("Combination store bucket table is corrupt");
+            }
+            if (!browseFromDisk) {
+                reader->readBucket(bucket, sortedTreeDAG.allCombinations[talentPoints - 1]);
+            }
+        }
+        if (browseFromDisk) {
+            sortedTreeDAG.combinationStore = reader;
+            sortedTreeDAG.allCombinationsSum = reader->getTotalCombinationCount();
+        }
+
+        //collect all switch talent choices
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            if (indexTalentPair.second->type == Engine::TalentType::SWITCH) {
+                sortedTreeDAG.switchTalentChoices.push_back({ indexTalentPair.first, 1 });
+            }
+        }
+
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        return std::make_shared<TreeDAGInfo>(sortedTreeDAG);
+    }
+
+    /*
+    Default location of the combination store of a tree (inside the app folder, named after the tree).
+    */
+    std::filesystem::path getCombinationStorePath(const TalentTree& tree) {
+        std::string fileName;
+        for (char c : tree.name) {
+            fileName += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_';
+        }
+        if (fileName.empty()) {
+            fileName = "tree";
+        }
+        return Presets::getAppPath() / "solutions" / (fileName + ".ttmc");
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <functional>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//combination stores encode this many combinations per block, every block can be decoded on its own
+constexpr std::uint32_t COMBINATION_STORE_BLOCK_SIZE = 1024;
+//version 2 added buckets in solver order, version 1 stores are still readable
+constexpr std::uint32_t COMBINATION_STORE_VERSION = 2;
+
+namespace Engine {
+    /*
+    Meta information of a combination store that is needed to interpret the stored skillset indices without re-solving the tree.
+    sortedTalentIndices holds the (expanded) talent index of every bit and is used to check that a store belongs to a tree,
+    bitToIndexVec and switchBitToIndexVec are the positional talent index tables the CLI writes into its text output.
+    */
+    struct CombinationStoreMetadata {
+        int indexWords = 1;
+        int talentPointsLimit = 0;
+        bool onlyLimitSolve = true;
+        bool safetyGuardTriggered = false;
+        std::vector<int> sortedTalentIndices;
+        std::vector<int> bitToIndexVec;
+        std::vector<std::pair<int, int>> switchBitToIndexVec;
+    };
+
+    /*
+    Writes a combination store file. File layout (integers in native byte order, i.e. little endian on all supported platforms):
+    - header (magic, version, index words, block size, bucket count, section offsets, see CombinationStoreHeader in the .cpp)
+    - metadata (CombinationStoreMetadata as int32 arrays)
+    - data blocks, every block holds up to COMBINATION_STORE_BLOCK_SIZE combinations of one talent point bucket where
+      the first combination is stored in the block index and every following one as varint encoded difference to its predecessor
+      (sorted buckets store the difference, unsorted buckets the magnitude of the difference shifted left by one with the sign in the lowest bit)
+    - bucket table (talent points, flags, combination count, first block, block count per bucket)
+    - block index (data offset, data size, combination count and first combination per block)
+    Buckets have to be written in increasing order of talent points. writeBucket sorts the combinations of a bucket, writeUnsortedBucket
+    keeps them in the given (e.g. solver) order, which compresses worse and can't be binary searched by CombinationStoreReader::contains.
+    */
+    class CombinationStoreWriter {
+    public:
+        CombinationStoreWriter(const std::filesystem::path& path, const CombinationStoreMetadata& metadata);
+        ~CombinationStoreWriter();
+
+        void writeBucket(int talentPoints, std::vector<SIND>& combinations);
+        void writeUnsortedBucket(int talentPoints, const std::vector<SIND>& combinations);
+        //incremental version of writeBucket/writeUnsortedBucket for buckets that don't fit into memory, appended combinations of
+        //sorted buckets have to be sorted already
+        void beginBucket(int talentPoints, bool sorted = true);
+        void appendSortedCombinations(const SIND* combinations, size_t count);
+        void appendCombinations(const SIND* combinations, size_t count);
+        void endBucket();
+        void finish();
+
+    private:
+        struct BucketEntry {
+            std::uint32_t talentPoints;
+            bool sorted;
+            std::uint64_t combinationCount;
+            std::uint64_t firstBlock;
+            std::uint64_t blockCount;
+        };
+
+        void appendToBucket(const SIND* combinations, size_t count);
+        void writeBlock(const SIND* combinations, size_t count);
+
+        std::ofstream file;
+        int indexWords = 1;
+        bool finished = false;
+        bool bucketOpen = false;
+        std::uint64_t dataOffset = 0;
+        std::uint64_t totalCombinations = 0;
+        std::vector<BucketEntry> buckets;
+        std::vector<unsigned char> blockIndex;
+        std::vector<unsigned char> blockBuffer;
+        //combinations of the open bucket that don't fill a block yet
+        std::vector<SIND> pendingCombinations;
+    };
+
+    /*
+    Read only view of a combination store file. The file is memory mapped, only the header, metadata, bucket table and block index
+    are parsed on open, combinations are decoded block by block on access.
+    */
+    class CombinationStoreReader {
+    public:
+        explicit CombinationStoreReader(const std::filesystem::path& path);
+        ~CombinationStoreReader();
+        CombinationStoreReader(const CombinationStoreReader&) = delete;
+        CombinationStoreReader& operator=(const CombinationStoreReader&) = delete;
+
+        const std::filesystem::path& getPath() const;
+        const CombinationStoreMetadata& getMetadata() const;
+        int getIndexWords() const;
+        size_t getBucketCount() const;
+        int getBucketTalentPoints(size_t bucket) const;
+        size_t getCombinationCount(size_t bucket) const;
+        size_t getTotalCombinationCount() const;
+        bool isBucketSorted(size_t bucket) const;
+
+        void readCombinations(size_t bucket, size_t first, size_t count, std::vector<SIND>& combinations) const;
+        void readBucket(size_t bucket, std::vector<SIND>& combinations) const;
+        bool forEachCombination(size_t bucket, const std::function<bool(const SIND*)>& visitor) const;
+        bool contains(size_t bucket, const SIND* skillsetIndex) const;
+
+    private:
+        struct BucketEntry {
+            int talentPoints;
+            bool sorted;
+            size_t combinationCount;
+            size_t firstBlock;
+            size_t blockCount;
+        };
+
+        void mapFile(const std::filesystem::path& path);
+        void unmapFile();
+        const unsigned char* getBlockIndexEntry(size_t block) const;
+        size_t decodeBlock(size_t block, bool sorted, SIND* combinations) const;
+
+        std::filesystem::path path;
+        const unsigned char* data = nullptr;
+        size_t dataSize = 0;
+        int indexWords = 1;
+        size_t blockSize = COMBINATION_STORE_BLOCK_SIZE;
+        size_t blockIndexOffset = 0;
+        size_t blockIndexStride = 0;
+        size_t blockCount = 0;
+        size_t totalCombinations = 0;
+        CombinationStoreMetadata metadata;
+        std::vector<BucketEntry> buckets;
+    };
+
+    /*
+    Streaming sink that collects combinations per talent point bucket and writes them into a combination store when the solve finishes.
+    Once the collected combinations reach half of the memory budget (getSolverMemoryBudget by default) every bucket is sorted and
+    spilled as a run into a temporary file while the next half is collected, finish merges the runs of every bucket into the store.
+    Memory usage therefore stays within the budget no matter how many combinations the solve produces.
+    */
+    class CombinationStoreSink : public CombinationSink {
+    public:
+        CombinationStoreSink(const std::filesystem::path& path, const TalentTree& tree, int talentPointsLimit, bool onlyLimitSolve, size_t memoryBudget = 0);
+        ~CombinationStoreSink();
+        void begin(const TreeDAGInfo& treeDAG) override;
+        bool push(CombinationBlock& block) override;
+        void finish() override;
+        size_t getSpilledRunCount() const;
+
+    private:
+        void spillBuckets(vec2d<SIND>& spilledBuckets, size_t run, std::vector<std::filesystem::path>& runPaths);
+        void mergeBucket(CombinationStoreWriter& writer, size_t bucket);
+        void removeSpillFiles();
+
+        std::filesystem::path path;
+        const TalentTree& tree;
+        int talentPointsLimit;
+        bool onlyLimitSolve;
+        size_t memoryBudget;
+        CombinationStoreMetadata metadata;
+        vec2d<SIND> buckets;
+        size_t bufferedSINDs = 0;
+        std::filesystem::path spillDirectory;
+        //spilled run files per bucket
+        std::vector<std::vector<std::filesystem::path>> spilledRuns;
+        size_t spillCount = 0;
+        bool spilling = false;
+        std::mutex bucketMutex;
+        std::condition_variable spillFinished;
+    };
+
+    CombinationStoreMetadata createCombinationStoreMetadata(const TalentTree& tree, const TreeDAGInfo& treeDAG, int talentPointsLimit, bool onlyLimitSolve);
+    void writeCombinationStore(const std::filesystem::path& path, const TalentTree& tree, const TreeDAGInfo& treeDAG, bool onlyLimitSolve);
+    std::shared_ptr<TreeDAGInfo> loadCombinationStore(const std::filesystem::path& path, TalentTree tree, CombinationStoreMetadata& metadata);
+    std::filesystem::path getCombinationStorePath(const TalentTree& tree);
+}
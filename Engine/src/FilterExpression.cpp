@@ -0,0 +1,399 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "FilterExpression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace Engine {
+    /*
+    Recursive descent parser for the grammar in FilterExpression.h, emits the postfix code while parsing.
+    */
+    class FilterExpressionParser {
+    public:
+        FilterExpressionParser(const TalentTree& tree, const std::string& source) : tree(tree), source(source) {
+            expression.source = source;
+        }
+
+        FilterExpression parse() {
+            parseOr(0);
+            skipSpaces();
+            if (pos < source.size()) {
+                fail("unexpected '" + std::string(1, source[pos]) + "'");
+            }
+            if (expression.code.size() == 0) {
+                fail("empty expression");
+            }
+            return expression;
+        }
+
+    private:
+        void fail(const std::string& message) const {
+            throw std::logic_error("Filter expression error at position " + std::to_string(pos + 1) + ": " + message);
+        }
+
+        void skipSpaces() {
+            while (pos < source.size() && std::isspace(static_cast<unsigned char>(source[pos]))) {
+                pos++;
+            }
+        }
+
+        bool matchSymbol(const char* symbol) {
+            skipSpaces();
+            size_t length = std::strlen(symbol);
+            if (source.compare(pos, length, symbol) != 0) {
+                return false;
+            }
+            pos += length;
+            return true;
+        }
+
+        //keywords have to end at a non alphanumeric character so e.g. "order" is not read as "or"
+        bool matchKeyword(const char* keyword) {
+            skipSpaces();
+            size_t length = std::strlen(keyword);
+            if (source.compare(pos, length, keyword) != 0
+                || (pos + length < source.size() && std::isalnum(static_cast<unsigned char>(source[pos + length])))) {
+                return false;
+            }
+            pos += length;
+            return true;
+        }
+
+        void expectSymbol(const char* symbol) {
+            if (!matchSymbol(symbol)) {
+                fail(std::string("expected '") + symbol + "'");
+            }
+        }
+
+        bool peekNumber() {
+            skipSpaces();
+            return pos < source.size() && std::isdigit(static_cast<unsigned char>(source[pos]));
+        }
+
+        int parseNumber() {
+            if (!peekNumber()) {
+                fail("expected a number");
+            }
+            int number = 0;
+            while (pos < source.size() && std::isdigit(static_cast<unsigned char>(source[pos]))) {
+                if (number > 100000) {
+                    fail("number too large");
+                }
+                number = number * 10 + (source[pos] - '0');
+                pos++;
+            }
+            return number;
+        }
+
+        Talent_s parseTalent() {
+            size_t talentPos = pos;
+            int id = parseNumber();
+            auto talentIt = tree.orderedTalents.find(id);
+            if (talentIt == tree.orderedTalents.end()) {
+                pos = talentPos;
+                fail("talent " + std::to_string(id) + " does not exist in tree " + tree.name);
+            }
+            return talentIt->second;
+        }
+
+        //switch talents are a single expanded talent, the choice does not matter for the solver
+        static int getTalentRanks(const Talent_s& talent) {
+            return talent->type == TalentType::SWITCH ? 1 : talent->maxPoints;
+        }
+
+        //adds the first ranks points of a talent to an atom, preselected talents are always fully selected
+        void addTalentPoints(FilterAtom& atom, const Talent_s& talent, int ranks) const {
+            if (talent->preFilled) {
+                atom.constantCount += ranks;
+                return;
+            }
+            for (int i = 0; i < ranks; i++) {
+                //same expanded indexing as skillsetIndexToSkillset
+                atom.expandedTalentIndices.push_back(i == 0 ? talent->index : (talent->index + 1) * tree.maxTalentPoints + (i - 1));
+            }
+        }
+
+        void emit(FilterOp op, int atom = 0) {
+            expression.code.push_back({ op, atom });
+            if (op == FilterOp::ATOM) {
+                stackSize++;
+                if (stackSize > FILTER_EXPRESSION_MAX_STACK) {
+                    fail("expression is too complex");
+                }
+                expression.stackDepth = std::max(expression.stackDepth, stackSize);
+            }
+            else if (op != FilterOp::NOT) {
+                stackSize--;
+            }
+        }
+
+        void emitAtom(FilterAtom atom) {
+            expression.atoms.push_back(std::move(atom));
+            emit(FilterOp::ATOM, static_cast<int>(expression.atoms.size()) - 1);
+        }
+
+        //comparison of an atom count with a number, != is the negated == atom
+        void emitComparison(FilterAtom atom) {
+            bool negate = false;
+            if (matchSymbol(">=")) {
+                atom.minCount = parseNumber();
+            }
+            else if (matchSymbol("<=")) {
+                atom.maxCount = parseNumber();
+            }
+            else if (matchSymbol("==")) {
+                atom.minCount = atom.maxCount = parseNumber();
+            }
+            else if (matchSymbol("!=")) {
+                atom.minCount = atom.maxCount = parseNumber();
+                negate = true;
+            }
+            else if (matchSymbol(">")) {
+                atom.minCount = parseNumber() + 1;
+            }
+            else if (matchSymbol("<")) {
+                atom.maxCount = parseNumber() - 1;
+            }
+            else {
+                fail("expected a comparison (>=, <=, ==, !=, >, <)");
+            }
+            emitAtom(std::move(atom));
+            if (negate) {
+                emit(FilterOp::NOT);
+            }
+        }
+
+        //number of selected talents of a group (rank 1 of every talent), the count is a lower and/or upper bound
+        void emitGroupCount(FilterAtom atom, bool lowerBound, bool upperBound) {
+            expectSymbol("(");
+            int count = parseNumber();
+            expectSymbol(",");
+            for (auto& talent : parseTalentList()) {
+                addTalentPoints(atom, talent, 1);
+            }
+            expectSymbol(")");
+            if (lowerBound) {
+                atom.minCount = count;
+            }
+            if (upperBound) {
+                atom.maxCount = count;
+            }
+            emitAtom(std::move(atom));
+        }
+
+        //comma separated talent ids, every talent only counts once
+        std::vector<Talent_s> parseTalentList() {
+            std::vector<Talent_s> talents;
+            std::set<int> ids;
+            do {
+                Talent_s talent = parseTalent();
+                if (ids.insert(talent->index).second) {
+                    talents.push_back(talent);
+                }
+            } while (matchSymbol(","));
+            return talents;
+        }
+
+        void parseOr(int nesting) {
+            parseAnd(nesting);
+            while (matchSymbol("|") || matchKeyword("or")) {
+                parseAnd(nesting);
+                emit(FilterOp::OR);
+            }
+        }
+
+        void parseAnd(int nesting) {
+            parseNot(nesting);
+            while (matchSymbol("&") || matchKeyword("and")) {
+                parseNot(nesting);
+                emit(FilterOp::AND);
+            }
+        }
+
+        void parseNot(int nesting) {
+            if (nesting > FILTER_EXPRESSION_MAX_STACK) {
+                fail("expression is nested too deeply");
+            }
+            if (matchSymbol("!") || matchKeyword("not")) {
+                parseNot(nesting + 1);
+                emit(FilterOp::NOT);
+            }
+            else if (matchSymbol("(")) {
+                parseOr(nesting + 1);
+                expectSymbol(")");
+            }
+            else {
+                parseAtom();
+            }
+        }
+
+        void parseAtom() {
+            FilterAtom atom;
+            if (peekNumber()) {
+                addTalentPoints(atom, parseTalent(), 1);
+                atom.minCount = 1;
+                emitAtom(std::move(atom));
+            }
+            else if (matchKeyword("maxed")) {
+                expectSymbol("(");
+                Talent_s talent = parseTalent();
+                expectSymbol(")");
+                addTalentPoints(atom, talent, getTalentRanks(talent));
+                atom.minCount = getTalentRanks(talent);
+                emitAtom(std::move(atom));
+            }
+            else if (matchKeyword("rank")) {
+                expectSymbol("(");
+                Talent_s talent = parseTalent();
+                expectSymbol(")");
+                addTalentPoints(atom, talent, getTalentRanks(talent));
+                emitComparison(std::move(atom));
+            }
+            else if (matchKeyword("points")) {
+                expectSymbol("(");
+                if (matchKeyword("section")) {
+                    size_t sectionPos = pos;
+                    int section = parseNumber();
+                    std::set<int> pointsRequired;
+                    for (auto& indexTalentPair : tree.orderedTalents) {
+                        pointsRequired.insert(indexTalentPair.second->pointsRequired);
+                    }
+                    if (section < 1 || section > static_cast<int>(pointsRequired.size())) {
+                        pos = sectionPos;
+                        fail("section has to be between 1 and " + std::to_string(pointsRequired.size()));
+                    }
+                    int sectionPointsRequired = *std::next(pointsRequired.begin(), section - 1);
+                    for (auto& indexTalentPair : tree.orderedTalents) {
+                        if (indexTalentPair.second->pointsRequired == sectionPointsRequired) {
+                            addTalentPoints(atom, indexTalentPair.second, getTalentRanks(indexTalentPair.second));
+                        }
+                    }
+                }
+                else {
+                    for (auto& talent : parseTalentList()) {
+                        addTalentPoints(atom, talent, getTalentRanks(talent));
+                    }
+                }
+                expectSymbol(")");
+                emitComparison(std::move(atom));
+            }
+            else if (matchKeyword("atleast")) {
+                emitGroupCount(std::move(atom), true, false);
+            }
+            else if (matchKeyword("atmost")) {
+                emitGroupCount(std::move(atom), false, true);
+            }
+            else if (matchKeyword("exactly")) {
+                emitGroupCount(std::move(atom), true, true);
+            }
+            else {
+                fail("expected a talent id, maxed, rank, points, atleast, atmost or exactly");
+            }
+        }
+
+        const TalentTree& tree;
+        const std::string& source;
+        size_t pos = 0;
+        int stackSize = 0;
+        FilterExpression expression;
+    };
+
+    /*
+    Parses a filter expression for a tree (see FilterExpression for the syntax), throws std::logic_error with the position of the
+    first error for invalid expressions or unknown talents.
+    */
+    FilterExpression parseFilterExpression(const TalentTree& tree, const std::string& source) {
+        FilterExpressionParser parser(tree, source);
+        return parser.parse();
+    }
+
+    /*
+    Maps the expanded talents of an expression to the skillset index bits of a sorted DAG. Expanded talents that are not part of
+    the DAG can never be selected and are dropped.
+    */
+    template<typename IndexType>
+    BasicFilterProgram<IndexType> compileFilterProgram(const FilterExpression& expression, const TreeDAGInfo& treeDAG) {
+        std::map<int, int> expandedToPosIndexMap;
+        for (size_t i = 0; i < treeDAG.sortedTalents.size(); i++) {
+            expandedToPosIndexMap[treeDAG.sortedTalents[i]->index] = static_cast<int>(i);
+        }
+        BasicFilterProgram<IndexType> program;
+        program.code = expression.code;
+        for (const FilterAtom& atom : expression.atoms) {
+            typename BasicFilterProgram<IndexType>::Atom programAtom;
+            for (int expandedTalentIndex : atom.expandedTalentIndices) {
+                auto posIt = expandedToPosIndexMap.find(expandedTalentIndex);
+                if (posIt != expandedToPosIndexMap.end()) {
+                    setTalent(programAtom.mask, posIt->second);
+                }
+            }
+            programAtom.constantCount = atom.constantCount;
+            programAtom.minCount = atom.minCount;
+            programAtom.maxCount = atom.maxCount;
+            program.atoms.push_back(programAtom);
+        }
+        return program;
+    }
+
+    /*
+    Filters the solved skillsets with the regular filter and then with a filter expression (optional, nullptr).
+    The expression result is not kept as a filter generation so the next regular filter starts from the unfiltered generations again.
+    */
+    void filterSolvedSkillsets(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        std::shared_ptr<TalentSkillset> filter,
+        std::shared_ptr<FilterExpression> filterExpression)
+    {
+        filterSolvedSkillsets(tree, treeDAG, filter);
+        if (!filterExpression || filterExpression->code.size() == 0) {
+            return;
+        }
+        dispatchSkillsetIndexType(treeDAG->indexWords, [&](auto indexTag) {
+            using IndexType = decltype(indexTag);
+            const size_t indexWords = SkillsetIndexTraits<IndexType>::words;
+            BasicFilterProgram<IndexType> program = compileFilterProgram<IndexType>(*filterExpression, *treeDAG);
+            for (std::vector<SIND>& combinations : treeDAG->filteredCombinations) {
+                size_t survivors = 0;
+                for (size_t i = 0; i < combinations.size(); i += indexWords) {
+                    IndexType skillset = loadSkillsetIndex<IndexType>(&combinations[i]);
+                    if (program.matches(skillset)) {
+                        std::copy(combinations.begin() + i, combinations.begin() + i + indexWords, combinations.begin() + survivors);
+                        survivors += indexWords;
+                    }
+                }
+                combinations.resize(survivors);
+                combinations.shrink_to_fit();
+            }
+        });
+        treeDAG->hasCurrentFilter = false;
+    }
+
+    template BasicFilterProgram<SIND> compileFilterProgram<SIND>(const FilterExpression&, const TreeDAGInfo&);
+    template BasicFilterProgram<SIND128> compileFilterProgram<SIND128>(const FilterExpression&, const TreeDAGInfo&);
+    template BasicFilterProgram<SIND256> compileFilterProgram<SIND256>(const FilterExpression&, const TreeDAGInfo&);
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <bitset>
+#include <climits>
+#include <cstdint>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//max. number of intermediate values of a filter expression (i.e. nesting depth of and/or/not), the evaluation stack has a fixed size
+constexpr int FILTER_EXPRESSION_MAX_STACK = 64;
+
+namespace Engine {
+    enum class FilterOp : std::uint8_t {
+        ATOM, AND, OR, NOT
+    };
+
+    struct FilterInstruction {
+        FilterOp op = FilterOp::ATOM;
+        //index into the atoms of the expression/program, only used by ATOM
+        int atom = 0;
+    };
+
+    /*
+    Leaf of a filter expression: the number of selected talent points out of a set of expanded talents (every talent rank is one
+    expanded talent, see expandTreeTalents) has to be within [minCount, maxCount]. Preselected talents are not part of the solved DAG,
+    their points are already contained in constantCount.
+    */
+    struct FilterAtom {
+        std::vector<int> expandedTalentIndices;
+        int constantCount = 0;
+        int minCount = 0;
+        int maxCount = INT_MAX;
+    };
+
+    /*
+    Filter expression of a tree in postfix order, created by parseFilterExpression. Talents are referenced by their expanded index so
+    the expression is independent of the sorted DAG and the skillset index width, see compileFilterProgram.
+    Syntax (talent ids are the ids shown in the editors, section i is the i-th group of talents that share the same points required
+    gate, starting at 1 for the talents without a gate):
+        expression := term ("|" term)*                      also "or"
+        term       := factor ("&" factor)*                  also "and"
+        factor     := "!" factor | "(" expression ")" | atom   also "not"
+        atom       := id                                    talent has at least one point
+                    | "maxed(" id ")"
+                    | "rank(" id ")" compare number
+                    | "points(" ids | "section" number ")" compare number
+                    | ("atleast" | "atmost" | "exactly") "(" number "," ids ")"   number of selected talents of the group
+        compare    := ">=" | "<=" | "==" | "!=" | ">" | "<"
+    Example: "(atleast(2, 12, 15, 19) | maxed(7)) & !23 & points(section 2) >= 8"
+    */
+    struct FilterExpression {
+        std::string source;
+        std::vector<FilterInstruction> code;
+        std::vector<FilterAtom> atoms;
+        int stackDepth = 0;
+    };
+
+    static inline int countSelectedTalents(SIND talents) {
+        return static_cast<int>(std::bitset<64>(talents).count());
+    }
+    template<size_t Words>
+    static inline int countSelectedTalents(const WideSkillsetIndex<Words>& talents) {
+        int count = 0;
+        for (size_t i = 0; i < Words; i++) {
+            count += static_cast<int>(std::bitset<64>(talents.words[i]).count());
+        }
+        return count;
+    }
+
+    /*
+    Bytecode of a filter expression for a solved tree. Besides the exact check of a finished skillset it evaluates partial paths of
+    the solver kernels in three valued logic: undecided talents can still be taken (up to pointsLeft of them), so every atom is either
+    true or false for all completions or unknown. A path whose expression is already false for all completions can be pruned.
+    */
+    template<typename IndexType>
+    struct BasicFilterProgram {
+        struct Atom {
+            IndexType mask = {};
+            int constantCount = 0;
+            int minCount = 0;
+            int maxCount = INT_MAX;
+        };
+        std::vector<FilterInstruction> code;
+        std::vector<Atom> atoms;
+
+        //0 = false, 1 = true, 2 = unknown
+        std::int8_t evaluate(const IndexType& skillset, const IndexType& undecided, int pointsLeft) const {
+            std::int8_t stack[FILTER_EXPRESSION_MAX_STACK];
+            int top = 0;
+            for (const FilterInstruction& instruction : code) {
+                switch (instruction.op) {
+                case FilterOp::ATOM: {
+                    const Atom& atom = atoms[instruction.atom];
+                    int lowest = countSelectedTalents(skillset & atom.mask) + atom.constantCount;
+                    int highest = lowest;
+                    if (pointsLeft > 0) {
+                        int open = countSelectedTalents(undecided & atom.mask);
+                        highest += open < pointsLeft ? open : pointsLeft;
+                    }
+                    if (lowest >= atom.minCount && highest <= atom.maxCount) {
+                        stack[top++] = 1;
+                    }
+                    else if (highest < atom.minCount || lowest > atom.maxCount) {
+                        stack[top++] = 0;
+                    }
+                    else {
+                        stack[top++] = 2;
+                    }
+                }break;
+                case FilterOp::AND: {
+                    std::int8_t right = stack[--top];
+                    std::int8_t left = stack[top - 1];
+                    stack[top - 1] = (left == 0 || right == 0) ? 0 : ((left == 1 && right == 1) ? 1 : 2);
+                }break;
+                case FilterOp::OR: {
+                    std::int8_t right = stack[--top];
+                    std::int8_t left = stack[top - 1];
+                    stack[top - 1] = (left == 1 || right == 1) ? 1 : ((left == 0 && right == 0) ? 0 : 2);
+                }break;
+                case FilterOp::NOT: {
+                    stack[top - 1] = stack[top - 1] == 2 ? 2 : 1 - stack[top - 1];
+                }break;
+                }
+            }
+            return top > 0 ? stack[0] : 1;
+        }
+
+        bool matches(const IndexType& skillset) const {
+            return evaluate(skillset, IndexType(), 0) == 1;
+        }
+
+        bool isSatisfiable(const IndexType& skillset, const IndexType& undecided, int pointsLeft) const {
+            return evaluate(skillset, undecided, pointsLeft) != 0;
+        }
+    };
+
+    FilterExpression parseFilterExpression(const TalentTree& tree, const std::string& source);
+    template<typename IndexType = SIND>
+    BasicFilterProgram<IndexType> compileFilterProgram(const FilterExpression& expression, const TreeDAGInfo& treeDAG);
+    void filterSolvedSkillsets(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        std::shared_ptr<TalentSkillset> filter,
+        std::shared_ptr<FilterExpression> filterExpression);
+}
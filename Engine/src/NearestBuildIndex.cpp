@@ -0,0 +1,326 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "NearestBuildIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Engine {
+    static inline int countTalents(SIND bits) {
+        return static_cast<int>(std::bitset<64>(bits).count());
+    }
+
+    static inline int lowestTalentIndex(SIND bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    /*
+    Number of talent bits that differ between two skillset indices, stops counting once maxDistance is exceeded.
+    */
+    static int skillsetDistance(const SIND* a, const SIND* b, int indexWords, int maxDistance) {
+        int distance = 0;
+        for (int w = 0; w < indexWords && distance <= maxDistance; w++) {
+            distance += countTalents(a[w] ^ b[w]);
+        }
+        return distance;
+    }
+
+    //sorts by distance (stable, i.e. keeps bucket and row order for ties) and keeps the best maxResults builds
+    static void sortNearestBuilds(std::vector<NearestBuild>& builds, size_t maxResults) {
+        std::stable_sort(builds.begin(), builds.end(), [](const NearestBuild& a, const NearestBuild& b) {
+            return a.distance < b.distance;
+        });
+        if (builds.size() > maxResults) {
+            builds.resize(maxResults);
+        }
+    }
+
+    /*
+    Substring keys of about log2(rows) bits keep the row lists short, every key has to fit into a single SIND though.
+    */
+    static int computeSubstringCount(const TreeDAGInfo& treeDAG) {
+        int talentCount = static_cast<int>(treeDAG.sortedTalents.size());
+        size_t maxRowCount = 1;
+        for (auto& combinations : treeDAG.allCombinations) {
+            maxRowCount = std::max(maxRowCount, combinations.size() / treeDAG.indexWords);
+        }
+        int keyBits = 1;
+        while (keyBits < 64 && (1ULL << keyBits) < maxRowCount) {
+            keyBits++;
+        }
+        int substringCount = (talentCount + keyBits / 2) / keyBits;
+        return std::max({ substringCount, NEAREST_BUILD_MIN_SUBSTRINGS, (talentCount + 63) / 64 });
+    }
+
+    /*
+    Builds one substring table per bucket and substring, tables are distributed over threadCount threads (hardware concurrency if <= 0).
+    */
+    NearestBuildIndex::NearestBuildIndex(const TreeDAGInfo& treeDAG, int threadCount)
+        : talentCount(static_cast<int>(treeDAG.sortedTalents.size())), indexWords(treeDAG.indexWords) {
+        substringCount = computeSubstringCount(treeDAG);
+        substringBits = (talentCount + substringCount - 1) / substringCount;
+
+        std::vector<std::pair<size_t, int>> tasks;
+        tables.resize(treeDAG.allCombinations.size());
+        for (size_t b = 0; b < tables.size(); b++) {
+            if (treeDAG.allCombinations[b].size() / indexWords > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::logic_error("Nearest build index rows of a talent point bucket have to fit into 32 bits");
+            }
+            tables[b].resize(substringCount);
+            if (treeDAG.allCombinations[b].size() == 0) {
+                continue;
+            }
+            for (int s = 0; s < substringCount; s++) {
+                tasks.push_back({ b, s });
+            }
+        }
+        if (tasks.size() == 0) {
+            return;
+        }
+
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        }
+        threadCount = std::max(1, std::min(threadCount, static_cast<int>(tasks.size())));
+        std::atomic<size_t> nextTask = 0;
+        auto worker = [&]() {
+            size_t task;
+            while ((task = nextTask.fetch_add(1)) < tasks.size()) {
+                buildTable(treeDAG.allCombinations[tasks[task].first], tasks[task].second, tables[tasks[task].first][tasks[task].second]);
+            }
+        };
+        if (threadCount <= 1) {
+            worker();
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    int NearestBuildIndex::getSubstringCount() const {
+        return substringCount;
+    }
+
+    /*
+    Upper bound of getMemoryUsage of the index of a tree DAG, every row of a substring table costs a row entry and at most one key.
+    */
+    size_t NearestBuildIndex::estimateMemoryUsage(const TreeDAGInfo& treeDAG) {
+        size_t combinationCount = 0;
+        for (auto& combinations : treeDAG.allCombinations) {
+            combinationCount += combinations.size() / treeDAG.indexWords;
+        }
+        return combinationCount * static_cast<size_t>(computeSubstringCount(treeDAG)) * (sizeof(SIND) + 2 * sizeof(std::uint32_t));
+    }
+
+    size_t NearestBuildIndex::getMemoryUsage() const {
+        size_t memory = 0;
+        for (auto& bucketTables : tables) {
+            for (auto& table : bucketTables) {
+                memory += table.keys.capacity() * sizeof(SIND);
+                memory += (table.offsets.capacity() + table.rows.capacity()) * sizeof(std::uint32_t);
+            }
+        }
+        return memory;
+    }
+
+    /*
+    Gathers the bits i * substringCount + substring of a skillset index into a single key (bit i of the key).
+    */
+    SIND NearestBuildIndex::getSubstring(const SIND* skillsetIndex, int substring) const {
+        SIND key = 0;
+        for (int w = 0; w < indexWords; w++) {
+            SIND talents = skillsetIndex[w];
+            while (talents != 0) {
+                int bit = w * 64 + lowestTalentIndex(talents);
+                if (bit % substringCount == substring) {
+                    key |= 1ULL << (bit / substringCount);
+                }
+                talents &= talents - 1;
+            }
+        }
+        return key;
+    }
+
+    /*
+    Sorts the (key, row) pairs of all combinations of a bucket and compresses them into unique keys with row ranges.
+    */
+    void NearestBuildIndex::buildTable(const std::vector<SIND>& combinations, int substring, SubstringTable& table) const {
+        size_t rowCount = combinations.size() / indexWords;
+        std::vector<std::pair<SIND, std::uint32_t>> keyRows(rowCount);
+        for (size_t row = 0; row < rowCount; row++) {
+            keyRows[row] = { getSubstring(&combinations[row * indexWords], substring), static_cast<std::uint32_t>(row) };
+        }
+        std::sort(keyRows.begin(), keyRows.end());
+
+        table.rows.resize(rowCount);
+        for (size_t i = 0; i < rowCount; i++) {
+            if (i == 0 || keyRows[i].first != keyRows[i - 1].first) {
+                table.keys.push_back(keyRows[i].first);
+                table.offsets.push_back(static_cast<std::uint32_t>(i));
+            }
+            table.rows[i] = keyRows[i].second;
+        }
+        table.offsets.push_back(static_cast<std::uint32_t>(rowCount));
+        table.keys.shrink_to_fit();
+        table.offsets.shrink_to_fit();
+    }
+
+    /*
+    Appends the rows of every key within radius bits of key, bits below firstBit are not flipped again.
+    */
+    void NearestBuildIndex::probeTable(const SubstringTable& table, SIND key, int radius, int firstBit, std::vector<std::uint32_t>& candidates) const {
+        auto keyIt = std::lower_bound(table.keys.begin(), table.keys.end(), key);
+        if (keyIt != table.keys.end() && *keyIt == key) {
+            size_t k = keyIt - table.keys.begin();
+            candidates.insert(candidates.end(), table.rows.begin() + table.offsets[k], table.rows.begin() + table.offsets[k + 1]);
+        }
+        if (radius == 0) {
+            return;
+        }
+        for (int bit = firstBit; bit < substringBits; bit++) {
+            probeTable(table, key ^ (1ULL << bit), radius - 1, bit + 1, candidates);
+        }
+    }
+
+    /*
+    Returns up to maxResults solved combinations within maxDistance differing talent points of the query (sorted by distance). Buckets
+    whose point total differs by more than maxDistance from the query are skipped, other buckets only verify the candidate rows of
+    the probed substring keys.
+    */
+    std::vector<NearestBuild> NearestBuildIndex::search(const TreeDAGInfo& treeDAG, const SIND* skillsetIndex, int maxDistance, size_t maxResults) const {
+        std::vector<NearestBuild> builds;
+        if (maxDistance < 0 || maxResults == 0) {
+            return builds;
+        }
+        int queryPoints = 0;
+        for (int w = 0; w < indexWords; w++) {
+            queryPoints += countTalents(skillsetIndex[w]);
+        }
+        std::vector<SIND> queryKeys(substringCount);
+        for (int s = 0; s < substringCount; s++) {
+            queryKeys[s] = getSubstring(skillsetIndex, s);
+        }
+        int radius = maxDistance / substringCount;
+
+        std::vector<std::uint32_t> candidates;
+        for (size_t b = 0; b < tables.size(); b++) {
+            int talentPoints = static_cast<int>(b) + 1;
+            if (std::abs(talentPoints - queryPoints) > maxDistance || treeDAG.allCombinations[b].size() == 0) {
+                continue;
+            }
+            candidates.clear();
+            for (int s = 0; s < substringCount; s++) {
+                probeTable(tables[b][s], queryKeys[s], radius, 0, candidates);
+            }
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            for (std::uint32_t row : candidates) {
+                const SIND* combination = &treeDAG.allCombinations[b][static_cast<size_t>(row) * indexWords];
+                int distance = skillsetDistance(skillsetIndex, combination, indexWords, maxDistance);
+                if (distance <= maxDistance) {
+                    builds.push_back({ std::vector<SIND>(combination, combination + indexWords), talentPoints, distance });
+                }
+            }
+        }
+        sortNearestBuilds(builds, maxResults);
+        return builds;
+    }
+
+    /*
+    Creates the nearest build index of a solved tree DAG unless it has too many combinations or the index doesn't fit into the memory
+    budget next to the combinations (see getSolverMemoryBudget). The index is published atomically, so it can be created on a
+    background thread while findNearestBuilds is used on the tree DAG.
+    */
+    void createNearestBuildIndex(std::shared_ptr<TreeDAGInfo> treeDAG, int threadCount) {
+        size_t combinationCount = 0;
+        for (auto& combinations : treeDAG->allCombinations) {
+            combinationCount += combinations.size() / treeDAG->indexWords;
+        }
+        if (combinationCount > NEAREST_BUILD_COMBINATION_LIMIT
+            || combinationCount * treeDAG->indexWords * sizeof(SIND) + NearestBuildIndex::estimateMemoryUsage(*treeDAG) > getSolverMemoryBudget()) {
+            return;
+        }
+        std::atomic_store(&treeDAG->nearestBuildIndex, std::make_shared<const NearestBuildIndex>(*treeDAG, threadCount));
+    }
+
+    /*
+    Finds the valid builds of a solved tree that are closest to a (possibly invalid) skillset, e.g. to suggest legal builds for an
+    imported loadout. Trees without a nearest build index (not created yet or too large, see createNearestBuildIndex) are scanned
+    linearly.
+    */
+    std::vector<NearestBuild> findNearestBuilds(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        std::shared_ptr<TalentSkillset> skillset,
+        int maxDistance,
+        size_t maxResults)
+    {
+        std::vector<NearestBuild> builds;
+        if (!treeDAG || !skillset || maxDistance < 0 || maxResults == 0) {
+            return builds;
+        }
+        std::vector<SIND> skillsetIndex = skillsetToSkillsetIndex(tree, *treeDAG, skillset);
+        std::shared_ptr<const NearestBuildIndex> nearestBuildIndex = std::atomic_load(&treeDAG->nearestBuildIndex);
+        if (nearestBuildIndex) {
+            return nearestBuildIndex->search(*treeDAG, skillsetIndex.data(), maxDistance, maxResults);
+        }
+
+        int queryPoints = 0;
+        for (SIND word : skillsetIndex) {
+            queryPoints += countTalents(word);
+        }
+        for (size_t b = 0; b < treeDAG->allCombinations.size(); b++) {
+            int talentPoints = static_cast<int>(b) + 1;
+            if (std::abs(talentPoints - queryPoints) > maxDistance) {
+                continue;
+            }
+            const std::vector<SIND>& combinations = treeDAG->allCombinations[b];
+            for (size_t i = 0; i < combinations.size(); i += treeDAG->indexWords) {
+                int distance = skillsetDistance(skillsetIndex.data(), &combinations[i], treeDAG->indexWords, maxDistance);
+                if (distance <= maxDistance) {
+                    builds.push_back({ std::vector<SIND>(&combinations[i], &combinations[i] + treeDAG->indexWords), talentPoints, distance });
+                }
+            }
+        }
+        sortNearestBuilds(builds, maxResults);
+        return builds;
+    }
+}
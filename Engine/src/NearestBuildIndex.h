@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//minimum number of substrings a skillset index is split into, queries probe all keys within maxDistance / substrings bits
+constexpr int NEAREST_BUILD_MIN_SUBSTRINGS = 2;
+//solves with more combinations than this don't get a nearest build index (one row entry per substring and combination)
+constexpr size_t NEAREST_BUILD_COMBINATION_LIMIT = 100000000;
+
+namespace Engine {
+    /*
+    Valid build found by findNearestBuilds, distance is the number of talent points (bits) that differ from the query.
+    */
+    struct NearestBuild {
+        std::vector<SIND> skillsetIndex;
+        int talentPoints = 0;
+        int distance = 0;
+    };
+
+    /*
+    Multi-index hashing over the solved combinations of a TreeDAGInfo: every skillset index is split into m interleaved substrings
+    of about log2(rows) bits (bit i belongs to substring i % m) and every substring gets a sorted key table with the rows (index into
+    allCombinations[bucket]) that share the key. Two skillsets within distance k agree on at least one substring up to floor(k / m)
+    bits (pigeonhole), so a query only probes the keys within that radius of its own substrings and verifies the candidate rows.
+    */
+    class NearestBuildIndex {
+    public:
+        NearestBuildIndex(const TreeDAGInfo& treeDAG, int threadCount = 0);
+
+        int getSubstringCount() const;
+        size_t getMemoryUsage() const;
+        static size_t estimateMemoryUsage(const TreeDAGInfo& treeDAG);
+
+        std::vector<NearestBuild> search(const TreeDAGInfo& treeDAG, const SIND* skillsetIndex, int maxDistance, size_t maxResults) const;
+
+    private:
+        struct SubstringTable {
+            std::vector<SIND> keys;
+            //rows of keys[i] are rows[offsets[i]] to rows[offsets[i + 1]]
+            std::vector<std::uint32_t> offsets;
+            std::vector<std::uint32_t> rows;
+        };
+
+        SIND getSubstring(const SIND* skillsetIndex, int substring) const;
+        void buildTable(const std::vector<SIND>& combinations, int substring, SubstringTable& table) const;
+        void probeTable(const SubstringTable& table, SIND key, int radius, int firstBit, std::vector<std::uint32_t>& candidates) const;
+
+        int talentCount = 0;
+        int indexWords = 1;
+        int substringCount = NEAREST_BUILD_MIN_SUBSTRINGS;
+        int substringBits = 0;
+        //tables[bucket][substring]
+        std::vector<std::vector<SubstringTable>> tables;
+    };
+
+    void createNearestBuildIndex(std::shared_ptr<TreeDAGInfo> treeDAG, int threadCount = 0);
+    std::vector<NearestBuild> findNearestBuilds(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        std::shared_ptr<TalentSkillset> skillset,
+        int maxDistance,
+        size_t maxResults);
+}
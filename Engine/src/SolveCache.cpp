@@ -0,0 +1,478 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "SolveCache.h"
+#include "CombinationStore.h"
+#include "CombinationBitmapIndex.h"
+#include "FilterExpression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace Engine {
+    static std::atomic<bool> solveCacheEnabled = true;
+    static std::atomic<std::uintmax_t> solveCacheDiskBudget = SOLVE_CACHE_DEFAULT_DISK_BUDGET;
+    //serializes committing and evicting entries of solves that finish at the same time (e.g. multiple trees in the GUI), entries are written outside of it
+    static std::mutex solveCacheMutex;
+
+    void setSolveCacheEnabled(bool enabled) {
+        solveCacheEnabled = enabled;
+    }
+
+    bool isSolveCacheEnabled() {
+        return solveCacheEnabled;
+    }
+
+    void setSolveCacheDiskBudget(std::uintmax_t diskBudget) {
+        solveCacheDiskBudget = diskBudget;
+    }
+
+    std::uintmax_t getSolveCacheDiskBudget() {
+        return solveCacheDiskBudget;
+    }
+
+    std::filesystem::path getSolveCacheDirectory() {
+        return Presets::getAppPath() / "cache";
+    }
+
+    static std::filesystem::path getSolveCacheEntryPath(const std::string& key) {
+        return getSolveCacheDirectory() / (key + ".ttmc");
+    }
+
+    /*
+    Total size of all cache entries in bytes.
+    */
+    std::uintmax_t getSolveCacheSize() {
+        std::error_code ec;
+        std::uintmax_t size = 0;
+        for (auto& entry : std::filesystem::directory_iterator(getSolveCacheDirectory(), ec)) {
+            if (entry.path().extension() == ".ttmc") {
+                std::uintmax_t fileSize = entry.file_size(ec);
+                size += ec ? 0 : fileSize;
+            }
+        }
+        return size;
+    }
+
+    void clearSolveCache() {
+        std::lock_guard<std::mutex> lock(solveCacheMutex);
+        std::error_code ec;
+        for (auto& entry : std::filesystem::directory_iterator(getSolveCacheDirectory(), ec)) {
+            if (entry.path().extension() == ".ttmc") {
+                std::filesystem::remove(entry.path(), ec);
+            }
+        }
+    }
+
+    /*
+    Removes the least recently used entries (oldest modification time, hits touch their entry) until the cache fits into diskBudget.
+    Entries that can't be removed (e.g. currently mapped by a reader on Windows) are skipped.
+    */
+    static void evictSolveCacheLocked(std::uintmax_t diskBudget) {
+        struct CacheEntry {
+            std::filesystem::path path;
+            std::uintmax_t size;
+            std::filesystem::file_time_type lastUsed;
+        };
+        std::error_code ec;
+        std::vector<CacheEntry> entries;
+        std::uintmax_t cacheSize = 0;
+        for (auto& entry : std::filesystem::directory_iterator(getSolveCacheDirectory(), ec)) {
+            if (entry.path().extension() != ".ttmc") {
+                continue;
+            }
+            CacheEntry cacheEntry;
+            cacheEntry.path = entry.path();
+            cacheEntry.size = entry.file_size(ec);
+            if (ec) {
+                continue;
+            }
+            cacheEntry.lastUsed = entry.last_write_time(ec);
+            if (ec) {
+                continue;
+            }
+            cacheSize += cacheEntry.size;
+            entries.push_back(cacheEntry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) {
+            return a.lastUsed < b.lastUsed;
+        });
+        for (auto& entry : entries) {
+            if (cacheSize <= diskBudget) {
+                break;
+            }
+            if (std::filesystem::remove(entry.path, ec)) {
+                cacheSize -= entry.size;
+            }
+        }
+    }
+
+    void evictSolveCache(std::uintmax_t diskBudget) {
+        std::lock_guard<std::mutex> lock(solveCacheMutex);
+        evictSolveCacheLocked(diskBudget);
+    }
+
+    /*
+    Two 64 bit FNV-1a hashes with different offset bases over the same values, combined into a 128 bit hex key.
+    */
+    class SolveCacheHasher {
+    public:
+        void add(std::int64_t value) {
+            std::uint64_t bits = static_cast<std::uint64_t>(value);
+            for (int i = 0; i < 8; i++) {
+                unsigned char byte = static_cast<unsigned char>(bits >> (8 * i));
+                first = (first ^ byte) * 1099511628211ULL;
+                second = (second ^ byte) * 1099511628211ULL;
+            }
+        }
+        void add(const std::vector<int>& values) {
+            add(static_cast<std::int64_t>(values.size()));
+            for (int value : values) {
+                add(value);
+            }
+        }
+        std::string getKey() const {
+            char key[33];
+            std::snprintf(key, sizeof(key), "%016llx%016llx", static_cast<unsigned long long>(first), static_cast<unsigned long long>(second));
+            return std::string(key);
+        }
+
+    private:
+        std::uint64_t first = 14695981039346656037ULL;
+        std::uint64_t second = 9650029242287828579ULL;
+    };
+
+    /*
+    Canonical key of a solve: everything the solvers read from the sorted minimal DAG (talent order, expanded talent indices,
+    point requirements and the weighted child lists) plus talent points limit, solve mode and the filter as skillset index bits.
+    */
+    std::string createSolveCacheKey(
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TalentSkillset> filter,
+        const FilterExpression* filterExpression
+    ) {
+        SolveCacheHasher hasher;
+        hasher.add(SOLVE_CACHE_VERSION);
+        hasher.add(sortedTreeDAG.indexWords);
+        hasher.add(static_cast<std::int64_t>(sortedTreeDAG.sortedTalents.size()));
+        for (size_t i = 0; i < sortedTreeDAG.sortedTalents.size(); i++) {
+            hasher.add(sortedTreeDAG.sortedTalents[i]->index);
+            hasher.add(sortedTreeDAG.sortedTalents[i]->pointsRequired);
+            hasher.add(static_cast<std::int64_t>(sortedTreeDAG.sortedTalents[i]->type));
+            hasher.add(sortedTreeDAG.minimalTreeDAG[i]);
+        }
+        hasher.add(sortedTreeDAG.rootIndices);
+        hasher.add(talentPointsLimit);
+        hasher.add(onlyLimitSolve ? 1 : 0);
+
+        CombinationFilterBits filterBits = createCombinationFilterBits(tree, sortedTreeDAG, filter);
+        hasher.add(filterBits.includeBits);
+        hasher.add(filterBits.excludeBits);
+        hasher.add(filterBits.orBits);
+        hasher.add(static_cast<std::int64_t>(filterBits.oneBits.size()));
+        for (auto& groupBits : filterBits.oneBits) {
+            hasher.add(groupBits.first);
+            hasher.add(groupBits.second);
+        }
+        if (filterExpression != nullptr) {
+            hasher.add(static_cast<std::int64_t>(filterExpression->code.size()));
+            for (const FilterInstruction& instruction : filterExpression->code) {
+                hasher.add(static_cast<std::int64_t>(instruction.op));
+                hasher.add(instruction.atom);
+            }
+            for (const FilterAtom& atom : filterExpression->atoms) {
+                hasher.add(atom.expandedTalentIndices);
+                hasher.add(atom.constantCount);
+                hasher.add(atom.minCount);
+                hasher.add(atom.maxCount);
+            }
+        }
+        return hasher.getKey();
+    }
+
+    /*
+    Opens a cache entry and checks that it belongs to the DAG (guards against hash collisions and stale entries),
+    returns nullptr if there is no usable entry.
+    */
+    static std::unique_ptr<CombinationStoreReader> openSolveCacheEntry(const std::string& key, const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit) {
+        if (!isSolveCacheEnabled()) {
+            return nullptr;
+        }
+        std::filesystem::path path = getSolveCacheEntryPath(key);
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec)) {
+            return nullptr;
+        }
+        try {
+            std::unique_ptr<CombinationStoreReader> reader = std::make_unique<CombinationStoreReader>(path);
+            const CombinationStoreMetadata& metadata = reader->getMetadata();
+            if (reader->getIndexWords() != sortedTreeDAG.indexWords
+                || metadata.talentPointsLimit != talentPointsLimit
+                || metadata.safetyGuardTriggered
+                || metadata.sortedTalentIndices.size() != sortedTreeDAG.sortedTalents.size()) {
+                return nullptr;
+            }
+            for (size_t i = 0; i < sortedTreeDAG.sortedTalents.size(); i++) {
+                if (metadata.sortedTalentIndices[i] != sortedTreeDAG.sortedTalents[i]->index) {
+                    return nullptr;
+                }
+            }
+            for (size_t bucket = 0; bucket < reader->getBucketCount(); bucket++) {
+                int talentPoints = reader->getBucketTalentPoints(bucket);
+                if (talentPoints < 1 || talentPoints > talentPointsLimit) {
+                    return nullptr;
+                }
+            }
+            //touch the entry for the LRU eviction
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+            return reader;
+        }
+        catch (std::exception&) {
+            return nullptr;
+        }
+    }
+
+    /*
+    Loads the combinations of a cached solve, combinations[i] holds the combinations with i + 1 talent points (in solver order).
+    Returns false if the solve is not cached.
+    */
+    bool loadSolveCache(const std::string& key, const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit, vec2d<SIND>& combinations) {
+        std::unique_ptr<CombinationStoreReader> reader = openSolveCacheEntry(key, sortedTreeDAG, talentPointsLimit);
+        if (!reader) {
+            return false;
+        }
+        try {
+            vec2d<SIND> cachedCombinations(talentPointsLimit);
+            for (size_t bucket = 0; bucket < reader->getBucketCount(); bucket++) {
+                reader->readBucket(bucket, cachedCombinations[reader->getBucketTalentPoints(bucket) - 1]);
+            }
+            combinations = std::move(cachedCombinations);
+            return true;
+        }
+        catch (std::exception&) {
+            return false;
+        }
+    }
+
+    /*
+    Pushes the combinations of a cached solve to the sink of a streaming solve (sink.begin/finish are called by the solver).
+    Returns false without pushing anything if the solve is not cached.
+    */
+    bool replaySolveCache(const std::string& key, const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit, CombinationSink& sink, size_t& runningCount, bool& safetyGuardTriggered) {
+        std::unique_ptr<CombinationStoreReader> reader = openSolveCacheEntry(key, sortedTreeDAG, talentPointsLimit);
+        if (!reader) {
+            return false;
+        }
+        for (size_t bucket = 0; bucket < reader->getBucketCount(); bucket++) {
+            size_t count = reader->getCombinationCount(bucket);
+            for (size_t first = 0; first < count; first += SOLVER_STREAM_BLOCK_SIZE) {
+                if (safetyGuardTriggered) {
+                    return true;
+                }
+                CombinationBlock block;
+                block.talentPoints = reader->getBucketTalentPoints(bucket);
+                block.indexWords = sortedTreeDAG.indexWords;
+                reader->readCombinations(bucket, first, std::min(SOLVER_STREAM_BLOCK_SIZE, count - first), block.combinations);
+                runningCount += block.combinations.size() / block.indexWords;
+                if (!sink.push(block)) {
+                    safetyGuardTriggered = true;
+                    return true;
+                }
+            }
+        }
+        return true;
+    }
+
+    /*
+    Temporary path an entry is written to before it's renamed, unique so solves with the same key can write at the same time.
+    */
+    static std::filesystem::path createSolveCacheTempPath(const std::string& key) {
+        static std::atomic<size_t> tempCount = 0;
+        std::filesystem::path tempPath = getSolveCacheEntryPath(key);
+        tempPath += "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())
+            + "_" + std::to_string(tempCount.fetch_add(1)) + ".tmp";
+        return tempPath;
+    }
+
+    /*
+    Renames a completely written entry to its final path and evicts old entries afterwards, only this takes the cache lock.
+    */
+    static void commitSolveCacheEntry(const std::string& key, const std::filesystem::path& tempPath) {
+        std::lock_guard<std::mutex> lock(solveCacheMutex);
+        std::error_code ec;
+        std::filesystem::rename(tempPath, getSolveCacheEntryPath(key), ec);
+        if (ec) {
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        evictSolveCacheLocked(getSolveCacheDiskBudget());
+    }
+
+    /*
+    Stores the combinations of a completed solve (combinations[i] holds the combinations with i + 1 talent points) in solver order
+    and evicts old entries afterwards. The entry is written to a temporary file first so readers never see partially written entries.
+    */
+    void storeSolveCache(
+        const std::string& key,
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        const vec2d<SIND>& combinations
+    ) {
+        if (!isSolveCacheEnabled() || sortedTreeDAG.safetyGuardTriggered) {
+            return;
+        }
+        std::filesystem::path tempPath = createSolveCacheTempPath(key);
+        try {
+            CombinationStoreWriter writer(tempPath, createCombinationStoreMetadata(tree, sortedTreeDAG, talentPointsLimit, onlyLimitSolve));
+            for (int i = 0; i < talentPointsLimit && i < static_cast<int>(combinations.size()); i++) {
+                if (onlyLimitSolve && i + 1 != talentPointsLimit) {
+                    continue;
+                }
+                writer.writeUnsortedBucket(i + 1, combinations[i]);
+            }
+            writer.finish();
+        }
+        catch (std::exception&) {
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        commitSolveCacheEntry(key, tempPath);
+    }
+
+    SolveCacheSink::SolveCacheSink(const std::string& key, const TalentTree& tree, int talentPointsLimit, bool onlyLimitSolve, CombinationSink& target)
+        : key(key), tree(tree), talentPointsLimit(talentPointsLimit), onlyLimitSolve(onlyLimitSolve), target(target) {
+    }
+
+    SolveCacheSink::~SolveCacheSink() {
+        discardEntry();
+    }
+
+    void SolveCacheSink::begin(const TreeDAGInfo& treeDAG) {
+        discardEntry();
+        overflow = !isSolveCacheEnabled();
+        memoryBudget = getSolverMemoryBudget();
+        bufferedSINDs = 0;
+        buckets.clear();
+        if (!overflow && onlyLimitSolve) {
+            try {
+                tempPath = createSolveCacheTempPath(key);
+                writer = std::make_unique<CombinationStoreWriter>(tempPath, createCombinationStoreMetadata(tree, treeDAG, talentPointsLimit, true));
+                writer->beginBucket(talentPointsLimit, false);
+            }
+            catch (std::exception&) {
+                discardEntry();
+                overflow = true;
+            }
+        }
+        else if (!overflow) {
+            buckets.resize(talentPointsLimit);
+        }
+        target.begin(treeDAG);
+    }
+
+    bool SolveCacheSink::push(CombinationBlock& block) {
+        {
+            std::lock_guard<std::mutex> lock(bucketMutex);
+            if (!overflow && writer) {
+                if (block.talentPoints == talentPointsLimit) {
+                    //entries beyond the disk budget would be evicted right away
+                    bufferedSINDs += block.combinations.size();
+                    try {
+                        if (bufferedSINDs * sizeof(SIND) > getSolveCacheDiskBudget()) {
+                            overflow = true;
+                            discardEntry();
+                        }
+                        else {
+                            writer->appendCombinations(block.combinations.data(), block.combinations.size() / block.indexWords);
+                        }
+                    }
+                    catch (std::exception&) {
+                        overflow = true;
+                    }
+                }
+            }
+            else if (!overflow) {
+                bufferedSINDs += block.combinations.size();
+                if (bufferedSINDs * sizeof(SIND) > memoryBudget) {
+                    overflow = true;
+                    vec2d<SIND>().swap(buckets);
+                }
+                else {
+                    std::vector<SIND>& bucket = buckets[block.talentPoints - 1];
+                    bucket.insert(bucket.end(), block.combinations.begin(), block.combinations.end());
+                }
+            }
+        }
+        return target.push(block);
+    }
+
+    void SolveCacheSink::finish() {
+        target.finish();
+    }
+
+    void SolveCacheSink::store(const TreeDAGInfo& treeDAG) {
+        if (overflow || treeDAG.safetyGuardTriggered) {
+            discardEntry();
+        }
+        else if (writer) {
+            try {
+                writer->finish();
+                writer.reset();
+                commitSolveCacheEntry(key, tempPath);
+                tempPath.clear();
+            }
+            catch (std::exception&) {
+                discardEntry();
+            }
+        }
+        else {
+            storeSolveCache(key, tree, treeDAG, talentPointsLimit, onlyLimitSolve, buckets);
+        }
+        vec2d<SIND>().swap(buckets);
+    }
+
+    /*
+    Removes the temporary entry of an only limit solve that won't be committed.
+    */
+    void SolveCacheSink::discardEntry() {
+        if (writer) {
+            try {
+                writer->finish();
+            }
+            catch (std::exception&) {
+            }
+            writer.reset();
+        }
+        if (!tempPath.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            tempPath.clear();
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <mutex>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//default disk budget of the solve cache, least recently used entries are evicted when the cache grows beyond it
+constexpr std::uintmax_t SOLVE_CACHE_DEFAULT_DISK_BUDGET = 2147483648;
+//part of every cache key, has to be incremented whenever solver output for the same key could change
+//(version 2 keeps combinations in solver order instead of sorting them)
+constexpr std::uint32_t SOLVE_CACHE_VERSION = 2;
+
+namespace Engine {
+    class CombinationStoreWriter;
+
+    /*
+    Content addressed cache of solve results in Presets::getAppPath() / "cache". Entries are combination stores (see CombinationStore.h)
+    named after createSolveCacheKey, which hashes the sorted minimal DAG of the expanded tree together with the talent points limit,
+    the solve mode and the filter (and filter expression), so presets with the same structure share entries regardless of name or talent descriptions.
+    Entries keep the combinations in the order the solver produced them, so cached solves return the same order as fresh ones.
+    Entries are touched on every hit and the least recently used ones are evicted when the cache exceeds its disk budget.
+    Solves that were canceled or hit the safety guard are never cached. Cache errors never fail a solve, the solve just runs uncached.
+    */
+    void setSolveCacheEnabled(bool enabled);
+    bool isSolveCacheEnabled();
+    void setSolveCacheDiskBudget(std::uintmax_t diskBudget);
+    std::uintmax_t getSolveCacheDiskBudget();
+    std::filesystem::path getSolveCacheDirectory();
+    std::uintmax_t getSolveCacheSize();
+    void clearSolveCache();
+    void evictSolveCache(std::uintmax_t diskBudget);
+
+    std::string createSolveCacheKey(
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TalentSkillset> filter,
+        const FilterExpression* filterExpression = nullptr);
+    bool loadSolveCache(const std::string& key, const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit, vec2d<SIND>& combinations);
+    bool replaySolveCache(const std::string& key, const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit, CombinationSink& sink, size_t& runningCount, bool& safetyGuardTriggered);
+    void storeSolveCache(
+        const std::string& key,
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        const vec2d<SIND>& combinations);
+
+    /*
+    Forwards a streaming solve to the target sink and puts the combinations into the solve cache, store() commits the entry after the
+    solve completed. Only limit solves write the single bucket into a temporary entry right away, so memory usage stays constant.
+    Solves with all buckets have to collect the combinations since the solver pushes the buckets interleaved, collecting stops
+    (without influencing the solve) once the collected combinations exceed the memory budget (getSolverMemoryBudget).
+    */
+    class SolveCacheSink : public CombinationSink {
+    public:
+        SolveCacheSink(const std::string& key, const TalentTree& tree, int talentPointsLimit, bool onlyLimitSolve, CombinationSink& target);
+        ~SolveCacheSink();
+        void begin(const TreeDAGInfo& treeDAG) override;
+        bool push(CombinationBlock& block) override;
+        void finish() override;
+        void store(const TreeDAGInfo& treeDAG);
+
+    private:
+        void discardEntry();
+
+        std::string key;
+        const TalentTree& tree;
+        int talentPointsLimit;
+        bool onlyLimitSolve;
+        CombinationSink& target;
+        bool overflow = false;
+        size_t memoryBudget = 0;
+        size_t bufferedSINDs = 0;
+        vec2d<SIND> buckets;
+        //incrementally written entry of only limit solves
+        std::unique_ptr<CombinationStoreWriter> writer;
+        std::filesystem::path tempPath;
+        std::mutex bucketMutex;
+    };
+}
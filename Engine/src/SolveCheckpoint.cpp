@@ -0,0 +1,332 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "SolveCheckpoint.h"
+#include "SolveCache.h"
+
+#include <cstring>
+
+namespace Engine {
+    static const char SOLVE_CHECKPOINT_MAGIC[8] = { 'T', 'T', 'M', 'C', 'K', 'P', 'T', '\0' };
+    static const std::uint32_t SOLVE_CHECKPOINT_RECORD_MAGIC = 0x5443524bu;
+
+    /*
+    Byte buffer of a checkpoint header/record, every value is stored in native byte order (checkpoints are never shared between machines).
+    */
+    class CheckpointWriter {
+    public:
+        template<typename T>
+        void write(const T& value) {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+        void write(const SIND* values, size_t count) {
+            const char* bytes = reinterpret_cast<const char*>(values);
+            buffer.insert(buffer.end(), bytes, bytes + count * sizeof(SIND));
+        }
+        std::uint64_t checksum() const {
+            std::uint64_t hash = 14695981039346656037ULL;
+            for (char byte : buffer) {
+                hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        std::vector<char> buffer;
+    };
+
+    class CheckpointReader {
+    public:
+        explicit CheckpointReader(const std::vector<char>& buffer) : buffer(buffer) {}
+
+        template<typename T>
+        bool read(T& value) {
+            if (buffer.size() - position < sizeof(T)) {
+                return false;
+            }
+            std::memcpy(&value, buffer.data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+        bool read(std::vector<SIND>& values, std::uint64_t count) {
+            if ((buffer.size() - position) / sizeof(SIND) < count) {
+                return false;
+            }
+            size_t offset = values.size();
+            values.resize(offset + count);
+            std::memcpy(values.data() + offset, buffer.data() + position, count * sizeof(SIND));
+            position += count * sizeof(SIND);
+            return true;
+        }
+        std::uint64_t checksum(size_t begin) const {
+            std::uint64_t hash = 14695981039346656037ULL;
+            for (size_t i = begin; i < position; i++) {
+                hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        const std::vector<char>& buffer;
+        size_t position = 0;
+    };
+
+    SolveCheckpoint::SolveCheckpoint(const std::filesystem::path& path, bool resume, double interval)
+        : path(path), resume(resume), interval(interval), startTime(std::chrono::steady_clock::now()) {}
+
+    const std::filesystem::path& SolveCheckpoint::getPath() const {
+        return path;
+    }
+
+    double SolveCheckpoint::getInterval() const {
+        return interval;
+    }
+
+    bool SolveCheckpoint::isResumed() const {
+        return resumed;
+    }
+
+    void SolveCheckpoint::setKey(const std::string& key) {
+        this->key = key;
+    }
+
+    bool SolveCheckpoint::start(const std::vector<std::int64_t>& layout) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        this->layout = layout;
+        startTime = std::chrono::steady_clock::now();
+        resumed = false;
+        failed = false;
+        tasks.clear();
+        if (resume && !key.empty() && load()) {
+            file.open(path, std::ios::binary | std::ios::app);
+            resumed = true;
+            failed = !file;
+            return true;
+        }
+        //stale checkpoint of another solve, the new one is only written once this solve runs long enough
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    std::unique_ptr<SolveCheckpointTask> SolveCheckpoint::takeTask(size_t task) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        auto it = tasks.find(task);
+        if (it == tasks.end()) {
+            return nullptr;
+        }
+        std::unique_ptr<SolveCheckpointTask> state = std::make_unique<SolveCheckpointTask>(std::move(it->second));
+        tasks.erase(it);
+        return state;
+    }
+
+    void SolveCheckpoint::appendTask(size_t task, bool finished, const std::vector<SIND>& frames, const vec2d<SIND>& combinations, const std::vector<size_t>& savedSizes) {
+        if (key.empty() || failed || !isActive()) {
+            return;
+        }
+        CheckpointWriter record;
+        record.write(SOLVE_CHECKPOINT_RECORD_MAGIC);
+        record.write(static_cast<std::uint64_t>(task));
+        record.write(static_cast<std::uint8_t>(finished ? 1 : 0));
+        record.write(static_cast<std::uint64_t>(frames.size()));
+        record.write(static_cast<std::uint64_t>(combinations.size()));
+        for (size_t i = 0; i < combinations.size(); i++) {
+            record.write(static_cast<std::uint64_t>(combinations[i].size() - savedSizes[i]));
+        }
+        record.write(frames.data(), frames.size());
+        for (size_t i = 0; i < combinations.size(); i++) {
+            record.write(combinations[i].data() + savedSizes[i], combinations[i].size() - savedSizes[i]);
+        }
+        record.write(record.checksum());
+
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (failed) {
+            return;
+        }
+        if (!file.is_open()) {
+            writeHeader();
+            if (failed) {
+                return;
+            }
+        }
+        file.write(record.buffer.data(), record.buffer.size());
+        file.flush();
+        failed = !file;
+    }
+
+    void SolveCheckpoint::remove() {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (file.is_open()) {
+            file.close();
+        }
+        tasks.clear();
+        failed = true;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    bool SolveCheckpoint::isActive() const {
+        return resumed || std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() >= interval;
+    }
+
+    void SolveCheckpoint::writeHeader() {
+        CheckpointWriter header;
+        for (char c : SOLVE_CHECKPOINT_MAGIC) {
+            header.write(c);
+        }
+        header.write(SOLVE_CHECKPOINT_VERSION);
+        header.write(static_cast<std::uint64_t>(key.size()));
+        for (char c : key) {
+            header.write(c);
+        }
+        header.write(static_cast<std::uint64_t>(layout.size()));
+        for (std::int64_t value : layout) {
+            header.write(value);
+        }
+        header.write(header.checksum());
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (file) {
+            file.write(header.buffer.data(), header.buffer.size());
+            file.flush();
+        }
+        failed = !file;
+    }
+
+    /*
+    Reads the header and every complete record of the checkpoint file, a torn or corrupt tail (crash while writing) is cut off so new
+    records are appended behind the last valid one. Returns false if the file doesn't exist or belongs to a different solve.
+    */
+    bool SolveCheckpoint::load() {
+        std::ifstream input(path, std::ios::binary | std::ios::ate);
+        if (!input) {
+            return false;
+        }
+        std::vector<char> buffer(static_cast<size_t>(input.tellg()));
+        input.seekg(0);
+        if (!input.read(buffer.data(), buffer.size())) {
+            return false;
+        }
+        input.close();
+
+        CheckpointReader reader(buffer);
+        char magic[8];
+        std::uint32_t version = 0;
+        std::uint64_t keySize = 0;
+        for (char& c : magic) {
+            if (!reader.read(c)) {
+                return false;
+            }
+        }
+        if (std::memcmp(magic, SOLVE_CHECKPOINT_MAGIC, sizeof(magic)) != 0 || !reader.read(version) || version != SOLVE_CHECKPOINT_VERSION
+            || !reader.read(keySize) || keySize != key.size()) {
+            return false;
+        }
+        std::string fileKey(key.size(), '\0');
+        for (char& c : fileKey) {
+            reader.read(c);
+        }
+        std::uint64_t layoutSize = 0;
+        if (fileKey != key || !reader.read(layoutSize) || layoutSize != layout.size()) {
+            return false;
+        }
+        for (std::int64_t value : layout) {
+            std::int64_t fileValue = 0;
+            if (!reader.read(fileValue) || fileValue != value) {
+                return false;
+            }
+        }
+        std::uint64_t checksum = 0;
+        std::uint64_t expectedChecksum = reader.checksum(0);
+        if (!reader.read(checksum) || checksum != expectedChecksum) {
+            return false;
+        }
+
+        size_t validSize = reader.position;
+        while (reader.position < buffer.size()) {
+            size_t begin = reader.position;
+            std::uint32_t recordMagic = 0;
+            std::uint64_t task = 0;
+            std::uint8_t finished = 0;
+            std::uint64_t frameCount = 0;
+            std::uint64_t bucketCount = 0;
+            if (!reader.read(recordMagic) || recordMagic != SOLVE_CHECKPOINT_RECORD_MAGIC || !reader.read(task) || !reader.read(finished)
+                || !reader.read(frameCount) || !reader.read(bucketCount) || bucketCount > (buffer.size() - reader.position) / sizeof(std::uint64_t)) {
+                break;
+            }
+            std::vector<std::uint64_t> counts(bucketCount);
+            bool complete = true;
+            for (std::uint64_t& count : counts) {
+                complete = complete && reader.read(count);
+            }
+            std::vector<SIND> frames;
+            complete = complete && reader.read(frames, frameCount);
+            vec2d<SIND> combinations(bucketCount);
+            for (size_t i = 0; i < bucketCount && complete; i++) {
+                complete = reader.read(combinations[i], counts[i]);
+            }
+            expectedChecksum = reader.checksum(begin);
+            if (!complete || !reader.read(checksum) || checksum != expectedChecksum) {
+                break;
+            }
+
+            SolveCheckpointTask& state = tasks[task];
+            if (state.combinations.size() < bucketCount) {
+                state.combinations.resize(bucketCount);
+            }
+            for (size_t i = 0; i < bucketCount; i++) {
+                state.combinations[i].insert(state.combinations[i].end(), combinations[i].begin(), combinations[i].end());
+            }
+            state.frames = std::move(frames);
+            state.finished = finished != 0;
+            validSize = reader.position;
+        }
+        if (validSize < buffer.size()) {
+            std::error_code error;
+            std::filesystem::resize_file(path, validSize, error);
+            if (error) {
+                tasks.clear();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /*
+    Checkpoint files are named after the solve cache key of the solve (see createSolveCacheKey), so trees with the same name but a
+    different structure, talent points limit, solve mode or filter never share a checkpoint.
+    */
+    std::filesystem::path getSolveCheckpointPath(
+        TalentTree tree,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TalentSkillset> filter,
+        const FilterExpression* filterExpression
+    ) {
+        //same sorted minimal DAG as the solvers create
+        TalentTree processedTree = parseTree(createTreeStringRepresentation(tree));
+        expandTreeTalents(processedTree);
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        std::string key = createSolveCacheKey(tree, sortedTreeDAG, talentPointsLimit, onlyLimitSolve, filter, filterExpression);
+        return Presets::getAppPath() / "checkpoints" / (key + ".ttmk");
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+//default number of seconds a solve runs before its first checkpoint and between two checkpoints of a running subtree task
+constexpr double SOLVE_CHECKPOINT_DEFAULT_INTERVAL = 60.0;
+//part of every checkpoint file, has to be incremented whenever the file layout or the task split of the kernels changes
+constexpr std::uint32_t SOLVE_CHECKPOINT_VERSION = 1;
+
+namespace Engine {
+    /*
+    State of a subtree task that was loaded from a checkpoint. combinations holds every combination the task found so far (one
+    bucket per talent point bucket of the kernel), unfinished tasks also hold the explicit stack of the frontier kernel to continue
+    from (three masks per frame, every mask is indexWords SINDs).
+    */
+    struct SolveCheckpointTask {
+        bool finished = false;
+        std::vector<SIND> frames;
+        vec2d<SIND> combinations;
+    };
+
+    /*
+    Checkpoint file of a long running solve, attach it to the solve handle (see SolveHandle::setCheckpoint) before the solve starts.
+    Checkpointed solves split the search tree into a fixed set of subtree tasks (root subtrees in search order) and append a record
+    for a task when it finishes, every interval seconds while it runs and when the solve gets canceled. A record holds the explicit
+    kernel stack of the task and the combinations it found since its last record, so a resumed solve replays finished tasks and
+    continues unfinished ones where they stopped, the final result is identical to an uninterrupted solve.
+    The file is only created once the solve ran for interval seconds (tasks that finished before are solved again on resume) and
+    removed when the solve completed. Records end with a checksum, a crash while writing only loses the record that was written.
+    Checkpoint errors never fail a solve, the solve just continues without checkpoints.
+    */
+    class SolveCheckpoint {
+    public:
+        SolveCheckpoint(const std::filesystem::path& path, bool resume, double interval = SOLVE_CHECKPOINT_DEFAULT_INTERVAL);
+
+        const std::filesystem::path& getPath() const;
+        double getInterval() const;
+        //true if the last solve continued from records of an earlier solve
+        bool isResumed() const;
+
+        //the solvers set the solve cache key of the solve (see createSolveCacheKey), the kernel starts the checkpoint with its task layout
+        void setKey(const std::string& key);
+        bool start(const std::vector<std::int64_t>& layout);
+        //loaded state of a task or nullptr if the checkpoint has no record of it, only valid after start
+        std::unique_ptr<SolveCheckpointTask> takeTask(size_t task);
+        //appends frames and the combinations of every bucket from savedSizes on (thread safe)
+        void appendTask(size_t task, bool finished, const std::vector<SIND>& frames, const vec2d<SIND>& combinations, const std::vector<size_t>& savedSizes);
+        void remove();
+
+    private:
+        bool load();
+        bool isActive() const;
+        void writeHeader();
+
+        std::filesystem::path path;
+        bool resume = false;
+        double interval = SOLVE_CHECKPOINT_DEFAULT_INTERVAL;
+        std::string key;
+        std::vector<std::int64_t> layout;
+        bool resumed = false;
+        bool failed = false;
+        std::chrono::steady_clock::time_point startTime;
+        std::map<size_t, SolveCheckpointTask> tasks;
+        std::ofstream file;
+        std::mutex fileMutex;
+    };
+
+    std::filesystem::path getSolveCheckpointPath(
+        TalentTree tree,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TalentSkillset> filter = nullptr,
+        const FilterExpression* filterExpression = nullptr);
+}
@@ -0,0 +1,329 @@
+/*
+    WoW Talent Tree Manager is an application for creating/editing/sharing talent trees and setups.
+    Copyright(C) 2022 Tobias Mielich
+
+    This program is free software : you can redistribute it and /or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see < https://www.gnu.org/licenses/>.
+
+    Contact via https://github.com/TobiasM95/WoW-Talent-Tree-Manager/discussions or BuffMePls#2973 on Discord
+*/
+
+#include "TopBuildSearch.h"
+#include "CombinationBitmapIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace Engine {
+    /*
+    Reads talent scores from a text file with one talent per line in the format "<talent index>:<score of point 1>,<score of point 2>,...",
+    empty lines and lines starting with # are ignored.
+    */
+    TalentScores loadTalentScores(const std::filesystem::path& scoresFilePath) {
+        std::ifstream scoresFile(scoresFilePath);
+        if (!scoresFile.is_open()) {
+            throw std::logic_error("Could not open talent scores file " + scoresFilePath.string());
+        }
+        TalentScores talentScores;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(scoresFile, line)) {
+            lineNumber++;
+            if (line.size() > 0 && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.size() == 0 || line[0] == '#') {
+                continue;
+            }
+            std::vector<std::string> parts = splitString(line, ":");
+            try {
+                if (parts.size() != 2) {
+                    throw std::invalid_argument("missing separator");
+                }
+                std::vector<double>& rankScores = talentScores[std::stoi(parts[0])];
+                rankScores.clear();
+                for (auto& score : splitString(parts[1], ",")) {
+                    rankScores.push_back(std::stod(score));
+                }
+            }
+            catch (std::exception&) {
+                throw std::logic_error("Invalid talent score in line " + std::to_string(lineNumber) + " of " + scoresFilePath.string());
+            }
+        }
+        return talentScores;
+    }
+
+    /*
+    Derives an additive scoring model from the sim analysis of a tree: a talent with p points is worth the average DPS of all analyzed
+    skillsets with exactly p points in it minus the overall average DPS, the score of a point is the difference to one point less.
+    Switch talents score their better choice. Talents without analyzed skillsets score 0.
+    */
+    TalentScores createTalentScoresFromAnalysis(const TalentTree& tree) {
+        const AnalysisResult& result = tree.analysisResult;
+        TalentScores talentScores;
+        if (result.skillsetCount == 0 || result.talentPerformances.size() == 0) {
+            return talentScores;
+        }
+        float baseline = result.averageDPSSkillset.second;
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            auto colIt = result.indexToArrayColMap.find(indexTalentPair.first);
+            if (colIt == result.indexToArrayColMap.end()) {
+                continue;
+            }
+            auto getValue = [&](size_t col) {
+                if (col >= result.talentPerformances.size() || result.talentPerformances[col].skillsetDPS.size() == 0) {
+                    return 0.0;
+                }
+                return static_cast<double>(result.talentPerformances[col].averageDPSSkillset.second - baseline);
+            };
+            std::vector<double>& rankScores = talentScores[indexTalentPair.first];
+            size_t col = static_cast<size_t>(colIt->second);
+            if (indexTalentPair.second->type == TalentType::SWITCH) {
+                rankScores.push_back((std::max)(getValue(col), getValue(col + 1)));
+                continue;
+            }
+            double previousValue = 0.0;
+            for (int points = 1; points <= indexTalentPair.second->maxPoints; points++) {
+                double value = getValue(col + points - 1);
+                rankScores.push_back(value - previousValue);
+                previousValue = value;
+            }
+        }
+        return talentScores;
+    }
+
+    /*
+    Maps talent scores to the bits of the sorted DAG (expanded talents), missing talents or points score 0.
+    */
+    std::vector<double> createTalentBitScores(const TalentTree& tree, const TreeDAGInfo& sortedTreeDAG, const TalentScores& talentScores) {
+        //same expanded indexing as skillsetIndexToSkillset
+        std::map<int, std::pair<int, int>> expandedToCompactIndexRankMap;
+        for (auto& talent : tree.orderedTalents) {
+            for (int i = 0; i < talent.second->maxPoints; i++) {
+                if (i == 0) {
+                    expandedToCompactIndexRankMap[talent.second->index] = { talent.second->index, 0 };
+                }
+                else {
+                    expandedToCompactIndexRankMap[(talent.second->index + 1) * tree.maxTalentPoints + (i - 1)] = { talent.second->index, i };
+                }
+            }
+        }
+        std::vector<double> bitScores(sortedTreeDAG.sortedTalents.size(), 0.0);
+        for (size_t i = 0; i < sortedTreeDAG.sortedTalents.size(); i++) {
+            auto indexRankIt = expandedToCompactIndexRankMap.find(sortedTreeDAG.sortedTalents[i]->index);
+            if (indexRankIt == expandedToCompactIndexRankMap.end()) {
+                continue;
+            }
+            auto scoresIt = talentScores.find(indexRankIt->second.first);
+            if (scoresIt != talentScores.end() && static_cast<size_t>(indexRankIt->second.second) < scoresIt->second.size()) {
+                bitScores[i] = scoresIt->second[indexRankIt->second.second];
+            }
+        }
+        return bitScores;
+    }
+
+    /*
+    Branch and bound search over the take/skip decisions of the sorted talents (same states and traversal constraints as the count only
+    solver, see countCombinationsDP). The bound of a state is the exact best score of any completion to talentPoints talent points
+    that respects the include/exclude part of the filter (max-plus version of the path count DP), so subtrees whose bound can't beat
+    the current K-th best build are never entered and dead ends are pruned right away. Or/one groups are checked when a build is complete,
+    the bound stays optimistic since it ignores them.
+    */
+    template<typename IndexType>
+    class BasicTopBuildSearch {
+    public:
+        BasicTopBuildSearch(const TreeDAGInfo& sortedTreeDAG, int talentPoints, const std::vector<double>& bitScores, const CombinationFilterBits& filter)
+            : talentPoints(talentPoints),
+            table(createTreeStateTable<IndexType, double>(sortedTreeDAG, talentPoints, filter.includeBits, filter.excludeBits, NO_COMPLETION, 0.0,
+                [&bitScores](size_t talent, double skipBound, double takeBound) { return (std::max)(skipBound, addScore(bitScores[talent], takeBound)); })),
+            bitScores(bitScores), filter(filter) {
+        }
+
+        void search(size_t topK, TopBuildResult& result) {
+            this->topK = topK;
+            best.clear();
+            visitedNodes = 0;
+            if (topK > 0 && getBound(0, table.masks.rootMask, 0) != NO_COMPLETION) {
+                visit(0, table.masks.rootMask, 0, 0.0, IndexType());
+            }
+            std::sort(best.begin(), best.end(), [](const ScoredBuild& a, const ScoredBuild& b) { return a.first > b.first; });
+            result.indexWords = SkillsetIndexTraits<IndexType>::words;
+            result.visitedNodes = visitedNodes;
+            for (auto& scoredBuild : best) {
+                const SIND* words = getMaskWords(scoredBuild.second);
+                result.combinations.insert(result.combinations.end(), words, words + result.indexWords);
+                result.scores.push_back(scoredBuild.first);
+            }
+        }
+
+    private:
+        using ScoredBuild = std::pair<double, IndexType>;
+        static constexpr double NO_COMPLETION = -std::numeric_limits<double>::infinity();
+
+        static double addScore(double score, double bound) {
+            return bound == NO_COMPLETION ? NO_COMPLETION : score + bound;
+        }
+
+        double getBound(size_t level, const IndexType& mask, int talentPointsSpent) const {
+            return table.getValue(level, mask, talentPointsSpent);
+        }
+
+        //score a build has to exceed to get into the result
+        double getThreshold() const {
+            return best.size() < topK ? NO_COMPLETION : best.front().first;
+        }
+
+        void offer(double score, const IndexType& build) {
+            auto compare = [](const ScoredBuild& a, const ScoredBuild& b) { return a.first > b.first; };
+            if (best.size() < topK) {
+                best.push_back({ score, build });
+                std::push_heap(best.begin(), best.end(), compare);
+                return;
+            }
+            if (score <= best.front().first) {
+                return;
+            }
+            std::pop_heap(best.begin(), best.end(), compare);
+            best.back() = { score, build };
+            std::push_heap(best.begin(), best.end(), compare);
+        }
+
+        void visit(size_t i, const IndexType& mask, int talentPointsSpent, double score, const IndexType& build) {
+            visitedNodes++;
+            if (i == table.levels.size()) {
+                if (filter.matches(getMaskWords(build))) {
+                    offer(score, build);
+                }
+                return;
+            }
+            IndexType skipMask = table.getSkipMask(i, mask);
+            IndexType takeMask = table.getTakeMask(i, mask);
+            double skipBound = table.isSkippable(i) ? getBound(i + 1, skipMask, talentPointsSpent) : NO_COMPLETION;
+            double takeBound = NO_COMPLETION;
+            if (table.isTakeable(i, mask, talentPointsSpent)) {
+                takeBound = addScore(bitScores[i], getBound(i + 1, takeMask, talentPointsSpent + 1));
+            }
+            //the more promising branch first so the threshold rises as early as possible
+            bool takeFirst = takeBound > skipBound;
+            for (int branch = 0; branch < 2; branch++) {
+                bool take = (branch == 0) == takeFirst;
+                double bound = take ? takeBound : skipBound;
+                if (bound == NO_COMPLETION || score + bound <= getThreshold()) {
+                    continue;
+                }
+                if (take) {
+                    IndexType talentBit = {};
+                    setTalent(talentBit, static_cast<int>(i));
+                    visit(i + 1, takeMask, talentPointsSpent + 1, score + bitScores[i], build | talentBit);
+                }
+                else {
+                    visit(i + 1, skipMask, talentPointsSpent, score, build);
+                }
+            }
+        }
+
+        int talentPoints = 0;
+        //exact best score of the completions of every state
+        BasicTreeStateTable<IndexType, double> table;
+        const std::vector<double>& bitScores;
+        const CombinationFilterBits& filter;
+        size_t topK = 0;
+        size_t visitedNodes = 0;
+        //min heap of the best builds so far
+        std::vector<ScoredBuild> best;
+    };
+
+    /*
+    Returns the topK valid builds with exactly talentPoints talent points that pass the filter and have the highest sum of bit scores
+    (see createTalentBitScores), builds with the same score are in no particular order.
+    */
+    TopBuildResult findTopBuilds(
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPoints,
+        const std::vector<double>& bitScores,
+        size_t topK,
+        std::shared_ptr<TalentSkillset> filter) {
+        if (bitScores.size() != sortedTreeDAG.sortedTalents.size()) {
+            throw std::logic_error("Number of talent scores doesn't match the number of talents");
+        }
+        TopBuildResult result;
+        result.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        if (talentPoints <= 0) {
+            return result;
+        }
+        CombinationFilterBits filterBits = createCombinationFilterBits(tree, sortedTreeDAG, filter);
+        dispatchSkillsetIndexType(result.indexWords, [&](auto indexTag) {
+            BasicTopBuildSearch<decltype(indexTag)> search(sortedTreeDAG, talentPoints, bitScores, filterBits);
+            search.search(topK, result);
+        });
+        return result;
+    }
+
+    /*
+    Top K counterpart of countConfigurationsStreaming: creates the sorted DAG of the tree, pushes the topK best builds with exactly
+    talentPoints talent points (highest score first) to the sink and returns them with their scores in result.
+    */
+    void countConfigurationsTopK(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPoints,
+        const TalentScores& talentScores,
+        size_t topK,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        TopBuildResult& result,
+        bool& inProgress) {
+
+        inProgress = true;
+        std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
+        tree.unspentTalentPoints = talentPoints;
+        //expand notes in tree
+        expandTreeTalents(*processedTree);
+
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        setSafetyGuard(sortedTreeDAG);
+        sortedTreeDAG.processedTree = processedTree;
+
+        //collect all switch talent choices
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            if (indexTalentPair.second->type == Engine::TalentType::SWITCH) {
+                sortedTreeDAG.switchTalentChoices.push_back({ indexTalentPair.first, 1 });
+            }
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        sink.begin(sortedTreeDAG);
+        result = findTopBuilds(tree, sortedTreeDAG, talentPoints, createTalentBitScores(tree, sortedTreeDAG, talentScores), topK, filter);
+        CombinationBlock block;
+        block.talentPoints = talentPoints;
+        block.indexWords = result.indexWords;
+        block.combinations = result.combinations;
+        if (block.combinations.size() > 0 && !sink.push(block)) {
+            sortedTreeDAG.safetyGuardTriggered = true;
+        }
+        sink.finish();
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        sortedTreeDAG.allCombinations.resize(1);
+        sortedTreeDAG.allCombinationsSum = result.scores.size();
+        sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        inProgress = false;
+
+        treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <filesystem>
+
+#include "TTMEnginePresets.h"
+#include "TalentTrees.h"
+#include "TreeSolver.h"
+
+namespace Engine {
+    //score of every talent point per talent index, entry r is the score of the (r + 1)-th point (switch talents have a single entry)
+    using TalentScores = std::map<int, std::vector<double>>;
+
+    /*
+    Result of findTopBuilds, combinations are in the allCombinations layout and sorted by descending score.
+    */
+    struct TopBuildResult {
+        int indexWords = 1;
+        std::vector<SIND> combinations;
+        std::vector<double> scores;
+        //number of search nodes that were expanded (i.e. not pruned)
+        size_t visitedNodes = 0;
+    };
+
+    TalentScores loadTalentScores(const std::filesystem::path& scoresFilePath);
+    TalentScores createTalentScoresFromAnalysis(const TalentTree& tree);
+    std::vector<double> createTalentBitScores(const TalentTree& tree, const TreeDAGInfo& sortedTreeDAG, const TalentScores& talentScores);
+    TopBuildResult findTopBuilds(
+        const TalentTree& tree,
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPoints,
+        const std::vector<double>& bitScores,
+        size_t topK,
+        std::shared_ptr<TalentSkillset> filter);
+    void countConfigurationsTopK(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPoints,
+        const TalentScores& talentScores,
+        size_t topK,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        TopBuildResult& result,
+        bool& inProgress);
+}
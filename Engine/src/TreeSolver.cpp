@@ -19,14 +19,133 @@
 */
 
 #include "TreeSolver.h"
+#include "CombinationBitmapIndex.h"
+#include "CombinationStore.h"
+#include "FilterExpression.h"
+#include "SolveCache.h"
+#include "SolveCheckpoint.h"
 
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TTM_X86_SIMD
+#include <immintrin.h>
+#endif
+//MSVC allows SIMD intrinsics in every function, other compilers need the target enabled per function
+#if defined(TTM_X86_SIMD) && !defined(_MSC_VER)
+#define TTM_TARGET_AVX2 __attribute__((target("avx2")))
+#define TTM_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define TTM_TARGET_AVX2
+#define TTM_TARGET_SSE42
+#endif
 
 namespace Engine {
+    /*
+    Solve cache and checkpoint key of a solve, every shard of a tree (see SolveShard) is a solve of its own.
+    */
+    static std::string createSolveKey(const std::string& cacheKey, SolveHandle* solveHandle) {
+        if (solveHandle == nullptr) {
+            return cacheKey;
+        }
+        std::string key = cacheKey;
+        if (solveHandle->getShard().count > 1) {
+            key += "-shard" + std::to_string(solveHandle->getShard().index) + "of" + std::to_string(solveHandle->getShard().count);
+        }
+        if (solveHandle->getCheckpoint() != nullptr) {
+            solveHandle->getCheckpoint()->setKey(key);
+        }
+        return key;
+    }
+
+    /*
+    Whether the combinations of an unfiltered solve exceed the safety guard (derived from the memory budget, see setSafetyGuard),
+    the count only DP knows the exact number of combinations before anything is enumerated.
+    */
+    static bool exceedsSafetyGuard(const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit, bool onlyLimitSolve) {
+        if (talentPointsLimit <= 0) {
+            return false;
+        }
+        std::vector<CombinationCount> combinationCounts;
+        std::vector<CombinationCount> weightedCombinationCounts;
+        if (!countCombinationsDP(sortedTreeDAG, talentPointsLimit, combinationCounts, weightedCombinationCounts)) {
+            return true;
+        }
+        CombinationCount combinationCount = 0;
+        for (int i = onlyLimitSolve ? talentPointsLimit - 1 : 0; i < talentPointsLimit; i++) {
+            if (combinationCounts[i] > sortedTreeDAG.safetyGuard - combinationCount) {
+                return true;
+            }
+            combinationCount += combinationCounts[i];
+        }
+        return false;
+    }
+
+    /*
+    Solves a tree whose combinations don't fit into the memory budget with the streaming solver into a combination store sink, which
+    spills sorted runs to disk at the budget (see CombinationStoreSink). The store is written to the temp directory and opened as
+    combinationStore of the tree DAG, it's removed once the last reference to it is gone. Canceled solves keep what was solved so far.
+    */
+    static void countConfigurationsSpilled(
+        TalentTree tree,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        std::shared_ptr<SolveHandle> solveHandle
+    ) {
+        static std::atomic<size_t> spilledSolveCount = 0;
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("ttm_solve_"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_"
+            + std::to_string(spilledSolveCount.fetch_add(1)) + ".ttmc");
+        std::shared_ptr<CombinationStoreReader> combinationStore;
+        try {
+            {
+                CombinationStoreSink sink(path, tree, talentPointsLimit, onlyLimitSolve);
+                countConfigurationsStreaming(tree, nullptr, talentPointsLimit, onlyLimitSolve, sink, treeDAGInfo, inProgress, safetyGuardTriggered, threadCount, solveHandle);
+            }
+            combinationStore = std::shared_ptr<CombinationStoreReader>(new CombinationStoreReader(path), [path](CombinationStoreReader* reader) {
+                delete reader;
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+                });
+        }
+        catch (std::exception&) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            safetyGuardTriggered = true;
+            inProgress = false;
+        }
+        if (treeDAGInfo) {
+            //same bucket layout as the in memory solvers
+            treeDAGInfo->allCombinations.assign(talentPointsLimit, {});
+            treeDAGInfo->combinationStore = combinationStore;
+            treeDAGInfo->safetyGuardTriggered |= safetyGuardTriggered;
+        }
+    }
+
     /*
     Counts configurations of a tree with given amount of talent points by topologically sorting the tree and iterating through valid paths (i.e.
     paths with monotonically increasing talent indices). See Wikipedia DAGs (which Wow Talent Trees are) and Topological Sorting.
@@ -36,7 +155,9 @@ namespace Engine {
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
-        bool& safetyGuardTriggered
+        bool& safetyGuardTriggered,
+        int threadCount,
+        std::shared_ptr<SolveHandle> solveHandle
     ) {
         inProgress = true;
         std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
@@ -49,55 +170,53 @@ namespace Engine {
         //create sorted DAG (is vector of vector and at most nx(m+1) Array where n = # nodes and m is the max amount of connections a node has to childs and 
         //+1 because first column contains the weight (1 for regular talents and 2 for switch talents))
         TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
         setSafetyGuard(sortedTreeDAG);
         sortedTreeDAG.processedTree = processedTree;
-        if (sortedTreeDAG.sortedTalents.size() > 64)
-            throw std::logic_error("Number of talents exceeds 64, need different indexing type instead of uint64");
+        //solves that don't fit into the memory budget are spilled to disk instead of stopping at the safety guard
+        if (exceedsSafetyGuard(sortedTreeDAG, talentPointsLimit, true)) {
+            countConfigurationsSpilled(tree, talentPointsLimit, true, treeDAGInfo, inProgress, safetyGuardTriggered, threadCount, solveHandle);
+            return;
+        }
         std::vector<SIND> combinations;
 
-        //iterate through all possible combinations in order:
-        //have 4 variables: visited nodes (int vector with capacity = # talent points), num talent points left, int vector of possible nodes to visit, weight of combination
-        //weight of combination = factor of 2 for every switch talent in path
-        SIND visitedTalents = 0;
-        int talentPointsLeft = tree.unspentTalentPoints;
-        std::vector<std::pair<int, int>> possibleTalents;
-        //possibleTalents.reserve(sortedTreeDAG.minimalTreeDAG.size());//is this faster or not?
-        //add roots to the list of possible talents first, then iterate recursively with visitTalent
-        for (auto& root : sortedTreeDAG.rootIndices) {
-            possibleTalents.push_back(std::pair<int, int>(root, sortedTreeDAG.sortedTalents[root]->pointsRequired));
-        }
+        //iterate through all possible combinations in order with the bitmask frontier kernel (see visitTalentsFrontierSingle)
         auto t1 = std::chrono::high_resolution_clock::now();
-        //this is used for safeguarding solving process for trees that are too big
-        int runningCount = 0;
-        for (int i = 0; i < possibleTalents.size(); i++) {
-            //only start with root nodes that have points required == 0, prevents from starting at root nodes that might come later in the tree (e.g. druid wild charge)
-            if (sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired == 0)
-                visitTalentSingle(
-                    possibleTalents[i],
-                    visitedTalents,
-                    i + 1,
-                    1,
-                    0,
-                    talentPointsLeft,
-                    possibleTalents,
-                    sortedTreeDAG,
+        //trees with the same structure that were solved before are loaded from the solve cache instead
+        std::string cacheKey = createSolveKey(createSolveCacheKey(tree, sortedTreeDAG, talentPointsLimit, true, nullptr), solveHandle.get());
+        vec2d<SIND> allCombinationsVector;
+        sortedTreeDAG.loadedFromSolveCache = loadSolveCache(cacheKey, sortedTreeDAG, talentPointsLimit, allCombinationsVector);
+        if (!sortedTreeDAG.loadedFromSolveCache) {
+            //this is used for safeguarding solving process for trees that are too big
+            size_t runningCount = 0;
+            dispatchSkillsetIndexType(sortedTreeDAG.indexWords, [&](auto indexTag) {
+                using IndexType = decltype(indexTag);
+                visitTalentsFrontierSingle(
+                    createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPointsLimit),
+                    talentPointsLimit,
                     combinations,
                     runningCount,
-                    std::ref(safetyGuardTriggered)
+                    sortedTreeDAG.safetyGuard,
+                    safetyGuardTriggered,
+                    threadCount,
+                    solveHandle.get()
                 );
-        }
-        if (safetyGuardTriggered) {
-            sortedTreeDAG.safetyGuardTriggered = true;
+            });
+            if (safetyGuardTriggered) {
+                sortedTreeDAG.safetyGuardTriggered = true;
+            }
+            for (int i = 0; i < talentPointsLimit - 1; i++) {
+                allCombinationsVector.push_back({});
+            }
+            allCombinationsVector.push_back(combinations);
         }
         auto t2 = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> ms_double = t2 - t1;
-        vec2d<SIND> allCombinationsVector;
-        for (int i = 0; i < talentPointsLimit - 1; i++) {
-            allCombinationsVector.push_back({});
-        }
-        allCombinationsVector.push_back(combinations);
         sortedTreeDAG.allCombinations = allCombinationsVector;
         sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        if (!sortedTreeDAG.loadedFromSolveCache) {
+            storeSolveCache(cacheKey, tree, sortedTreeDAG, talentPointsLimit, true, sortedTreeDAG.allCombinations);
+        }
         inProgress = false;
 
         //collect all switch talent choices
@@ -111,82 +230,16 @@ namespace Engine {
         treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
     }
 
-    void visitTalentSingle(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfo& sortedTreeDAG,
-        std::vector<SIND>& combinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
-    ) {
-        /*
-        for each node visited add child nodes(in DAG array) to the vector of possible nodesand reduce talent points left
-        check if talent points left == 0 (finish) or num_nodes - current_node < talent_points_left (check for off by one error) (cancel cause talent tree can't be filled)
-        iterate through all nodes in vector possible nodes to visit but only visit nodes whose index > current index
-        if finished perform bit shift on uint64 to get unique tree index and put it in configuration set
-        */
-        if (runningCount >= sortedTreeDAG.safetyGuard || safetyGuardTriggered) {
-            safetyGuardTriggered = true;
-            return;
-        }
-        //do combination housekeeping
-        setTalent(visitedTalents, talentIndexReqPair.first);
-        talentPointsSpent += 1;
-        talentPointsLeft -= 1;
-        currentMultiplier *= sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][0];
-        //check if path is complete
-        if (talentPointsLeft == 0) {
-            runningCount++;
-            combinations.push_back(visitedTalents);
-            return;
-        }
-        //check if path can be finished (due to sorting and early stopping some paths are ignored even though in practice you could complete them but
-        //sorting guarantees that these paths were visited earlier already)
-        //also check if exclude filter is violated and early stop as well
-        if (sortedTreeDAG.sortedTalents.size() - talentIndexReqPair.first - 1 < talentPointsLeft) {
-            //cannot use up all the leftover talent points, therefore incomplete, or exclude filter was violated
-            return;
-        }
-        //add all possible children to the set for iteration
-        for (int i = 1; i < sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first].size(); i++) {
-            int childIndex = sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][i];
-            std::pair<int, int> targetPair = std::pair<int, int>(childIndex, sortedTreeDAG.sortedTalents[childIndex]->pointsRequired);
-            insertIntoVector(possibleTalents, targetPair);
-        }
-        //visit all possible children while keeping correct order
-        for (int i = currentPosTalIndex; i < possibleTalents.size(); i++) {
-            //check if next talent is in right order andn talentPointsSpent is >= next talent points required
-            if (possibleTalents[i].first > talentIndexReqPair.first &&
-                talentPointsSpent >= sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired) {
-                visitTalentSingle(
-                    possibleTalents[i],
-                    visitedTalents,
-                    i + 1,
-                    currentMultiplier,
-                    talentPointsSpent,
-                    talentPointsLeft,
-                    possibleTalents,
-                    sortedTreeDAG,
-                    combinations,
-                    runningCount,
-                    std::ref(safetyGuardTriggered)
-                );
-            }
-        }
-    }
-
     void countConfigurationsFiltered(
         TalentTree tree,
         std::shared_ptr<Engine::TalentSkillset> filter,
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
-        bool& safetyGuardTriggered
+        bool& safetyGuardTriggered,
+        int threadCount,
+        std::shared_ptr<SolveHandle> solveHandle,
+        std::shared_ptr<FilterExpression> filterExpression
     ) {
         inProgress = true;
         std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
@@ -199,126 +252,54 @@ namespace Engine {
         //create sorted DAG (is vector of vector and at most nx(m+1) Array where n = # nodes and m is the max amount of connections a node has to childs and 
         //+1 because first column contains the weight (1 for regular talents and 2 for switch talents))
         TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
         setSafetyGuard(sortedTreeDAG);
         sortedTreeDAG.processedTree = processedTree;
-        if (sortedTreeDAG.sortedTalents.size() > 64)
-            throw std::logic_error("Number of talents exceeds 64, need different indexing type instead of uint64");
         std::vector<SIND> combinations;
 
-        //create filters to be able to filter during solving
-        //skillset has compactTalentIndex information
-        //treeDAG->sortedTalents containts index->expandedTalentIndex mapping
-        //therefore we need compactTalentIndex->expandedTalentIndex mapping and reverse the index->expandedTalentIndex
-        std::map<int, int> expandedToPosIndexMap;
-        for (int i = 0; i < sortedTreeDAG.sortedTalents.size(); i++) {
-            expandedToPosIndexMap[sortedTreeDAG.sortedTalents[i]->index] = i;
-        }
-        std::map<int, std::vector<int>> compactToExpandedIndexMap;
-        for (auto& talent : tree.orderedTalents) {
-            std::vector<int> indices;
-            for (int i = 0; i < talent.second->maxPoints; i++) {
-                //this indexing is taken from TalentTrees.cpp expand talent tree routine and represents an arbitrary indexing
-                //for multipoint talents that doesn't collide for a use in a map
-                //TTMNOTE: If this changes, also change TalentTrees.cpp->expandTalentAndAdvance and TreeSolver.cpp->skillsetIndexToSkillset
-                if (i == 0) {
-                    indices.push_back(talent.second->index);
-                }
-                else {
-                    indices.push_back((talent.second->index + 1) * tree.maxTalentPoints + (i - 1));
-                }
-            }
-            compactToExpandedIndexMap[talent.second->index] = indices;
+        //iterate through all possible combinations in order with the bitmask frontier kernel (see visitTalentsFrontierFiltered)
+        auto t1 = std::chrono::high_resolution_clock::now();
+        //cache entries hold combinations per talent points, filtered solves only keep the last bucket
+        std::string cacheKey = createSolveKey(createSolveCacheKey(tree, sortedTreeDAG, talentPointsLimit, true, filter, filterExpression.get()), solveHandle.get());
+        vec2d<SIND> cachedCombinations;
+        sortedTreeDAG.loadedFromSolveCache = loadSolveCache(cacheKey, sortedTreeDAG, talentPointsLimit, cachedCombinations);
+        if (sortedTreeDAG.loadedFromSolveCache) {
+            combinations = std::move(cachedCombinations.back());
         }
-        SIND includeFilter = 0; //this talent has to have exactly the specified amount of talent points
-        SIND excludeFilter = 0; //this talent must not have any talent points assigned
-        SIND orFilter = 0; //this group of talents has to have at least one talent point assigned
-        std::vector<std::pair<SIND, SIND>> oneFilter; //exactly one talent in this group has to be maxed while all others must not have any points
-        for (auto& indexFilterPair : filter->assignedSkillPoints) {
-            if (indexFilterPair.second == -3) {
-                SIND inc = 0;
-                SIND exc = 0;
-                for (auto& iFP : filter->assignedSkillPoints) {
-                    if (iFP.second != -3) {
-                        continue;
-                    }
-                    if (iFP.first == indexFilterPair.first) {
-                        for (int i = 0; i < compactToExpandedIndexMap[iFP.first].size(); i++) {
-                            int expandedTalentIndex = compactToExpandedIndexMap[iFP.first][i];
-                            int pos = expandedToPosIndexMap[expandedTalentIndex];
-                            setTalent(inc, pos);
-                        }
-                    }
-                    else {
-                        for (int i = 0; i < compactToExpandedIndexMap[iFP.first].size(); i++) {
-                            int expandedTalentIndex = compactToExpandedIndexMap[iFP.first][i];
-                            int pos = expandedToPosIndexMap[expandedTalentIndex];
-                            setTalent(exc, pos);
-                        }
-                    }
-                }
-                oneFilter.push_back({ inc, exc });
-            }
-            if (indexFilterPair.second == -2) {
-                for (int i = 0; i < compactToExpandedIndexMap[indexFilterPair.first].size(); i++) {
-                    int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][i];
-                    int pos = expandedToPosIndexMap[expandedTalentIndex];
-                    setTalent(orFilter, pos);
-                }
-            }
-            else if (indexFilterPair.second == -1) {
-                int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][0];
-                int pos = expandedToPosIndexMap[expandedTalentIndex];
-                setTalent(excludeFilter, pos);
-            }
-            else if (indexFilterPair.second > 0) {
-                for (int i = 0; i < indexFilterPair.second; i++) {
-                    int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][i];
-                    int pos = expandedToPosIndexMap[expandedTalentIndex];
-                    setTalent(includeFilter, pos);
+        else {
+            //filtered solves are not capped by the safety guard but can still be canceled
+            size_t runningCount = 0;
+            dispatchSkillsetIndexType(sortedTreeDAG.indexWords, [&](auto indexTag) {
+                using IndexType = decltype(indexTag);
+                //create filters to be able to filter during solving
+                BasicSkillsetFilterMasks<IndexType> filterMasks = createSkillsetFilterMasks<IndexType>(tree, sortedTreeDAG, filter);
+                if (filterExpression) {
+                    filterMasks.program = std::make_shared<BasicFilterProgram<IndexType>>(compileFilterProgram<IndexType>(*filterExpression, sortedTreeDAG));
                 }
-            }
-        }
-
-        //iterate through all possible combinations in order:
-        //have 4 variables: visited nodes (int vector with capacity = # talent points), num talent points left, int vector of possible nodes to visit, weight of combination
-        //weight of combination = factor of 2 for every switch talent in path
-        SIND visitedTalents = 0;
-        int talentPointsLeft = tree.unspentTalentPoints;
-        std::vector<std::pair<int, int>> possibleTalents;
-        //possibleTalents.reserve(sortedTreeDAG.minimalTreeDAG.size());//is this faster or not?
-        //add roots to the list of possible talents first, then iterate recursively with visitTalent
-        for (auto& root : sortedTreeDAG.rootIndices) {
-            possibleTalents.push_back(std::pair<int, int>(root, sortedTreeDAG.sortedTalents[root]->pointsRequired));
-        }
-        auto t1 = std::chrono::high_resolution_clock::now();
-        //this is used for safeguarding solving process for trees that are too big
-        int runningCount = 0;
-        for (int i = 0; i < possibleTalents.size(); i++) {
-            //only start with root nodes that have points required == 0, prevents from starting at root nodes that might come later in the tree (e.g. druid wild charge)
-            if (sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired == 0)
-                visitTalentFiltered(
-                    possibleTalents[i],
-                    visitedTalents, 
-                    i + 1, 
-                    1,
-                    0, 
-                    talentPointsLeft, 
-                    possibleTalents, 
-                    sortedTreeDAG, 
-                    combinations, 
-                    runningCount, 
-                    std::ref(safetyGuardTriggered),
-                    includeFilter,
-                    excludeFilter,
-                    orFilter,
-                    oneFilter
+                visitTalentsFrontierFiltered(
+                    createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPointsLimit),
+                    talentPointsLimit,
+                    filterMasks,
+                    combinations,
+                    runningCount,
+                    SIZE_MAX,
+                    safetyGuardTriggered,
+                    threadCount,
+                    solveHandle.get()
                 );
-        }
-        if (safetyGuardTriggered) {
-            sortedTreeDAG.safetyGuardTriggered = true;
+            });
+            if (safetyGuardTriggered) {
+                sortedTreeDAG.safetyGuardTriggered = true;
+            }
         }
         auto t2 = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        if (!sortedTreeDAG.loadedFromSolveCache && !sortedTreeDAG.safetyGuardTriggered) {
+            cachedCombinations.resize(talentPointsLimit);
+            cachedCombinations.back().swap(combinations);
+            storeSolveCache(cacheKey, tree, sortedTreeDAG, talentPointsLimit, true, cachedCombinations);
+            cachedCombinations.back().swap(combinations);
+        }
         vec2d<SIND> allCombinationsVector;
         allCombinationsVector.push_back(combinations);
         sortedTreeDAG.allCombinations = allCombinationsVector;
@@ -336,82 +317,6 @@ namespace Engine {
         treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
     }
 
-    /*
-    Core recursive function in fast combination counting. Keeps track of selected talents, checks if combination is complete or cannot be finished (early stopping),
-    and iterates through possible children in a sorted fashion to prevent duplicates.
-    */
-    void visitTalentFiltered(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfo& sortedTreeDAG,
-        std::vector<SIND>& combinations,
-        int& runningCount,
-        bool& safetyGuardTriggered,
-        SIND& includeFilter,
-        SIND& excludeFilter,
-        SIND& orFilter,
-        std::vector<std::pair<SIND, SIND>>& oneFilter
-    ) {
-        /*
-        for each node visited add child nodes(in DAG array) to the vector of possible nodesand reduce talent points left
-        check if talent points left == 0 (finish) or num_nodes - current_node < talent_points_left (check for off by one error) (cancel cause talent tree can't be filled)
-        iterate through all nodes in vector possible nodes to visit but only visit nodes whose index > current index
-        if finished perform bit shift on uint64 to get unique tree index and put it in configuration set
-        */
-        //do combination housekeeping
-        setTalent(visitedTalents, talentIndexReqPair.first);
-        talentPointsSpent += 1;
-        talentPointsLeft -= 1;
-        currentMultiplier *= sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][0];
-        //check if path is complete
-        if (talentPointsLeft == 0 && checkSkillsetFilter(visitedTalents, includeFilter, excludeFilter, orFilter, oneFilter)) {
-            combinations.push_back(visitedTalents);
-            return;
-        }
-        //check if path can be finished (due to sorting and early stopping some paths are ignored even though in practice you could complete them but
-        //sorting guarantees that these paths were visited earlier already)
-        //also check if exclude filter is violated and early stop as well
-        if (sortedTreeDAG.sortedTalents.size() - talentIndexReqPair.first - 1 < talentPointsLeft
-            || (visitedTalents & excludeFilter) != 0) {
-            //cannot use up all the leftover talent points, therefore incomplete, or exclude filter was violated
-            return;
-        }
-        //add all possible children to the set for iteration
-        for (int i = 1; i < sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first].size(); i++) {
-            int childIndex = sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][i];
-            std::pair<int, int> targetPair = std::pair<int, int>(childIndex, sortedTreeDAG.sortedTalents[childIndex]->pointsRequired);
-            insertIntoVector(possibleTalents, targetPair);
-        }
-        //visit all possible children while keeping correct order
-        for (int i = currentPosTalIndex; i < possibleTalents.size(); i++) {
-            //check if next talent is in right order andn talentPointsSpent is >= next talent points required
-            if (possibleTalents[i].first > talentIndexReqPair.first &&
-                talentPointsSpent >= sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired) {
-                visitTalentFiltered(
-                    possibleTalents[i],
-                    visitedTalents, 
-                    i + 1, 
-                    currentMultiplier, 
-                    talentPointsSpent, 
-                    talentPointsLeft, 
-                    possibleTalents, 
-                    sortedTreeDAG, 
-                    combinations, 
-                    runningCount,
-                    std::ref(safetyGuardTriggered),
-                    includeFilter,
-                    excludeFilter,
-                    orFilter,
-                    oneFilter);
-            }
-        }
-    }
-
     /*
     Parallel version of fast configuration counting that runs slower for individual Ns (where N is the amount of available talent points and N >= smallest path from top to bottom)
     compared to single N count but includes all combinations for 1 up to N talent points.
@@ -421,7 +326,9 @@ namespace Engine {
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
-        bool& safetyGuardTriggered) {
+        bool& safetyGuardTriggered,
+        int threadCount,
+        std::shared_ptr<SolveHandle> solveHandle) {
 
         inProgress = true;
         std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
@@ -434,41 +341,49 @@ namespace Engine {
         //create sorted DAG (is vector of vector and at most nx(m+1) Array where n = # nodes and m is the max amount of connections a node has to childs and 
         //+1 because first column contains the weight (1 for regular talents and 2 for switch talents))
         TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
         setSafetyGuard(sortedTreeDAG);
         sortedTreeDAG.processedTree = processedTree;
-        if (sortedTreeDAG.sortedTalents.size() > 64)
-            throw std::logic_error("Number of talents exceeds 64, need different indexing type instead of uint64");
+        //solves that don't fit into the memory budget are spilled to disk instead of stopping at the safety guard
+        if (exceedsSafetyGuard(sortedTreeDAG, talentPointsLimit, false)) {
+            countConfigurationsSpilled(tree, talentPointsLimit, false, treeDAGInfo, inProgress, safetyGuardTriggered, threadCount, solveHandle);
+            return;
+        }
         vec2d<SIND> combinations;
         combinations.resize(talentPoints);
-        std::vector<int> allCombinations;
-        allCombinations.resize(talentPoints, 0);
-
-        //iterate through all possible combinations in order:
-        //have 4 variables: visited nodes (int vector with capacity = # talent points), num talent points left, int vector of possible nodes to visit, weight of combination
-        //weight of combination = factor of 2 for every switch talent in path
-        SIND visitedTalents = 0;
-        int talentPointsLeft = tree.unspentTalentPoints;
-        std::vector<std::pair<int, int>> possibleTalents;
-        //add roots to the list of possible talents first, then iterate recursively with visitTalent
-        for (auto& root : sortedTreeDAG.rootIndices) {
-            possibleTalents.push_back(std::pair<int, int>(root, sortedTreeDAG.sortedTalents[root]->pointsRequired));
-        }
+
+        //iterate through all possible combinations in order with the bitmask frontier kernel (see visitTalentsFrontierParallel)
         auto t1 = std::chrono::high_resolution_clock::now();
-        //this is used for safeguarding solving process for trees that are too big
-        int runningCount = 0;
-        for (int i = 0; i < possibleTalents.size(); i++) {
-            //only start with root nodes that have points required == 0, prevents from starting at root nodes that might come later in the tree (e.g. druid wild charge)
-            //if (possibleTalents[i].second == 0)
-            if (sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired == 0)
-                visitTalentParallel(possibleTalents[i], visitedTalents, i + 1, 1, 0, talentPointsLeft, possibleTalents, sortedTreeDAG, combinations, allCombinations, runningCount, std::ref(safetyGuardTriggered));
-        }
-        if (safetyGuardTriggered) {
-            sortedTreeDAG.safetyGuardTriggered = true;
+        //trees with the same structure that were solved before are loaded from the solve cache instead
+        std::string cacheKey = createSolveKey(createSolveCacheKey(tree, sortedTreeDAG, talentPointsLimit, false, nullptr), solveHandle.get());
+        sortedTreeDAG.loadedFromSolveCache = loadSolveCache(cacheKey, sortedTreeDAG, talentPointsLimit, combinations);
+        if (!sortedTreeDAG.loadedFromSolveCache) {
+            //this is used for safeguarding solving process for trees that are too big
+            size_t runningCount = 0;
+            dispatchSkillsetIndexType(sortedTreeDAG.indexWords, [&](auto indexTag) {
+                using IndexType = decltype(indexTag);
+                visitTalentsFrontierParallel(
+                    createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPointsLimit),
+                    talentPointsLimit,
+                    combinations,
+                    runningCount,
+                    sortedTreeDAG.safetyGuard,
+                    safetyGuardTriggered,
+                    threadCount,
+                    solveHandle.get()
+                );
+            });
+            if (safetyGuardTriggered) {
+                sortedTreeDAG.safetyGuardTriggered = true;
+            }
         }
         auto t2 = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> ms_double = t2 - t1;
         sortedTreeDAG.allCombinations = std::move(combinations);
         sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        if (!sortedTreeDAG.loadedFromSolveCache) {
+            storeSolveCache(cacheKey, tree, sortedTreeDAG, talentPointsLimit, false, sortedTreeDAG.allCombinations);
+        }
         inProgress = false;
 
         //collect all switch talent choices
@@ -482,274 +397,1514 @@ namespace Engine {
     }
 
     /*
-    Parallel version of recursive talent visitation that does not early stop and keeps track of all paths shorter than max path length.
+    Streaming version of the solvers that pushes every combination to a sink (see CombinationSink) instead of storing them in
+    TreeDAGInfo::allCombinations, therefore memory usage does not depend on the number of combinations and the solve is not capped
+    by the safety guard (it can still be canceled by safetyGuardTriggered or the sink). onlyLimitSolve selects countConfigurationsSingle
+    behavior, otherwise all combinations with 1 up to talentPointsLimit talent points are pushed like in countConfigurationsParallel.
+    The filter and the filter expression are optional (nullptr) and applied in both modes. The returned TreeDAGInfo only holds the DAG and the number of pushed
+    combinations (allCombinationsSum).
     */
-    void visitTalentParallel(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfo& sortedTreeDAG,
-        vec2d<SIND>& combinations,
-        std::vector<int>& allCombinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
-    ) {
-        if (runningCount >= sortedTreeDAG.safetyGuard || safetyGuardTriggered) {
-            safetyGuardTriggered = true;
-            return;
-        }
-        /*
-        for each node visited add child nodes(in DAG array) to the vector of possible nodesand reduce talent points left
-        check if talent points left == 0 (finish) or num_nodes - current_node < talent_points_left (check for off by one error) (cancel cause talent tree can't be filled)
-        iterate through all nodes in vector possible nodes to visit but only visit nodes whose index > current index
-        if finished perform bit shift on uint64 to get unique tree index and put it in configuration set
-        */
-        //do combination housekeeping
-        setTalent(visitedTalents, talentIndexReqPair.first);
-        talentPointsSpent += 1;
-        talentPointsLeft -= 1;
-        currentMultiplier *= sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][0];
-
-        combinations[talentPointsSpent - 1].emplace_back(visitedTalents);
-        allCombinations[talentPointsSpent - 1] += currentMultiplier;
-        runningCount++;
-        if (talentPointsLeft == 0)
-            return;
-
-        //add all possible children to the set for iteration
-        for (int i = 1; i < sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first].size(); i++) {
-            int childIndex = sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][i];
-            std::pair<int, int> targetPair = std::pair<int, int>(childIndex, sortedTreeDAG.sortedTalents[childIndex]->pointsRequired);
-            insertIntoVector(possibleTalents, targetPair);
-        }
-        //visit all possible children while keeping correct order
-        for (int i = currentPosTalIndex; i < possibleTalents.size(); i++) {
-            //check order is correct and if talentPointsSpent is >= next talent points required
-            if (possibleTalents[i].first > talentIndexReqPair.first &&
-                talentPointsSpent >= sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired) {
-                visitTalentParallel(possibleTalents[i], visitedTalents, i + 1, currentMultiplier, talentPointsSpent, talentPointsLeft, possibleTalents, sortedTreeDAG, combinations, allCombinations, runningCount, std::ref(safetyGuardTriggered));
-            }
-        }
-    }
-
+    void countConfigurationsStreaming(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        std::shared_ptr<SolveHandle> solveHandle,
+        std::shared_ptr<FilterExpression> filterExpression) {
 
-    /*
-    Parallel version of fast configuration counting that runs slower for individual Ns (where N is the amount of available talent points and N >= smallest path from top to bottom)
-    compared to single N count but includes all combinations for 1 up to N talent points.
-    */
-    std::shared_ptr<TreeDAGInfoLegacy> countConfigurationsParallelLegacy(TalentTree tree, int talentPointsLimit) {
+        inProgress = true;
         std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
         tree.unspentTalentPoints = talentPointsLimit;
-        int talentPoints = tree.unspentTalentPoints;
         //expand notes in tree
         expandTreeTalents(*processedTree);
-        //visualizeTree(tree, "expanded");
 
-        //create sorted DAG (is vector of vector and at most nx(m+1) Array where n = # nodes and m is the max amount of connections a node has to childs and 
-        //+1 because first column contains the weight (1 for regular talents and 2 for switch talents))
-        TreeDAGInfoLegacy sortedTreeDAG = createSortedMinimalDAGLegacy(*processedTree);
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        setSafetyGuard(sortedTreeDAG);
         sortedTreeDAG.processedTree = processedTree;
-        if (sortedTreeDAG.sortedTalents.size() > 64)
-            throw std::logic_error("Number of talents exceeds 64, need different indexing type instead of uint64");
-        vec2d<std::pair<SIND, int>> combinations;
-        combinations.resize(talentPoints);
-        std::vector<int> allCombinations;
-        allCombinations.resize(talentPoints, 0);
-
-        //iterate through all possible combinations in order:
-        //have 4 variables: visited nodes (int vector with capacity = # talent points), num talent points left, int vector of possible nodes to visit, weight of combination
-        //weight of combination = factor of 2 for every switch talent in path
-        SIND visitedTalents = 0;
-        int talentPointsLeft = tree.unspentTalentPoints;
-        //note:this will auto sort (not necessary but also doesn't hurt) and prevent duplicates
-        std::vector<std::pair<int, int>> possibleTalents;
-        //add roots to the list of possible talents first, then iterate recursively with visitTalent
-        for (auto& root : sortedTreeDAG.rootIndices) {
-            possibleTalents.push_back(std::pair<int, int>(root, sortedTreeDAG.sortedTalents[root]->pointsRequired));
+
+        //collect all switch talent choices
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            if (indexTalentPair.second->type == Engine::TalentType::SWITCH) {
+                sortedTreeDAG.switchTalentChoices.push_back({ indexTalentPair.first, 1 });
+            }
         }
+
+        //cached solves are replayed into the sink, otherwise the combinations are collected for the cache on the way to the sink
+        std::string cacheKey = createSolveKey(createSolveCacheKey(tree, sortedTreeDAG, talentPointsLimit, onlyLimitSolve, filter, filterExpression.get()), solveHandle.get());
+        //shards skip the solve cache since a replay would lose the task slots the sink gets (see CombinationSink::beginTask)
+        bool useSolveCache = solveHandle == nullptr || solveHandle->getShard().count <= 1;
+        //all bucket solves are buffered for the cache up to the memory budget, skip it if they can't fit anyway
+        useSolveCache = useSolveCache && (onlyLimitSolve || filter || filterExpression || !exceedsSafetyGuard(sortedTreeDAG, talentPointsLimit, false));
+        SolveCacheSink cacheSink(cacheKey, tree, talentPointsLimit, onlyLimitSolve, sink);
+        CombinationSink& solveSink = useSolveCache ? static_cast<CombinationSink&>(cacheSink) : sink;
+        solveSink.begin(sortedTreeDAG);
         auto t1 = std::chrono::high_resolution_clock::now();
-        //this is used for safeguarding solving process for trees that are too big
-        int runningCount = 0;
-        bool safetyGuardTriggered = false;
-        for (int i = 0; i < possibleTalents.size(); i++) {
-            //only start with root nodes that have points required == 0, prevents from starting at root nodes that might come later in the tree (e.g. druid wild charge)
-            //if (possibleTalents[i].second == 0)
-            if (sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired == 0)
-                visitTalentParallelLegacy(possibleTalents[i], visitedTalents, i + 1, 1, 0, talentPointsLeft, possibleTalents, sortedTreeDAG, combinations, allCombinations, runningCount, safetyGuardTriggered);
+        size_t runningCount = 0;
+        sortedTreeDAG.loadedFromSolveCache = useSolveCache
+            && replaySolveCache(cacheKey, sortedTreeDAG, talentPointsLimit, sink, runningCount, safetyGuardTriggered);
+        if (!sortedTreeDAG.loadedFromSolveCache) {
+            dispatchSkillsetIndexType(sortedTreeDAG.indexWords, [&](auto indexTag) {
+                using IndexType = decltype(indexTag);
+                BasicSkillsetFilterMasks<IndexType> filterMasks = createSkillsetFilterMasks<IndexType>(tree, sortedTreeDAG, filter);
+                if (filterExpression) {
+                    filterMasks.program = std::make_shared<BasicFilterProgram<IndexType>>(compileFilterProgram<IndexType>(*filterExpression, sortedTreeDAG));
+                }
+                visitTalentsFrontierStreaming(
+                    createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPointsLimit),
+                    talentPointsLimit,
+                    !onlyLimitSolve,
+                    filter || filterExpression ? &filterMasks : nullptr,
+                    solveSink,
+                    runningCount,
+                    safetyGuardTriggered,
+                    threadCount,
+                    solveHandle.get()
+                );
+            });
         }
+        solveSink.finish();
         if (safetyGuardTriggered) {
             sortedTreeDAG.safetyGuardTriggered = true;
         }
+        if (useSolveCache && !sortedTreeDAG.loadedFromSolveCache) {
+            cacheSink.store(sortedTreeDAG);
+        }
         auto t2 = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> ms_double = t2 - t1;
-        sortedTreeDAG.allCombinations = std::move(combinations);
+        //no combinations are stored but keep the per talent point layout of the other solvers
+        sortedTreeDAG.allCombinations.resize(onlyLimitSolve ? 1 : talentPointsLimit);
+        sortedTreeDAG.allCombinationsSum = runningCount;
         sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
-        return std::make_shared<TreeDAGInfoLegacy>(sortedTreeDAG);
+        inProgress = false;
+
+        treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
     }
 
-    /*
-    Parallel version of recursive talent visitation that does not early stop and keeps track of all paths shorter than max path length.
-    */
-    void visitTalentParallelLegacy(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfoLegacy& sortedTreeDAG,
-        vec2d<std::pair< SIND, int>>& combinations,
-        std::vector<int>& allCombinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
-    ) {
-        if (runningCount >= 500000000) {
-            safetyGuardTriggered = true;
-            return;
-        }
-        /*
-        for each node visited add child nodes(in DAG array) to the vector of possible nodesand reduce talent points left
-        check if talent points left == 0 (finish) or num_nodes - current_node < talent_points_left (check for off by one error) (cancel cause talent tree can't be filled)
-        iterate through all nodes in vector possible nodes to visit but only visit nodes whose index > current index
-        if finished perform bit shift on uint64 to get unique tree index and put it in configuration set
-        */
-        //do combination housekeeping
-        setTalent(visitedTalents, talentIndexReqPair.first);
-        talentPointsSpent += 1;
-        talentPointsLeft -= 1;
-        currentMultiplier *= sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][0];
-
-        combinations[talentPointsSpent - 1].emplace_back(visitedTalents, currentMultiplier);
-        allCombinations[talentPointsSpent - 1] += currentMultiplier;
-        runningCount++;
-        if (talentPointsLeft == 0)
-            return;
+    SolveHandle::SolveHandle() : startTime(std::chrono::steady_clock::now().time_since_epoch().count()) {
+    }
 
-        //add all possible children to the set for iteration
-        for (int i = 1; i < sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first].size(); i++) {
-            int childIndex = sortedTreeDAG.minimalTreeDAG[talentIndexReqPair.first][i];
-            std::pair<int, int> targetPair = std::pair<int, int>(childIndex, sortedTreeDAG.sortedTalents[childIndex]->pointsRequired);
-            insertIntoVector(possibleTalents, targetPair);
-        }
-        //visit all possible children while keeping correct order
-        for (int i = currentPosTalIndex; i < possibleTalents.size(); i++) {
-            //check order is correct and if talentPointsSpent is >= next talent points required
-            if (possibleTalents[i].first > talentIndexReqPair.first &&
-                talentPointsSpent >= sortedTreeDAG.sortedTalents[possibleTalents[i].first]->pointsRequired) {
-                visitTalentParallelLegacy(possibleTalents[i], visitedTalents, i + 1, currentMultiplier, talentPointsSpent, talentPointsLeft, possibleTalents, sortedTreeDAG, combinations, allCombinations, runningCount, safetyGuardTriggered);
-            }
-        }
+    void SolveHandle::cancel() {
+        canceled = true;
     }
 
-    /*
-    Creates a minimal representation of the TalentTree object as a vector of integer vectors, where each vector has informations about a talent such as switch multiplier
-    and child nodes. Wow talent trees are essentially DAGs and can therefore be topologically sorted. TreeDAGInfo contains the minimal tree representation,
-    a vector of raw Talents which correspond to the indices in the min. tree rep. and indices of root talents.
-    */
-    TreeDAGInfo createSortedMinimalDAG(TalentTree tree) {
-        //Note: Guarantees that the tree is sorted from left to right first, top to bottom second with each layer of the tree guaranteed to have a lower index than
-        //the following layer. This makes it possible to implement min. talent points required for a layer to unlock, checked while iterating in visitTalent, while keeping
-        //the algorithm the same and improving speed.
-        //note: EVEN THOUGH TREE IS PASSED BY COPY ALL PARENTS WILL BE DELETED FROM TALENTS!
-        TreeDAGInfo info;
-        std::vector<int> rootIndices;
-        for (int i = 0; i < tree.talentRoots.size(); i++) {
-            rootIndices.push_back(tree.talentRoots[i]->index);
-        }
-        //Original Kahn's algorithm description from https://en.wikipedia.org/wiki/Topological_sorting
-        /*
-        L ← Empty list that will contain the sorted elements    #info.minimalTreeDAG / info.sortedTalents
-        S ← Set of all nodes with no incoming edge              #tree.talentRoots
+    bool SolveHandle::isCanceled() const {
+        return canceled.load(std::memory_order_relaxed);
+    }
 
-        while S is not empty do
-            remove a node n from S
-            add n to L
-            for each node m with an edge e from n to m do
-                remove edge e from the graph
-                if m has no other incoming edges then
-                    insert m into S
+    void SolveHandle::markFinished() {
+        finished.store(true, std::memory_order_release);
+    }
 
-        if graph has edges then
-            return error   (graph has at least one cycle)
-        else
-            return L   (a topologically sorted order)
-        */
-        std::sort(tree.talentRoots.begin(), tree.talentRoots.end(), [](Talent_s a, Talent_s b) {
-            return a->pointsRequired < b->pointsRequired;
-            });
-        //while tree.talentRoots is not empty do
-        while (tree.talentRoots.size() > 0) {
-            //remove a node n from tree.talentRoots
-            Talent_s n = tree.talentRoots.front();
-            //note: terrible in theory but should not matter as vectors are small, otherwise use deque
-            tree.talentRoots.erase(tree.talentRoots.begin());
-            //add n to info.sortedTalents
-            //note: this could be simplified by changing the order of removing from tree.talentRoots and adding n to info.minimalTreeDAG
-            info.sortedTalents.push_back(n);
-            //for each node m with an edge e from n to m do
-            for (auto& m : n->children) {
-                //remove edge e from the graph
-                //note: it should suffice to just remove the parent in m since every node is only visited once so n->children does not have to be changed inside loop
-                if (m->parents.size() > 1) {
-                    TalentVec::iterator i = std::find(m->parents.begin(), m->parents.end(), n);
-                    if (i != m->parents.end()) {
-                        m->parents.erase(i);
+    bool SolveHandle::isFinished() const {
+        return finished.load(std::memory_order_acquire);
+    }
+
+    void SolveHandle::addTasks(size_t count) {
+        taskCount.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void SolveHandle::finishTasks(size_t count) {
+        finishedTaskCount.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void SolveHandle::addVisitedNodes(size_t count) {
+        visitedNodes.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void SolveHandle::addResults(size_t count) {
+        resultCount.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    size_t SolveHandle::getTaskCount() const {
+        return taskCount.load(std::memory_order_relaxed);
+    }
+
+    size_t SolveHandle::getFinishedTaskCount() const {
+        return finishedTaskCount.load(std::memory_order_relaxed);
+    }
+
+    size_t SolveHandle::getVisitedNodes() const {
+        return visitedNodes.load(std::memory_order_relaxed);
+    }
+
+    size_t SolveHandle::getResultCount() const {
+        return resultCount.load(std::memory_order_relaxed);
+    }
+
+    double SolveHandle::getProgress() const {
+        if (isFinished()) {
+            return 1.0;
+        }
+        size_t tasks = getTaskCount();
+        if (tasks == 0) {
+            return 0.0;
+        }
+        return (std::min)(1.0, static_cast<double>(getFinishedTaskCount()) / tasks);
+    }
+
+    double SolveHandle::getElapsedSeconds() const {
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(startTime);
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+    double SolveHandle::getEstimatedSecondsLeft() const {
+        double progress = getProgress();
+        if (progress <= 0.0) {
+            return -1.0;
+        }
+        return getElapsedSeconds() * (1.0 - progress) / progress;
+    }
+
+    void SolveHandle::setCheckpoint(std::shared_ptr<SolveCheckpoint> checkpoint) {
+        this->checkpoint = std::move(checkpoint);
+    }
+
+    SolveCheckpoint* SolveHandle::getCheckpoint() const {
+        return checkpoint.get();
+    }
+
+    void SolveHandle::setShard(SolveShard shard) {
+        if (shard.count < 1 || shard.index < 0 || shard.index >= shard.count) {
+            throw std::logic_error("Shard index has to be in [0, shard count)!");
+        }
+        this->shard = shard;
+    }
+
+    SolveShard SolveHandle::getShard() const {
+        return shard;
+    }
+
+    CallbackCombinationSink::CallbackCombinationSink(std::function<bool(const SIND* skillsetIndex, int talentPoints)> callback)
+        : callback(std::move(callback)) {
+    }
+
+    bool CallbackCombinationSink::push(CombinationBlock& block) {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        for (size_t i = 0; i < block.combinations.size(); i += block.indexWords) {
+            if (!callback(&block.combinations[i], block.talentPoints)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CombinationRingBuffer::CombinationRingBuffer(size_t capacity) {
+        //number of slots has to be a power of 2 so positions can be mapped to slots with a mask
+        size_t slotCount = 2;
+        while (slotCount < capacity) {
+            slotCount *= 2;
+        }
+        slots = std::make_unique<Slot[]>(slotCount);
+        for (size_t i = 0; i < slotCount; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        slotMask = slotCount - 1;
+    }
+
+    bool CombinationRingBuffer::push(CombinationBlock& block) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (!canceled.load(std::memory_order_relaxed)) {
+            Slot& slot = slots[position & slotMask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position) {
+                //slot is free, claim it
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.block = std::move(block);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position) {
+                //buffer is full, wait for the consumer
+                std::this_thread::yield();
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+            else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        return false;
+    }
+
+    void CombinationRingBuffer::finish() {
+        finished.store(true, std::memory_order_release);
+    }
+
+    bool CombinationRingBuffer::tryPop(CombinationBlock& block) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[position & slotMask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == position + 1) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    block = std::move(slot.block);
+                    slot.sequence.store(position + slotMask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position + 1) {
+                //buffer is empty
+                return false;
+            }
+            else {
+                position = dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool CombinationRingBuffer::isDone() {
+        if (!finished.load(std::memory_order_acquire)) {
+            return false;
+        }
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        return slots[position & slotMask].sequence.load(std::memory_order_acquire) != position + 1;
+    }
+
+    void CombinationRingBuffer::cancel() {
+        canceled.store(true, std::memory_order_relaxed);
+    }
+
+
+    /*
+    Returns the index of the lowest set bit (count trailing zeros), talents has to be non zero.
+    */
+    static inline int lowestTalentIndex(SIND talents) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, talents);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(talents);
+#endif
+    }
+
+    template<size_t Words>
+    static inline int lowestTalentIndex(const WideSkillsetIndex<Words>& talents) {
+        for (size_t i = 0; i < Words; i++) {
+            if (talents.words[i] != 0) {
+                return static_cast<int>(i * 64) + lowestTalentIndex(talents.words[i]);
+            }
+        }
+        return -1;
+    }
+
+    static inline void clearLowestTalent(SIND& talents) {
+        talents &= talents - 1;
+    }
+
+    template<size_t Words>
+    static inline void clearLowestTalent(WideSkillsetIndex<Words>& talents) {
+        for (size_t i = 0; i < Words; i++) {
+            if (talents.words[i] != 0) {
+                talents.words[i] &= talents.words[i] - 1;
+                return;
+            }
+        }
+    }
+
+    /*
+    Returns a mask of all talents with an index higher than talentIndex.
+    */
+    template<typename IndexType>
+    static inline IndexType laterTalentsMask(int talentIndex);
+
+    template<>
+    inline SIND laterTalentsMask<SIND>(int talentIndex) {
+        return talentIndex >= 63 ? 0 : ~0ULL << (talentIndex + 1);
+    }
+
+    template<size_t Words>
+    static inline WideSkillsetIndex<Words> wideLaterTalentsMask(int talentIndex) {
+        WideSkillsetIndex<Words> mask;
+        for (int i = 0; i < static_cast<int>(Words); i++) {
+            int shift = talentIndex + 1 - 64 * i;
+            mask.words[i] = shift <= 0 ? ~0ULL : (shift >= 64 ? 0 : ~0ULL << shift);
+        }
+        return mask;
+    }
+
+    template<>
+    inline SIND128 laterTalentsMask<SIND128>(int talentIndex) {
+        return wideLaterTalentsMask<2>(talentIndex);
+    }
+
+    template<>
+    inline SIND256 laterTalentsMask<SIND256>(int talentIndex) {
+        return wideLaterTalentsMask<4>(talentIndex);
+    }
+
+    /*
+    Combinations are stored as consecutive SINDs (TreeDAGInfo::indexWords per combination).
+    */
+    static inline void appendSkillsetIndex(std::vector<SIND>& combinations, SIND skillsetIndex) {
+        combinations.push_back(skillsetIndex);
+    }
+
+    template<size_t Words>
+    static inline void appendSkillsetIndex(std::vector<SIND>& combinations, const WideSkillsetIndex<Words>& skillsetIndex) {
+        combinations.insert(combinations.end(), skillsetIndex.words, skillsetIndex.words + Words);
+    }
+
+    /*
+    Same as checkSkillsetFilter but works for all skillset index widths.
+    */
+    template<typename IndexType>
+    static inline bool checkSkillsetFilterMasks(const IndexType& skillset, const BasicSkillsetFilterMasks<IndexType>& filter) {
+        if (hasTalents(skillset & filter.excludeFilter) || hasTalents((~skillset) & filter.includeFilter)
+            || (hasTalents(filter.orFilter) && !hasTalents(skillset & filter.orFilter))) {
+            return false;
+        }
+        if (filter.program && !filter.program->matches(skillset)) {
+            return false;
+        }
+        if (filter.oneFilter.size() == 0) {
+            return true;
+        }
+        size_t matches = 0;
+        for (auto& filterPair : filter.oneFilter) {
+            if (!hasTalents((~skillset) & filterPair.first) && !hasTalents(skillset & filterPair.second)) {
+                matches += 1;
+            }
+        }
+        return matches == 1;
+    }
+
+    /*
+    Returns false if none of the targets can be selected anymore. Every talent that is selected later is either reachable already
+    or a descendant of a reachable talent, so a target is reachable if one of its ancestors is (see BasicSkillsetFilterMasks::ancestorMasks).
+    */
+    template<typename IndexType>
+    static inline bool canReachTalents(IndexType targets, const IndexType& reachable, const BasicSkillsetFilterMasks<IndexType>& filter) {
+        while (hasTalents(targets)) {
+            if (!hasTalents(reachable & filter.ancestorMasks[lowestTalentIndex(targets)])) {
+                return false;
+            }
+            clearLowestTalent(targets);
+        }
+        return true;
+    }
+
+    /*
+    Constraint propagation of the filtered frontier kernels: returns false if a path can't be completed to a skillset that passes the
+    include, or and one filters anymore. selectable holds all talents with a higher index than the last selected talent that get
+    unlocked within the talent points limit and reachable the possible talents among them. Missing targets outside of selectable,
+    without a reachable ancestor or with more missing talents than talent points left cut the path at the earliest depth.
+    */
+    template<typename IndexType>
+    static inline bool canReachFilterTargets(
+        const IndexType& visitedTalents,
+        const IndexType& reachable,
+        const IndexType& selectable,
+        int talentPointsLeft,
+        const BasicSkillsetFilterMasks<IndexType>& filter)
+    {
+        IndexType missingIncludes = filter.includeFilter & ~visitedTalents;
+        int missingIncludeCount = countSelectedTalents(missingIncludes);
+        if (missingIncludeCount > 0 && (missingIncludeCount > talentPointsLeft || hasTalents(missingIncludes & ~selectable)
+            || !canReachTalents(missingIncludes, reachable, filter))) {
+            return false;
+        }
+        if (hasTalents(filter.orFilter) && !hasTalents(visitedTalents & filter.orFilter)) {
+            //an or talent that is also included is selected anyway, otherwise the or filter needs another talent point
+            bool needsPoint = !hasTalents(filter.orFilter & filter.includeFilter);
+            if ((needsPoint && missingIncludeCount + 1 > talentPointsLeft) || !hasTalents(reachable & filter.orAncestorMask)) {
+                return false;
+            }
+        }
+        if (filter.oneFilter.size() == 0) {
+            return true;
+        }
+        for (auto& filterPair : filter.oneFilter) {
+            IndexType missingGroup = filterPair.first & ~visitedTalents;
+            if (hasTalents(visitedTalents & filterPair.second) || hasTalents(missingGroup & ~selectable)
+                || countSelectedTalents(missingGroup & ~filter.includeFilter) + missingIncludeCount > talentPointsLeft) {
+                continue;
+            }
+            if (canReachTalents(missingGroup, reachable, filter)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    Hands the combinations of a bucket to the sink of a streaming solve and clears the bucket (keeps the allocation if the
+    sink did not take it). Returns false if the sink canceled the solve.
+    */
+    template<typename IndexType>
+    static bool flushCombinations(CombinationSink& sink, std::vector<SIND>& combinations, int talentPoints) {
+        if (combinations.size() == 0) {
+            return true;
+        }
+        CombinationBlock block;
+        block.talentPoints = talentPoints;
+        block.indexWords = SkillsetIndexTraits<IndexType>::words;
+        block.combinations.swap(combinations);
+        bool continueSolve = sink.push(block);
+        combinations.swap(block.combinations);
+        combinations.clear();
+        return continueSolve;
+    }
+
+    /*
+    Publishes the node and result counters of a kernel call to the solve handle every SOLVE_PROGRESS_INTERVAL visited nodes and when
+    the kernel returns, so the atomics of the handle are not touched per node. Kernel calls that start at the root report every
+    root talent as a task (single threaded solves), the threaded kernel reports its subtree tasks itself.
+    */
+    class SolveProgressReporter {
+    public:
+        SolveProgressReporter(SolveHandle* solveHandle, const size_t& runningCount, bool reportRootTasks)
+            : solveHandle(solveHandle), runningCount(runningCount), reportedCount(runningCount), reportRootTasks(reportRootTasks) {
+        }
+
+        ~SolveProgressReporter() {
+            if (solveHandle == nullptr) {
+                return;
+            }
+            flush();
+            //the last root task only finishes if the kernel wasn't stopped
+            if (reportRootTasks && rootTasks > 0 && !solveHandle->isCanceled()) {
+                solveHandle->finishTasks(1);
+            }
+        }
+
+        //returns false if the solve was canceled
+        inline bool visitNode(bool rootNode) {
+            if (solveHandle == nullptr) {
+                return true;
+            }
+            if (rootNode && reportRootTasks && rootTasks++ > 0) {
+                solveHandle->finishTasks(1);
+            }
+            if (++pendingNodes < SOLVE_PROGRESS_INTERVAL) {
+                return true;
+            }
+            flush();
+            return !solveHandle->isCanceled();
+        }
+
+    private:
+        void flush() {
+            solveHandle->addVisitedNodes(pendingNodes);
+            solveHandle->addResults(runningCount - reportedCount);
+            pendingNodes = 0;
+            reportedCount = runningCount;
+        }
+
+        SolveHandle* solveHandle;
+        const size_t& runningCount;
+        size_t reportedCount;
+        bool reportRootTasks;
+        size_t pendingNodes = 0;
+        size_t rootTasks = 0;
+    };
+
+    /*
+    Subtree of the search tree that is solved independently by the threaded frontier kernel. emittedBefore holds the size of every
+    combination bucket of the splitting pass at the time the task was created, i.e. where the results of this task belong.
+    */
+    template<typename IndexType>
+    struct FrontierTask {
+        BasicFrontierFrame<IndexType> frame;
+        int depth = 0;
+        std::vector<size_t> emittedBefore;
+    };
+
+    /*
+    Running task of a checkpointed solve (see visitTalentsFrontierFixedLayoutImpl). The kernel saves its explicit stack from the
+    task depth on together with the combinations found since the last save to the checkpoint whenever the checkpoint interval passed,
+    the clock is only read every SOLVE_PROGRESS_INTERVAL nodes.
+    */
+    template<typename IndexType>
+    class FrontierCheckpointTask {
+    public:
+        FrontierCheckpointTask(SolveCheckpoint& checkpoint, size_t task, const vec2d<SIND>& combinations)
+            : checkpoint(checkpoint), task(task), combinations(combinations), lastSave(std::chrono::steady_clock::now()) {
+            for (auto& bucket : combinations) {
+                savedSizes.push_back(bucket.size());
+            }
+        }
+
+        inline bool isDue() {
+            if (++pendingNodes < SOLVE_PROGRESS_INTERVAL) {
+                return false;
+            }
+            pendingNodes = 0;
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - lastSave).count() >= checkpoint.getInterval();
+        }
+
+        void save(const BasicFrontierFrame<IndexType>* frames, int frameCount, bool finished) {
+            std::vector<SIND> frameWords;
+            for (int i = 0; i < frameCount; i++) {
+                appendSkillsetIndex(frameWords, frames[i].visitedTalents);
+                appendSkillsetIndex(frameWords, frames[i].possibleTalents);
+                appendSkillsetIndex(frameWords, frames[i].candidates);
+            }
+            checkpoint.appendTask(task, finished, frameWords, combinations, savedSizes);
+            for (size_t i = 0; i < combinations.size(); i++) {
+                savedSizes[i] = combinations[i].size();
+            }
+            lastSave = std::chrono::steady_clock::now();
+        }
+
+    private:
+        SolveCheckpoint& checkpoint;
+        size_t task;
+        const vec2d<SIND>& combinations;
+        std::vector<size_t> savedSizes;
+        std::chrono::steady_clock::time_point lastSave;
+        size_t pendingNodes = 0;
+    };
+
+    /*
+    Bitmask frontier kernel that replaces the recursive visitTalent* functions in the solvers. Instead of copying a sorted vector of
+    possible talents on every call, the reachable talents are kept as a single skillset index and the next talent to visit is picked with
+    count trailing zeros, which visits paths in exactly the same order as visitTalent*. The recursion is replaced by an explicit
+    fixed size stack indexed by depth (= talent points spent) so no allocation happens per visited node.
+    StoreAllLengths stores every path into combinations[talentPointsSpent - 1] (parallel solver), otherwise only complete paths
+    are stored into combinations[0], optionally filtered.
+    SplitTasks does not descend below splitDepth but stores the frames at that depth as tasks for the threaded kernel.
+    If a sink is given, full buckets are handed to the sink instead of growing (streaming solve).
+    resumeFrames continues a checkpointed task from its saved stack (frames from startDepth on, startFrame is ignored), checkpointTask
+    saves the stack of the running task to its checkpoint.
+    */
+    template<typename IndexType, bool StoreAllLengths, bool UseFilter, bool SplitTasks = false>
+    static void visitTalentsFrontierImpl(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        const BasicSkillsetFilterMasks<IndexType>* filter,
+        const BasicFrontierFrame<IndexType>& startFrame,
+        int startDepth,
+        std::vector<SIND>* combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int splitDepth = 0,
+        std::vector<FrontierTask<IndexType>>* tasks = nullptr,
+        CombinationSink* sink = nullptr,
+        SolveHandle* solveHandle = nullptr,
+        const std::vector<BasicFrontierFrame<IndexType>>* resumeFrames = nullptr,
+        FrontierCheckpointTask<IndexType>* checkpointTask = nullptr)
+    {
+        const size_t streamBlockWords = SOLVER_STREAM_BLOCK_SIZE * SkillsetIndexTraits<IndexType>::words;
+        BasicFrontierFrame<IndexType> stack[64 * SkillsetIndexTraits<IndexType>::words + 1];
+        SolveProgressReporter progress(solveHandle, runningCount, !SplitTasks && startDepth == 0);
+        int depth = startDepth;
+        stack[depth] = startFrame;
+        if (resumeFrames != nullptr) {
+            for (size_t i = 0; i < resumeFrames->size(); i++) {
+                stack[startDepth + i] = (*resumeFrames)[i];
+            }
+            depth = startDepth + static_cast<int>(resumeFrames->size()) - 1;
+        }
+        while (depth >= startDepth) {
+            BasicFrontierFrame<IndexType>& frame = stack[depth];
+            if (!hasTalents(frame.candidates)) {
+                depth--;
+                continue;
+            }
+            if (safetyGuardTriggered) {
+                return;
+            }
+            if (!progress.visitNode(depth == startDepth)) {
+                if (checkpointTask != nullptr) {
+                    checkpointTask->save(stack + startDepth, depth - startDepth + 1, false);
+                }
+                safetyGuardTriggered = true;
+                return;
+            }
+            if (checkpointTask != nullptr && checkpointTask->isDue()) {
+                checkpointTask->save(stack + startDepth, depth - startDepth + 1, false);
+            }
+            //do combination housekeeping
+            int talentIndex = lowestTalentIndex(frame.candidates);
+            clearLowestTalent(frame.candidates);
+            IndexType visitedTalents = frame.visitedTalents;
+            setTalent(visitedTalents, talentIndex);
+            int talentPointsSpent = depth + 1;
+            int talentPointsLeft = talentPointsLimit - talentPointsSpent;
+            if (StoreAllLengths && (!UseFilter || checkSkillsetFilterMasks(visitedTalents, *filter))) {
+                if (runningCount >= safetyGuard) {
+                    safetyGuardTriggered = true;
+                    return;
+                }
+                std::vector<SIND>& bucket = combinations[talentPointsSpent - 1];
+                appendSkillsetIndex(bucket, visitedTalents);
+                runningCount++;
+                if (sink != nullptr && bucket.size() >= streamBlockWords && !flushCombinations<IndexType>(*sink, bucket, talentPointsSpent)) {
+                    safetyGuardTriggered = true;
+                    return;
+                }
+            }
+            //check if path is complete
+            if (talentPointsLeft == 0) {
+                if (!StoreAllLengths && (!UseFilter || checkSkillsetFilterMasks(visitedTalents, *filter))) {
+                    if (runningCount >= safetyGuard) {
+                        safetyGuardTriggered = true;
+                        return;
                     }
-                    else {
-                        //If this happens then n has m as child but m does not have n as parent! Bug!
-                        throw std::logic_error("child has missing parent");
+                    appendSkillsetIndex(combinations[0], visitedTalents);
+                    runningCount++;
+                    if (sink != nullptr && combinations[0].size() >= streamBlockWords && !flushCombinations<IndexType>(*sink, combinations[0], talentPointsSpent)) {
+                        safetyGuardTriggered = true;
+                        return;
+                    }
+                }
+                continue;
+            }
+            //check if path can be finished and if exclude filter is violated (same early stopping as visitTalentFiltered)
+            if (!StoreAllLengths && masks.talentCount - talentIndex - 1 < talentPointsLeft) {
+                continue;
+            }
+            if (UseFilter && hasTalents(visitedTalents & filter->excludeFilter)) {
+                continue;
+            }
+            IndexType laterTalents = laterTalentsMask<IndexType>(talentIndex);
+            IndexType possibleTalents = frame.possibleTalents | masks.childMasks[talentIndex];
+            //include, or and one filter talents that can't be reached anymore (see canReachFilterTargets)
+            if (UseFilter && filter->ancestorMasks.size() > 0) {
+                IndexType selectable = laterTalents & masks.unlockedMasks[talentPointsLimit - 1];
+                if (!canReachFilterTargets(visitedTalents, possibleTalents & selectable, selectable, talentPointsLeft, *filter)) {
+                    continue;
+                }
+            }
+            //filter expressions that are false for every completion of the path (three valued, see BasicFilterProgram::evaluate)
+            if (UseFilter && filter->program && !filter->program->isSatisfiable(visitedTalents, laterTalents, talentPointsLeft)) {
+                continue;
+            }
+            //next candidates are all reachable talents with a higher index whose points required are fulfilled
+            BasicFrontierFrame<IndexType>& nextFrame = stack[depth + 1];
+            nextFrame.visitedTalents = visitedTalents;
+            nextFrame.possibleTalents = possibleTalents;
+            nextFrame.candidates = possibleTalents & laterTalents & masks.unlockedMasks[talentPointsSpent];
+            if (SplitTasks && talentPointsSpent == splitDepth) {
+                if (hasTalents(nextFrame.candidates)) {
+                    FrontierTask<IndexType> task;
+                    task.frame = nextFrame;
+                    task.depth = talentPointsSpent;
+                    size_t bucketCount = StoreAllLengths ? static_cast<size_t>(talentPointsLimit) : 1;
+                    for (size_t i = 0; i < bucketCount; i++) {
+                        task.emittedBefore.push_back(combinations[i].size());
                     }
+                    tasks->push_back(std::move(task));
+                }
+                continue;
+            }
+            depth++;
+        }
+    }
+
+    /*
+    Task queues of the threaded frontier kernel. Every worker owns a contiguous block of tasks (in search order) and takes tasks
+    from the front of its own queue, idle workers steal from the back of the other queues.
+    */
+    class FrontierTaskQueues {
+    public:
+        FrontierTaskQueues(size_t workerCount, size_t taskCount) : queues(workerCount), mutexes(workerCount) {
+            for (size_t w = 0; w < workerCount; w++) {
+                for (size_t t = w * taskCount / workerCount; t < (w + 1) * taskCount / workerCount; t++) {
+                    queues[w].push_back(t);
+                }
+            }
+        }
+
+        bool pop(size_t worker, size_t& task) {
+            {
+                std::lock_guard<std::mutex> lock(mutexes[worker]);
+                if (!queues[worker].empty()) {
+                    task = queues[worker].front();
+                    queues[worker].pop_front();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); i++) {
+                size_t victim = (worker + i) % queues.size();
+                std::lock_guard<std::mutex> lock(mutexes[victim]);
+                if (!queues[victim].empty()) {
+                    task = queues[victim].back();
+                    queues[victim].pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        std::vector<std::deque<size_t>> queues;
+        std::vector<std::mutex> mutexes;
+    };
+
+    /*
+    Version of the threaded frontier kernel with a task layout that doesn't depend on the number of threads, used for solves with a
+    checkpoint (see SolveCheckpoint) or a shard (see SolveShard). The search tree is split into at least SOLVER_FIXED_LAYOUT_TASKS
+    tasks, a shard only solves its own task slots (slot t holds the split results in front of task t and the task itself, the last
+    slot the split results behind the last task). Every task collects its results in its own buffer that is saved to the checkpoint
+    when the task finishes (and while it runs, see FrontierCheckpointTask). Finished tasks of a resumed checkpoint are replayed,
+    unfinished ones continue from their saved stack. The results are merged like in the threaded kernel, a single threaded sink
+    receives every bucket in search order, so a resumed solve produces the same output as an uninterrupted one and the task slots
+    of all shards in slot order are the output of the whole tree.
+    */
+    template<typename IndexType, bool StoreAllLengths, bool UseFilter>
+    static void visitTalentsFrontierFixedLayoutImpl(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        const BasicSkillsetFilterMasks<IndexType>* filter,
+        vec2d<SIND>& combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        CombinationSink* sink,
+        SolveHandle* solveHandle)
+    {
+        constexpr size_t words = SkillsetIndexTraits<IndexType>::words;
+        SolveCheckpoint* checkpoint = solveHandle->getCheckpoint();
+        SolveShard shard = solveHandle->getShard();
+        size_t bucketCount = StoreAllLengths ? static_cast<size_t>(talentPointsLimit) : 1;
+        auto flushBuckets = [&](vec2d<SIND>& buckets) {
+            for (size_t b = 0; b < bucketCount; b++) {
+                int talentPoints = StoreAllLengths ? static_cast<int>(b) + 1 : talentPointsLimit;
+                if (!flushCombinations<IndexType>(*sink, buckets[b], talentPoints)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto isShardSlot = [&](size_t slot) {
+            return static_cast<int>(slot % static_cast<size_t>(shard.count)) == shard.index;
+        };
+
+        //the task layout only depends on the tree and is part of the checkpoint
+        vec2d<SIND> splitCombinations(bucketCount);
+        std::vector<FrontierTask<IndexType>> tasks;
+        size_t splitRunningCount = runningCount;
+        int taskDepth = 0;
+        if (talentPointsLimit <= 1) {
+            //nothing to split, all results belong to the only task slot
+            visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter>(
+                masks, talentPointsLimit, filter, createRootFrontierFrame(masks), 0, splitCombinations.data(),
+                splitRunningCount, safetyGuard, safetyGuardTriggered);
+        }
+        for (int splitDepth = 1; splitDepth < talentPointsLimit; splitDepth++) {
+            splitCombinations.assign(bucketCount, std::vector<SIND>());
+            tasks.clear();
+            splitRunningCount = runningCount;
+            visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter, true>(
+                masks, talentPointsLimit, filter, createRootFrontierFrame(masks), 0, splitCombinations.data(),
+                splitRunningCount, safetyGuard, safetyGuardTriggered, splitDepth, &tasks);
+            taskDepth = splitDepth;
+            if (tasks.size() >= SOLVER_FIXED_LAYOUT_TASKS || splitDepth >= SOLVER_MAX_SPLIT_DEPTH) {
+                break;
+            }
+        }
+        //split results of a slot
+        auto getSplitRange = [&](size_t slot, size_t b) {
+            size_t begin = slot > 0 ? tasks[slot - 1].emittedBefore[b] : 0;
+            size_t end = slot < tasks.size() ? tasks[slot].emittedBefore[b] : splitCombinations[b].size();
+            return std::make_pair(begin, end);
+        };
+        auto flushSplit = [&](size_t slot) {
+            vec2d<SIND> splitBuckets(bucketCount);
+            for (size_t b = 0; b < bucketCount; b++) {
+                std::pair<size_t, size_t> range = getSplitRange(slot, b);
+                splitBuckets[b].assign(splitCombinations[b].begin() + range.first, splitCombinations[b].begin() + range.second);
+            }
+            return flushBuckets(splitBuckets);
+        };
+        if (shard.count > 1) {
+            splitRunningCount = runningCount;
+            for (size_t slot = 0; slot <= tasks.size(); slot++) {
+                for (size_t b = 0; b < bucketCount && isShardSlot(slot); b++) {
+                    std::pair<size_t, size_t> range = getSplitRange(slot, b);
+                    splitRunningCount += (range.second - range.first) / words;
+                }
+            }
+        }
+        if (checkpoint != nullptr) {
+            checkpoint->start({
+                static_cast<std::int64_t>(words), StoreAllLengths, UseFilter, talentPointsLimit, taskDepth, static_cast<std::int64_t>(tasks.size())
+                });
+        }
+        solveHandle->addResults(splitRunningCount - runningCount);
+        runningCount = splitRunningCount;
+
+        //restore the tasks of a resumed checkpoint
+        std::vector<vec2d<SIND>> taskCombinations(tasks.size(), vec2d<SIND>(bucketCount));
+        std::vector<std::vector<BasicFrontierFrame<IndexType>>> resumeFrames(tasks.size());
+        std::vector<char> taskFinished(tasks.size(), 0);
+        std::vector<size_t> pendingTasks;
+        for (size_t t = 0; t < tasks.size(); t++) {
+            if (!isShardSlot(t)) {
+                continue;
+            }
+            solveHandle->addTasks(1);
+            std::unique_ptr<SolveCheckpointTask> state = checkpoint != nullptr ? checkpoint->takeTask(t) : nullptr;
+            size_t frameCount = state ? state->frames.size() / (3 * words) : 0;
+            if (state && state->combinations.size() == bucketCount && state->frames.size() == frameCount * 3 * words
+                && (state->finished || (frameCount > 0 && tasks[t].depth + frameCount <= static_cast<size_t>(talentPointsLimit)))) {
+                size_t restoredCount = 0;
+                for (auto& bucket : state->combinations) {
+                    restoredCount += bucket.size() / words;
+                }
+                for (size_t i = 0; i < frameCount; i++) {
+                    const SIND* frameWords = state->frames.data() + 3 * words * i;
+                    BasicFrontierFrame<IndexType> frame;
+                    frame.visitedTalents = loadSkillsetIndex<IndexType>(frameWords);
+                    frame.possibleTalents = loadSkillsetIndex<IndexType>(frameWords + words);
+                    frame.candidates = loadSkillsetIndex<IndexType>(frameWords + 2 * words);
+                    resumeFrames[t].push_back(frame);
+                }
+                taskCombinations[t] = std::move(state->combinations);
+                taskFinished[t] = state->finished;
+                runningCount += restoredCount;
+                solveHandle->addResults(restoredCount);
+                if (state->finished) {
+                    solveHandle->finishTasks(1);
+                }
+            }
+            if (!taskFinished[t]) {
+                pendingTasks.push_back(t);
+            }
+        }
+
+        std::atomic<size_t> totalCount(runningCount);
+        std::atomic<bool> stopWorkers(safetyGuardTriggered);
+        auto runTask = [&](size_t taskIndex) {
+            vec2d<SIND>& buffer = taskCombinations[taskIndex];
+            std::optional<FrontierCheckpointTask<IndexType>> checkpointTask;
+            if (checkpoint != nullptr) {
+                checkpointTask.emplace(*checkpoint, taskIndex, buffer);
+            }
+            size_t taskCount = 0;
+            bool taskGuardTriggered = false;
+            size_t taskSafetyGuard = safetyGuard == SIZE_MAX ? SIZE_MAX : safetyGuard - (std::min)(safetyGuard, totalCount.load());
+            visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter>(
+                masks, talentPointsLimit, filter, tasks[taskIndex].frame, tasks[taskIndex].depth, buffer.data(),
+                taskCount, taskSafetyGuard, taskGuardTriggered, 0, nullptr, nullptr, solveHandle,
+                resumeFrames[taskIndex].size() > 0 ? &resumeFrames[taskIndex] : nullptr, checkpointTask ? &*checkpointTask : nullptr);
+            if (!taskGuardTriggered) {
+                if (checkpointTask) {
+                    checkpointTask->save(nullptr, 0, true);
+                }
+                solveHandle->finishTasks(1);
+                taskFinished[taskIndex] = 1;
+            }
+            if (taskGuardTriggered || totalCount.fetch_add(taskCount) + taskCount >= safetyGuard) {
+                stopWorkers = true;
+            }
+            return !taskGuardTriggered;
+        };
+
+        if (threadCount <= 1) {
+            //task slots in search order, the sink gets the split results in front of the task they belong to
+            for (size_t slot = 0; slot <= tasks.size() && !stopWorkers; slot++) {
+                if (!isShardSlot(slot)) {
+                    continue;
+                }
+                if (slot < tasks.size() && !taskFinished[slot] && !runTask(slot)) {
+                    break;
+                }
+                if (sink == nullptr) {
+                    continue;
+                }
+                if (shard.count > 1) {
+                    sink->beginTask(slot);
+                }
+                if (!flushSplit(slot) || (slot < tasks.size() && !flushBuckets(taskCombinations[slot]))) {
+                    stopWorkers = true;
+                }
+            }
+        }
+        else {
+            if (sink != nullptr && !stopWorkers) {
+                bool flushed = true;
+                for (size_t slot = 0; slot <= tasks.size() && flushed; slot++) {
+                    if (isShardSlot(slot)) {
+                        flushed = flushSplit(slot) && (slot == tasks.size() || !taskFinished[slot] || flushBuckets(taskCombinations[slot]));
+                    }
+                }
+                stopWorkers = !flushed;
+            }
+            FrontierTaskQueues queues(threadCount, pendingTasks.size());
+            auto worker = [&](size_t workerIndex) {
+                size_t pendingIndex;
+                while (!stopWorkers && queues.pop(workerIndex, pendingIndex)) {
+                    size_t taskIndex = pendingTasks[pendingIndex];
+                    if (runTask(taskIndex) && sink != nullptr && !flushBuckets(taskCombinations[taskIndex])) {
+                        stopWorkers = true;
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            for (int i = 0; i < threadCount; i++) {
+                workers.emplace_back(worker, static_cast<size_t>(i));
+            }
+            for (auto& t : workers) {
+                t.join();
+            }
+        }
+        if (stopWorkers) {
+            safetyGuardTriggered = true;
+        }
+        runningCount = totalCount;
+        //canceled solves keep their checkpoint, completed ones and solves that hit the safety guard don't need it anymore
+        if (checkpoint != nullptr && (!safetyGuardTriggered || !solveHandle->isCanceled())) {
+            checkpoint->remove();
+        }
+        if (sink != nullptr) {
+            return;
+        }
+
+        //merge split results and task results in search order
+        for (size_t b = 0; b < bucketCount; b++) {
+            std::vector<SIND>& bucket = combinations[b];
+            for (size_t slot = 0; slot <= tasks.size(); slot++) {
+                if (isShardSlot(slot)) {
+                    std::pair<size_t, size_t> range = getSplitRange(slot, b);
+                    bucket.insert(bucket.end(), splitCombinations[b].begin() + range.first, splitCombinations[b].begin() + range.second);
+                }
+                if (slot < tasks.size()) {
+                    bucket.insert(bucket.end(), taskCombinations[slot][b].begin(), taskCombinations[slot][b].end());
+                    std::vector<SIND>().swap(taskCombinations[slot][b]);
+                }
+            }
+            std::vector<SIND>().swap(splitCombinations[b]);
+        }
+    }
+
+    /*
+    Multi threaded version of the frontier kernel. The search tree is split into subtree tasks by expanding the first few decisions
+    (the root choice and the following talents) until there are enough tasks for all threads, these tasks are then solved on a
+    work stealing pool. Every thread writes into its own result buffer and remembers which range belongs to which task, the buffers
+    are merged in search order at the end. Therefore the result is identical to the single threaded kernel (as long as the safety
+    guard is not triggered), independent of the number of threads and the scheduling. threadCount <= 0 uses all hardware threads.
+    With a sink (streaming solve) results are handed to the sink whenever a block is full or a task is finished and nothing is merged.
+    Solves with a checkpoint or a shard run visitTalentsFrontierFixedLayoutImpl instead.
+    */
+    template<typename IndexType, bool StoreAllLengths, bool UseFilter>
+    static void visitTalentsFrontierThreadedImpl(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        const BasicSkillsetFilterMasks<IndexType>* filter,
+        vec2d<SIND>& combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        CombinationSink* sink = nullptr,
+        SolveHandle* solveHandle = nullptr)
+    {
+        size_t bucketCount = StoreAllLengths ? static_cast<size_t>(talentPointsLimit) : 1;
+        if (combinations.size() < bucketCount) {
+            combinations.resize(bucketCount);
+        }
+        auto flushBuckets = [&](vec2d<SIND>& buckets) {
+            for (size_t b = 0; b < bucketCount; b++) {
+                int talentPoints = StoreAllLengths ? static_cast<int>(b) + 1 : talentPointsLimit;
+                if (!flushCombinations<IndexType>(*sink, buckets[b], talentPoints)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(std::thread::hardware_concurrency());
+        }
+        if (solveHandle != nullptr && solveHandle->isCanceled()) {
+            safetyGuardTriggered = true;
+        }
+        if (solveHandle != nullptr && (solveHandle->getCheckpoint() != nullptr || solveHandle->getShard().count > 1) && !safetyGuardTriggered) {
+            visitTalentsFrontierFixedLayoutImpl<IndexType, StoreAllLengths, UseFilter>(
+                masks, talentPointsLimit, filter, combinations, runningCount, safetyGuard, safetyGuardTriggered, threadCount, sink, solveHandle);
+            return;
+        }
+        if (threadCount <= 1 || talentPointsLimit <= 1) {
+            if (solveHandle != nullptr) {
+                IndexType rootCandidates = createRootFrontierFrame(masks).candidates;
+                size_t rootTaskCount = 0;
+                for (; hasTalents(rootCandidates); clearLowestTalent(rootCandidates)) {
+                    rootTaskCount++;
+                }
+                solveHandle->addTasks(rootTaskCount);
+            }
+            visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter>(
+                masks, talentPointsLimit, filter, createRootFrontierFrame(masks), 0, combinations.data(), runningCount, safetyGuard, safetyGuardTriggered,
+                0, nullptr, sink, solveHandle);
+            if (sink != nullptr && !flushBuckets(combinations)) {
+                safetyGuardTriggered = true;
+            }
+            return;
+        }
+
+        //split search tree until there are enough tasks to keep all threads busy even if subtrees are very unbalanced
+        vec2d<SIND> splitCombinations;
+        std::vector<FrontierTask<IndexType>> tasks;
+        size_t splitRunningCount = 0;
+        for (int splitDepth = 1; splitDepth < talentPointsLimit; splitDepth++) {
+            splitCombinations.assign(bucketCount, std::vector<SIND>());
+            tasks.clear();
+            splitRunningCount = runningCount;
+            visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter, true>(
+                masks, talentPointsLimit, filter, createRootFrontierFrame(masks), 0, splitCombinations.data(),
+                splitRunningCount, safetyGuard, safetyGuardTriggered, splitDepth, &tasks);
+            if (tasks.size() >= static_cast<size_t>(threadCount) * SOLVER_TASKS_PER_THREAD || splitDepth >= SOLVER_MAX_SPLIT_DEPTH) {
+                break;
+            }
+        }
+        if (solveHandle != nullptr) {
+            solveHandle->addResults(splitRunningCount - runningCount);
+            solveHandle->addTasks(tasks.size());
+        }
+        runningCount = splitRunningCount;
+        if (sink != nullptr && !flushBuckets(splitCombinations)) {
+            safetyGuardTriggered = true;
+        }
+
+        //solve subtrees on the work stealing pool, every thread keeps its own result buffer
+        struct TaskResult {
+            size_t worker = 0;
+            std::vector<size_t> begin;
+            std::vector<size_t> end;
+        };
+        std::vector<TaskResult> taskResults(tasks.size());
+        std::vector<vec2d<SIND>> workerCombinations(threadCount, vec2d<SIND>(bucketCount));
+        FrontierTaskQueues queues(threadCount, tasks.size());
+        std::atomic<size_t> totalCount(runningCount);
+        std::atomic<bool> stopWorkers(safetyGuardTriggered);
+        auto worker = [&](size_t workerIndex) {
+            size_t taskIndex;
+            vec2d<SIND>& buffer = workerCombinations[workerIndex];
+            while (!stopWorkers && queues.pop(workerIndex, taskIndex)) {
+                if (safetyGuardTriggered) {
+                    stopWorkers = true;
+                    break;
+                }
+                TaskResult& result = taskResults[taskIndex];
+                result.worker = workerIndex;
+                for (auto& bucket : buffer) {
+                    result.begin.push_back(bucket.size());
+                }
+                size_t taskCount = 0;
+                bool taskGuardTriggered = false;
+                size_t taskSafetyGuard = safetyGuard == SIZE_MAX ? SIZE_MAX : safetyGuard - (std::min)(safetyGuard, totalCount.load());
+                visitTalentsFrontierImpl<IndexType, StoreAllLengths, UseFilter>(
+                    masks, talentPointsLimit, filter, tasks[taskIndex].frame, tasks[taskIndex].depth, buffer.data(),
+                    taskCount, taskSafetyGuard, taskGuardTriggered, 0, nullptr, sink, solveHandle);
+                if (solveHandle != nullptr && !taskGuardTriggered) {
+                    solveHandle->finishTasks(1);
+                }
+                for (auto& bucket : buffer) {
+                    result.end.push_back(bucket.size());
+                }
+                if (sink != nullptr && !taskGuardTriggered && !flushBuckets(buffer)) {
+                    taskGuardTriggered = true;
+                }
+                if (taskGuardTriggered || totalCount.fetch_add(taskCount) + taskCount >= safetyGuard) {
+                    stopWorkers = true;
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(worker, static_cast<size_t>(i));
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (stopWorkers) {
+            safetyGuardTriggered = true;
+        }
+        runningCount = totalCount;
+        if (sink != nullptr) {
+            return;
+        }
+
+        //merge split results and task results in search order
+        for (size_t b = 0; b < bucketCount; b++) {
+            size_t bucketSize = splitCombinations[b].size();
+            for (auto& result : taskResults) {
+                if (result.end.size() > 0) {
+                    bucketSize += result.end[b] - result.begin[b];
+                }
+            }
+            std::vector<SIND>& bucket = combinations[b];
+            bucket.reserve(bucket.size() + bucketSize);
+            size_t splitPosition = 0;
+            for (size_t t = 0; t < tasks.size(); t++) {
+                size_t splitEnd = tasks[t].emittedBefore[b];
+                bucket.insert(bucket.end(), splitCombinations[b].begin() + splitPosition, splitCombinations[b].begin() + splitEnd);
+                splitPosition = splitEnd;
+                TaskResult& result = taskResults[t];
+                if (result.end.size() > 0) {
+                    std::vector<SIND>& workerBucket = workerCombinations[result.worker][b];
+                    bucket.insert(bucket.end(), workerBucket.begin() + result.begin[b], workerBucket.begin() + result.end[b]);
+                }
+            }
+            bucket.insert(bucket.end(), splitCombinations[b].begin() + splitPosition, splitCombinations[b].end());
+            //free memory as early as possible since merging temporarily doubles the memory footprint
+            std::vector<SIND>().swap(splitCombinations[b]);
+            for (auto& workerBuffer : workerCombinations) {
+                std::vector<SIND>().swap(workerBuffer[b]);
+            }
+        }
+    }
+
+    template<typename IndexType>
+    void visitTalentsFrontierSingle(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        std::vector<SIND>& combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        SolveHandle* solveHandle
+    ) {
+        vec2d<SIND> buckets(1);
+        buckets[0] = std::move(combinations);
+        visitTalentsFrontierThreadedImpl<IndexType, false, false>(
+            masks, talentPointsLimit, nullptr, buckets, runningCount, safetyGuard, safetyGuardTriggered, threadCount, nullptr, solveHandle);
+        combinations = std::move(buckets[0]);
+    }
+
+    template<typename IndexType>
+    void visitTalentsFrontierFiltered(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        const BasicSkillsetFilterMasks<IndexType>& filter,
+        std::vector<SIND>& combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        SolveHandle* solveHandle
+    ) {
+        vec2d<SIND> buckets(1);
+        buckets[0] = std::move(combinations);
+        visitTalentsFrontierThreadedImpl<IndexType, false, true>(
+            masks, talentPointsLimit, &filter, buckets, runningCount, safetyGuard, safetyGuardTriggered, threadCount, nullptr, solveHandle);
+        combinations = std::move(buckets[0]);
+    }
+
+    template<typename IndexType>
+    void visitTalentsFrontierParallel(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        vec2d<SIND>& combinations,
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        SolveHandle* solveHandle
+    ) {
+        visitTalentsFrontierThreadedImpl<IndexType, true, false>(
+            masks, talentPointsLimit, nullptr, combinations, runningCount, safetyGuard, safetyGuardTriggered, threadCount, nullptr, solveHandle);
+    }
+
+    /*
+    Frontier kernel of streaming solves, storeAllLengths selects the parallel solver behavior (all paths with 1 up to talentPointsLimit
+    talent points), otherwise only complete paths are pushed. A filter can be used in both modes (nullptr for no filter).
+    */
+    template<typename IndexType>
+    void visitTalentsFrontierStreaming(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        bool storeAllLengths,
+        const BasicSkillsetFilterMasks<IndexType>* filter,
+        CombinationSink& sink,
+        size_t& runningCount,
+        bool& safetyGuardTriggered,
+        int threadCount,
+        SolveHandle* solveHandle
+    ) {
+        vec2d<SIND> buckets;
+        if (storeAllLengths && filter != nullptr) {
+            visitTalentsFrontierThreadedImpl<IndexType, true, true>(
+                masks, talentPointsLimit, filter, buckets, runningCount, SIZE_MAX, safetyGuardTriggered, threadCount, &sink, solveHandle);
+        }
+        else if (storeAllLengths) {
+            visitTalentsFrontierThreadedImpl<IndexType, true, false>(
+                masks, talentPointsLimit, nullptr, buckets, runningCount, SIZE_MAX, safetyGuardTriggered, threadCount, &sink, solveHandle);
+        }
+        else if (filter != nullptr) {
+            visitTalentsFrontierThreadedImpl<IndexType, false, true>(
+                masks, talentPointsLimit, filter, buckets, runningCount, SIZE_MAX, safetyGuardTriggered, threadCount, &sink, solveHandle);
+        }
+        else {
+            visitTalentsFrontierThreadedImpl<IndexType, false, false>(
+                masks, talentPointsLimit, nullptr, buckets, runningCount, SIZE_MAX, safetyGuardTriggered, threadCount, &sink, solveHandle);
+        }
+    }
+
+    /*
+    Returns the number of SINDs that are needed to index a tree with talentCount expanded talents (1, 2 or 4).
+    */
+    int getSkillsetIndexWords(size_t talentCount) {
+        if (talentCount > MAX_SOLVER_TALENTS)
+            throw std::logic_error("Number of talents exceeds 256, need different indexing type instead of SIND256");
+        if (talentCount > 128) {
+            return 4;
+        }
+        if (talentCount > 64) {
+            return 2;
+        }
+        return 1;
+    }
+
+    /*
+    Creates the bit mask representation of a sorted DAG, unlockedMasks are created for 0 up to talentPointsLimit talent points spent.
+    */
+    template<typename IndexType>
+    BasicTreeDAGMasks<IndexType> createTreeDAGMasks(const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit) {
+        if (sortedTreeDAG.sortedTalents.size() > 64 * SkillsetIndexTraits<IndexType>::words)
+            throw std::logic_error("Number of talents exceeds the width of the skillset index type");
+        BasicTreeDAGMasks<IndexType> masks;
+        masks.talentCount = static_cast<int>(sortedTreeDAG.sortedTalents.size());
+        for (auto& root : sortedTreeDAG.rootIndices) {
+            setTalent(masks.rootMask, root);
+        }
+        const FlatTreeDAG& flatTreeDAG = sortedTreeDAG.flatTreeDAG;
+        masks.childMasks.resize(masks.talentCount, IndexType());
+        for (int i = 0; i < masks.talentCount; i++) {
+            for (int j = flatTreeDAG.childOffsets[i]; j < flatTreeDAG.childOffsets[i + 1]; j++) {
+                setTalent(masks.childMasks[i], flatTreeDAG.childIndices[j]);
+            }
+        }
+        masks.unlockedMasks.resize(talentPointsLimit > 0 ? talentPointsLimit + 1 : 1, IndexType());
+        for (int s = 0; s < static_cast<int>(masks.unlockedMasks.size()); s++) {
+            for (int i = 0; i < masks.talentCount; i++) {
+                if (flatTreeDAG.pointsRequired[i] <= s) {
+                    setTalent(masks.unlockedMasks[s], i);
+                }
+            }
+        }
+        return masks;
+    }
+
+    /*
+    Creates the first frame of the frontier kernels, only root nodes with points required == 0 are valid starting points
+    (prevents from starting at root nodes that might come later in the tree, e.g. druid wild charge).
+    */
+    template<typename IndexType>
+    BasicFrontierFrame<IndexType> createRootFrontierFrame(const BasicTreeDAGMasks<IndexType>& masks) {
+        BasicFrontierFrame<IndexType> frame;
+        frame.possibleTalents = masks.rootMask;
+        frame.candidates = masks.rootMask & masks.unlockedMasks[0];
+        return frame;
+    }
+
+    /*
+    Count only version of the tree solver that returns the exact number of builds for every amount of talent points from 1 up to N
+    without creating a single combination. Uses the same topologically sorted DAG as the other solvers but runs a dynamic program
+    over it instead of walking every path (see countCombinationsDP).
+    */
+    void countConfigurationsCountOnly(
+        TalentTree tree,
+        int talentPointsLimit,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered) {
+
+        inProgress = true;
+        //counting never enumerates builds, so the safety guard can't trigger
+        safetyGuardTriggered = false;
+        std::shared_ptr<TalentTree> processedTree = std::make_shared<TalentTree>(parseTree(createTreeStringRepresentation(tree)));
+        tree.unspentTalentPoints = talentPointsLimit;
+        //expand notes in tree
+        expandTreeTalents(*processedTree);
+
+        TreeDAGInfo sortedTreeDAG = createSortedMinimalDAG(*processedTree);
+        sortedTreeDAG.indexWords = getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size());
+        setSafetyGuard(sortedTreeDAG);
+        sortedTreeDAG.processedTree = processedTree;
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        if (!countCombinationsDP(sortedTreeDAG, talentPointsLimit, sortedTreeDAG.combinationCounts, sortedTreeDAG.weightedCombinationCounts)) {
+            //count again with exact arithmetic, the fixed width counts saturate
+            countCombinationsDP(sortedTreeDAG, talentPointsLimit, sortedTreeDAG.exactCombinationCounts, sortedTreeDAG.exactWeightedCombinationCounts);
+            for (size_t i = 0; i < sortedTreeDAG.exactCombinationCounts.size(); i++) {
+                sortedTreeDAG.combinationCounts[i] = sortedTreeDAG.exactCombinationCounts[i].toUInt64();
+                sortedTreeDAG.weightedCombinationCounts[i] = sortedTreeDAG.exactWeightedCombinationCounts[i].toUInt64();
+            }
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> ms_double = t2 - t1;
+        //no combinations are stored but keep the per talent point layout the other solvers use
+        sortedTreeDAG.allCombinations.resize(talentPointsLimit);
+        for (auto& count : sortedTreeDAG.combinationCounts) {
+            sortedTreeDAG.allCombinationsSum = count > SIZE_MAX - sortedTreeDAG.allCombinationsSum ? SIZE_MAX : sortedTreeDAG.allCombinationsSum + count;
+        }
+        sortedTreeDAG.elapsedTime = ms_double.count() / 1000.0;
+        inProgress = false;
+
+        //collect all switch talent choices
+        for (auto& indexTalentPair : tree.orderedTalents) {
+            if (indexTalentPair.second->type == Engine::TalentType::SWITCH) {
+                sortedTreeDAG.switchTalentChoices.push_back({ indexTalentPair.first, 1 });
+            }
+        }
+
+        treeDAGInfo = std::make_shared<TreeDAGInfo>(sortedTreeDAG);
+    }
+
+    /*
+    Arithmetic of the count only solvers, CombinationCount sets overflow instead of silently wrapping around and BigCount is exact.
+    */
+    static inline void addCount(CombinationCount& target, CombinationCount value, bool& overflow) {
+        target += value;
+        overflow |= target < value;
+    }
+    static inline void addCount(BigCount& target, const BigCount& value, bool&) {
+        target += value;
+    }
+    static inline CombinationCount multiplyCount(CombinationCount left, CombinationCount right, bool& overflow) {
+        //both factors below 2^32 can't overflow, so the division is only needed for large counts
+        if (((left | right) >> 32) != 0 && right != 0 && left > UINT64_MAX / right) {
+            overflow = true;
+        }
+        return left * right;
+    }
+    static inline BigCount multiplyCount(const BigCount& left, const BigCount& right, bool&) {
+        return left * right;
+    }
+    static inline bool isZeroCount(CombinationCount count) {
+        return count == 0;
+    }
+    static inline bool isZeroCount(const BigCount& count) {
+        return count.isZero();
+    }
+
+    template<typename IndexType, typename Count>
+    static void countCombinationsDPImpl(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<Count>& combinationCounts,
+        std::vector<Count>& weightedCombinationCounts,
+        bool& overflow)
+    {
+        BasicTreeDAGMasks<IndexType> masks = createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPointsLimit);
+        size_t talentCount = static_cast<size_t>(masks.talentCount);
+
+        //counts are indexed by talent points spent (0 to talentPointsLimit), first is unweighted, second is switch weighted
+        using StateCounts = std::vector<std::pair<Count, Count>>;
+        std::unordered_map<IndexType, StateCounts, SkillsetIndexHash> states;
+        states[masks.rootMask] = StateCounts(talentPointsLimit + 1, { 0, 0 });
+        states[masks.rootMask][0] = { 1, 1 };
+
+        for (size_t i = 0; i < talentCount; i++) {
+            IndexType talentBit = {};
+            setTalent(talentBit, static_cast<int>(i));
+            int pointsRequired = sortedTreeDAG.flatTreeDAG.pointsRequired[i];
+            Count weight = static_cast<CombinationCount>(sortedTreeDAG.flatTreeDAG.weights[i]);
+            std::unordered_map<IndexType, StateCounts, SkillsetIndexHash> nextStates;
+            nextStates.reserve(2 * states.size());
+            for (auto& maskCountsPair : states) {
+                const StateCounts& counts = maskCountsPair.second;
+                //skip talent, it cannot be reached again since paths only move forward in the sorted order
+                StateCounts& skipCounts = nextStates[maskCountsPair.first & ~talentBit];
+                if (skipCounts.size() == 0) {
+                    skipCounts.resize(talentPointsLimit + 1, { 0, 0 });
                 }
-                else {
-                    m->parents.clear();
+                for (int s = 0; s <= talentPointsLimit; s++) {
+                    addCount(skipCounts[s].first, counts[s].first, overflow);
+                    addCount(skipCounts[s].second, counts[s].second, overflow);
                 }
-                //if m has no other incoming edges then
-                if (m->parents.size() == 0) {
-                    //insert m into S
-                    tree.talentRoots.push_back(m);
-                    std::sort(tree.talentRoots.begin(), tree.talentRoots.end(), [](Talent_s a, Talent_s b) {
-                        return a->pointsRequired < b->pointsRequired;
-                        });
+                //take talent if it is reachable and its point requirement is fulfilled
+                if (!hasTalents(maskCountsPair.first & talentBit)) {
+                    continue;
                 }
-            }
-        }
-        for (int i = 0; i < info.sortedTalents.size(); i++) {
-            for (int j = 0; j < rootIndices.size(); j++) {
-                if (info.sortedTalents[i]->index == rootIndices[j]) {
-                    info.rootIndices.push_back(i);
-                    break;
+                StateCounts* takeCounts = nullptr;
+                for (int s = pointsRequired; s < talentPointsLimit; s++) {
+                    if (isZeroCount(counts[s].first)) {
+                        continue;
+                    }
+                    if (takeCounts == nullptr) {
+                        takeCounts = &nextStates[(maskCountsPair.first | masks.childMasks[i]) & ~talentBit];
+                        if (takeCounts->size() == 0) {
+                            takeCounts->resize(talentPointsLimit + 1, { 0, 0 });
+                        }
+                    }
+                    addCount((*takeCounts)[s + 1].first, counts[s].first, overflow);
+                    addCount((*takeCounts)[s + 1].second, multiplyCount(counts[s].second, weight, overflow), overflow);
                 }
             }
+            states = std::move(nextStates);
+            if (overflow) {
+                return;
+            }
         }
 
-        //convert sorted talents to minimalTreeDAG representation (raw talents -> integer index vectors)
-        for (auto& talent : info.sortedTalents) {
-            std::vector<int> child_indices(talent->children.size() + 1);
-            child_indices[0] = talent->type == TalentType::SWITCH ? 2 : 1;
-            for (int i = 0; i < talent->children.size(); i++) {
-                size_t pos = static_cast<size_t>(std::distance(info.sortedTalents.begin(), std::find(info.sortedTalents.begin(), info.sortedTalents.end(), talent->children[i])));
-                if (pos >= info.sortedTalents.size()) {
-                    throw std::logic_error("child does not appear in info.sortedTalents");
-                }
-                child_indices[i + 1] = static_cast<int>(pos);
+        for (auto& maskCountsPair : states) {
+            for (int s = 1; s <= talentPointsLimit; s++) {
+                addCount(combinationCounts[s - 1], maskCountsPair.second[s].first, overflow);
+                addCount(weightedCombinationCounts[s - 1], maskCountsPair.second[s].second, overflow);
             }
-            info.minimalTreeDAG.push_back(child_indices);
         }
+    }
 
-        return info;
+    /*
+    Dynamic program over the topologically sorted DAG that counts all valid paths without visiting them. Talents are decided in sorted
+    order (take or skip) which is exactly the order in which visitTalent* builds its paths. A state is the set of not yet decided talents
+    that are reachable (i.e. roots or children of a taken talent) and the number of talent points spent so far, so every valid
+    build is counted exactly once. Since children are always in the next few rows the number of distinct reachable sets stays small.
+    Counts in CombinationCount stop at the first overflow and return false, wide trees then have to be counted again with BigCount
+    which gives the exact counts at a fraction of the speed (see countConfigurationsCountOnly).
+    */
+    template<typename Count>
+    static bool countCombinationsDPCounts(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<Count>& combinationCounts,
+        std::vector<Count>& weightedCombinationCounts)
+    {
+        combinationCounts.assign(talentPointsLimit > 0 ? talentPointsLimit : 0, 0);
+        weightedCombinationCounts.assign(talentPointsLimit > 0 ? talentPointsLimit : 0, 0);
+        if (talentPointsLimit <= 0) {
+            return true;
+        }
+        bool overflow = false;
+        dispatchSkillsetIndexType(getSkillsetIndexWords(sortedTreeDAG.sortedTalents.size()), [&](auto indexTag) {
+            countCombinationsDPImpl<decltype(indexTag), Count>(sortedTreeDAG, talentPointsLimit, combinationCounts, weightedCombinationCounts, overflow);
+        });
+        return !overflow;
+    }
+
+    bool countCombinationsDP(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<CombinationCount>& combinationCounts,
+        std::vector<CombinationCount>& weightedCombinationCounts)
+    {
+        return countCombinationsDPCounts(sortedTreeDAG, talentPointsLimit, combinationCounts, weightedCombinationCounts);
+    }
+
+    void countCombinationsDP(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<BigCount>& combinationCounts,
+        std::vector<BigCount>& weightedCombinationCounts)
+    {
+        countCombinationsDPCounts(sortedTreeDAG, talentPointsLimit, combinationCounts, weightedCombinationCounts);
     }
 
-    TreeDAGInfoLegacy createSortedMinimalDAGLegacy(TalentTree tree) {
+
+    /*
+    Creates a minimal representation of the TalentTree object as a vector of integer vectors, where each vector has informations about a talent such as switch multiplier
+    and child nodes. Wow talent trees are essentially DAGs and can therefore be topologically sorted. TreeDAGInfo contains the minimal tree representation,
+    a vector of raw Talents which correspond to the indices in the min. tree rep. and indices of root talents.
+    */
+    TreeDAGInfo createSortedMinimalDAG(TalentTree tree) {
         //Note: Guarantees that the tree is sorted from left to right first, top to bottom second with each layer of the tree guaranteed to have a lower index than
         //the following layer. This makes it possible to implement min. talent points required for a layer to unlock, checked while iterating in visitTalent, while keeping
         //the algorithm the same and improving speed.
         //note: EVEN THOUGH TREE IS PASSED BY COPY ALL PARENTS WILL BE DELETED FROM TALENTS!
-        TreeDAGInfoLegacy info;
+        TreeDAGInfo info;
         std::vector<int> rootIndices;
         for (int i = 0; i < tree.talentRoots.size(); i++) {
             rootIndices.push_back(tree.talentRoots[i]->index);
@@ -833,15 +1988,31 @@ namespace Engine {
             }
             info.minimalTreeDAG.push_back(child_indices);
         }
+        info.flatTreeDAG = createFlatTreeDAG(info);
 
         return info;
     }
 
     /*
-    Helper function to set a talent as selected (simple bit flip function)
+    Converts minimalTreeDAG and the talent properties of sortedTalents into the contiguous arrays of FlatTreeDAG.
     */
-    inline void setTalent(SIND& talent, int index) {
-        talent |= 1ULL << index;
+    FlatTreeDAG createFlatTreeDAG(const TreeDAGInfo& sortedTreeDAG) {
+        FlatTreeDAG flatTreeDAG;
+        size_t talentCount = sortedTreeDAG.sortedTalents.size();
+        flatTreeDAG.childOffsets.reserve(talentCount + 1);
+        flatTreeDAG.pointsRequired.reserve(talentCount);
+        flatTreeDAG.weights.reserve(talentCount);
+        flatTreeDAG.types.reserve(talentCount);
+        flatTreeDAG.childOffsets.push_back(0);
+        for (size_t i = 0; i < talentCount; i++) {
+            const std::vector<int>& talentRow = sortedTreeDAG.minimalTreeDAG[i];
+            flatTreeDAG.childIndices.insert(flatTreeDAG.childIndices.end(), talentRow.begin() + 1, talentRow.end());
+            flatTreeDAG.childOffsets.push_back(static_cast<int>(flatTreeDAG.childIndices.size()));
+            flatTreeDAG.pointsRequired.push_back(sortedTreeDAG.sortedTalents[i]->pointsRequired);
+            flatTreeDAG.weights.push_back(talentRow[0]);
+            flatTreeDAG.types.push_back(sortedTreeDAG.sortedTalents[i]->type);
+        }
+        return flatTreeDAG;
     }
 
     /*
@@ -868,23 +2039,23 @@ namespace Engine {
         return getTalentString(tree);
     }
 
-    void insertIntoVector(std::vector<std::pair<int, int>>& v, std::pair<int, int>& t) {
-        std::vector<std::pair<int, int>>::iterator i = std::lower_bound(v.begin(), v.end(), t);
-        if (i == v.end() || t < *i)
-            v.insert(i, t);
-    }
-
     /*
-    Filters the skillsets that are created by the tree solver with the given filter
+    Creates the include/exclude/or/one filter masks of a filter skillset for a solved tree
     */
-    void filterSolvedSkillsets(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter) {
-        treeDAG->filteredCombinations.clear();
+    template<typename IndexType>
+    BasicSkillsetFilterMasks<IndexType> createSkillsetFilterMasks(const TalentTree& tree, const TreeDAGInfo& treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        if (treeDAG.sortedTalents.size() > 64 * SkillsetIndexTraits<IndexType>::words)
+            throw std::logic_error("Number of talents exceeds the width of the skillset index type");
+        BasicSkillsetFilterMasks<IndexType> masks;
+        if (!filter) {
+            return masks;
+        }
         //skillset has compactTalentIndex information
-        //treeDAG->sortedTalents containts index->expandedTalentIndex mapping
+        //treeDAG.sortedTalents containts index->expandedTalentIndex mapping
         //therefore we need compactTalentIndex->expandedTalentIndex mapping and reverse the index->expandedTalentIndex
         std::map<int, int> expandedToPosIndexMap;
-        for (int i = 0; i < treeDAG->sortedTalents.size(); i++) {
-            expandedToPosIndexMap[treeDAG->sortedTalents[i]->index] = i;
+        for (int i = 0; i < treeDAG.sortedTalents.size(); i++) {
+            expandedToPosIndexMap[treeDAG.sortedTalents[i]->index] = i;
         }
         std::map<int, std::vector<int>> compactToExpandedIndexMap;
         for (auto& talent : tree.orderedTalents) {
@@ -902,14 +2073,10 @@ namespace Engine {
             }
             compactToExpandedIndexMap[talent.second->index] = indices;
         }
-        SIND includeFilter = 0; //this talent has to have exactly the specified amount of talent points
-        SIND excludeFilter = 0; //this talent must not have any talent points assigned
-        SIND orFilter = 0; //this group of talents has to have at least one talent point assigned
-        std::vector<std::pair<SIND, SIND>> oneFilter; //exactly one talent in this group has to be maxed while all others must not have any points
         for (auto& indexFilterPair : filter->assignedSkillPoints) {
             if (indexFilterPair.second == -3) {
-                SIND inc = 0;
-                SIND exc = 0;
+                IndexType inc = {};
+                IndexType exc = {};
                 for (auto& iFP : filter->assignedSkillPoints) {
                     if (iFP.second != -3) {
                         continue;
@@ -929,68 +2096,410 @@ namespace Engine {
                         }
                     }
                 }
-                oneFilter.push_back({ inc, exc });
+                masks.oneFilter.push_back({ inc, exc });
             }
             if (indexFilterPair.second == -2) {
                 for (int i = 0; i < compactToExpandedIndexMap[indexFilterPair.first].size(); i++) {
                     int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][i];
                     int pos = expandedToPosIndexMap[expandedTalentIndex];
-                    setTalent(orFilter, pos);
+                    setTalent(masks.orFilter, pos);
                 }
             }
             else if (indexFilterPair.second == -1) {
                 int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][0];
                 int pos = expandedToPosIndexMap[expandedTalentIndex];
-                setTalent(excludeFilter, pos);
+                setTalent(masks.excludeFilter, pos);
             }
             else if (indexFilterPair.second > 0) {
                 for (int i = 0; i < indexFilterPair.second; i++) {
                     int expandedTalentIndex = compactToExpandedIndexMap[indexFilterPair.first][i];
                     int pos = expandedToPosIndexMap[expandedTalentIndex];
-                    setTalent(includeFilter, pos);
+                    setTalent(masks.includeFilter, pos);
+                }
+            }
+        }
+
+        //parents always have a lower index than their children, so the ancestors of a talent are final before they are propagated
+        if (hasTalents(masks.includeFilter) || hasTalents(masks.orFilter) || masks.oneFilter.size() > 0) {
+            const FlatTreeDAG& flatTreeDAG = treeDAG.flatTreeDAG;
+            int talentCount = static_cast<int>(treeDAG.sortedTalents.size());
+            masks.ancestorMasks.resize(talentCount, IndexType());
+            for (int i = 0; i < talentCount; i++) {
+                IndexType talent = {};
+                setTalent(talent, i);
+                if (hasTalents(talent & masks.excludeFilter)) {
+                    continue;
                 }
+                masks.ancestorMasks[i] |= talent;
+                for (int j = flatTreeDAG.childOffsets[i]; j < flatTreeDAG.childOffsets[i + 1]; j++) {
+                    masks.ancestorMasks[flatTreeDAG.childIndices[j]] |= masks.ancestorMasks[i];
+                }
+                if (hasTalents(talent & masks.orFilter)) {
+                    masks.orAncestorMask |= masks.ancestorMasks[i];
+                }
+            }
+        }
+
+        return masks;
+    }
+
+    /*
+    Instruction set of the batch filter kernel (filterSkillsetIndices), detected once at runtime.
+    */
+    enum class FilterKernelType {
+        Scalar, SSE42, AVX2
+    };
+
+    static FilterKernelType detectFilterKernelType() {
+#if defined(TTM_X86_SIMD) && defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+        int maxLeaf = cpuInfo[0];
+        __cpuid(cpuInfo, 1);
+        bool sse42 = (cpuInfo[2] & (1 << 20)) != 0;
+        bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(cpuInfo, 7, 0);
+            avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+        }
+        return avx2 ? FilterKernelType::AVX2 : (sse42 ? FilterKernelType::SSE42 : FilterKernelType::Scalar);
+#elif defined(TTM_X86_SIMD)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return FilterKernelType::AVX2;
+        }
+        return __builtin_cpu_supports("sse4.2") ? FilterKernelType::SSE42 : FilterKernelType::Scalar;
+#else
+        return FilterKernelType::Scalar;
+#endif
+    }
+
+    /*
+    Branch free scalar variant of the batch filter kernel, survivors are always written and the output position only advances if the
+    skillset passes the filter (works for all skillset index widths).
+    */
+    template<typename IndexType>
+    static size_t filterSkillsetIndicesScalar(const SIND* combinations, size_t count, const BasicSkillsetFilterMasks<IndexType>& filter, SIND* filtered) {
+        const size_t indexWords = SkillsetIndexTraits<IndexType>::words;
+        bool checkOr = hasTalents(filter.orFilter);
+        size_t survivors = 0;
+        for (size_t i = 0; i < count; i++) {
+            IndexType skillset = loadSkillsetIndex<IndexType>(&combinations[i * indexWords]);
+            bool valid = !hasTalents(skillset & filter.excludeFilter)
+                & !hasTalents((~skillset) & filter.includeFilter)
+                & (!checkOr | hasTalents(skillset & filter.orFilter));
+            size_t matches = 0;
+            for (auto& filterPair : filter.oneFilter) {
+                matches += !hasTalents((~skillset) & filterPair.first) & !hasTalents(skillset & filterPair.second);
+            }
+            valid &= filter.oneFilter.size() == 0 || matches == 1;
+            std::memcpy(&filtered[survivors * indexWords], &skillset, sizeof(IndexType));
+            survivors += valid ? 1 : 0;
+        }
+        return survivors;
+    }
+
+#if defined(TTM_X86_SIMD)
+    /*
+    Returns the survivor bits of 4 skillsets (bit i set if lane i passes the filter).
+    */
+    TTM_TARGET_AVX2
+    static inline int checkSkillsetLanesAVX2(__m256i skillsets, __m256i includeFilter, __m256i excludeFilter, __m256i orFilter, bool checkOr, const SkillsetFilterMasks& filter) {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i allOnes = _mm256_set1_epi64x(-1);
+        //lanes are all ones if the skillset is invalid
+        __m256i invalid = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(skillsets, excludeFilter), zero), allOnes);
+        invalid = _mm256_or_si256(invalid, _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(skillsets, includeFilter), includeFilter), allOnes));
+        if (checkOr) {
+            invalid = _mm256_or_si256(invalid, _mm256_cmpeq_epi64(_mm256_and_si256(skillsets, orFilter), zero));
+        }
+        if (filter.oneFilter.size() > 0) {
+            __m256i matches = zero;
+            for (auto& filterPair : filter.oneFilter) {
+                __m256i first = _mm256_set1_epi64x(static_cast<long long>(filterPair.first));
+                __m256i second = _mm256_set1_epi64x(static_cast<long long>(filterPair.second));
+                __m256i match = _mm256_and_si256(
+                    _mm256_cmpeq_epi64(_mm256_and_si256(skillsets, first), first),
+                    _mm256_cmpeq_epi64(_mm256_and_si256(skillsets, second), zero));
+                //compare results are -1 for matching lanes
+                matches = _mm256_sub_epi64(matches, match);
+            }
+            invalid = _mm256_or_si256(invalid, _mm256_xor_si256(_mm256_cmpeq_epi64(matches, _mm256_set1_epi64x(1)), allOnes));
+        }
+        return ~_mm256_movemask_pd(_mm256_castsi256_pd(invalid)) & 0xF;
+    }
+
+    /*
+    AVX2 batch filter kernel, checks 8 skillsets (2 x 4 lanes) per iteration and writes the survivors in order (AVX2 has no
+    compress store so every lane is stored and the output position is advanced by its survivor bit).
+    */
+    TTM_TARGET_AVX2
+    static size_t filterSkillsetIndicesAVX2(const SIND* combinations, size_t count, const SkillsetFilterMasks& filter, SIND* filtered) {
+        const __m256i includeFilter = _mm256_set1_epi64x(static_cast<long long>(filter.includeFilter));
+        const __m256i excludeFilter = _mm256_set1_epi64x(static_cast<long long>(filter.excludeFilter));
+        const __m256i orFilter = _mm256_set1_epi64x(static_cast<long long>(filter.orFilter));
+        const bool checkOr = filter.orFilter != 0;
+        size_t survivors = 0;
+        size_t i = 0;
+        alignas(32) SIND lanes[8];
+        for (; i + 8 <= count; i += 8) {
+            __m256i skillsetsLow = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&combinations[i]));
+            __m256i skillsetsHigh = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&combinations[i + 4]));
+            int survivorMask = checkSkillsetLanesAVX2(skillsetsLow, includeFilter, excludeFilter, orFilter, checkOr, filter)
+                | (checkSkillsetLanesAVX2(skillsetsHigh, includeFilter, excludeFilter, orFilter, checkOr, filter) << 4);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), skillsetsLow);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 4), skillsetsHigh);
+            for (int lane = 0; lane < 8; lane++) {
+                filtered[survivors] = lanes[lane];
+                survivors += (survivorMask >> lane) & 1;
+            }
+        }
+        return survivors + filterSkillsetIndicesScalar<SIND>(&combinations[i], count - i, filter, &filtered[survivors]);
+    }
+
+    TTM_TARGET_SSE42
+    static inline int checkSkillsetLanesSSE42(__m128i skillsets, __m128i includeFilter, __m128i excludeFilter, __m128i orFilter, bool checkOr, const SkillsetFilterMasks& filter) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i allOnes = _mm_set1_epi64x(-1);
+        __m128i invalid = _mm_xor_si128(_mm_cmpeq_epi64(_mm_and_si128(skillsets, excludeFilter), zero), allOnes);
+        invalid = _mm_or_si128(invalid, _mm_xor_si128(_mm_cmpeq_epi64(_mm_and_si128(skillsets, includeFilter), includeFilter), allOnes));
+        if (checkOr) {
+            invalid = _mm_or_si128(invalid, _mm_cmpeq_epi64(_mm_and_si128(skillsets, orFilter), zero));
+        }
+        if (filter.oneFilter.size() > 0) {
+            __m128i matches = zero;
+            for (auto& filterPair : filter.oneFilter) {
+                __m128i first = _mm_set1_epi64x(static_cast<long long>(filterPair.first));
+                __m128i second = _mm_set1_epi64x(static_cast<long long>(filterPair.second));
+                __m128i match = _mm_and_si128(
+                    _mm_cmpeq_epi64(_mm_and_si128(skillsets, first), first),
+                    _mm_cmpeq_epi64(_mm_and_si128(skillsets, second), zero));
+                matches = _mm_sub_epi64(matches, match);
+            }
+            invalid = _mm_or_si128(invalid, _mm_xor_si128(_mm_cmpeq_epi64(matches, _mm_set1_epi64x(1)), allOnes));
+        }
+        return ~_mm_movemask_pd(_mm_castsi128_pd(invalid)) & 0x3;
+    }
+
+    /*
+    SSE4.2 batch filter kernel (2 lanes per vector, 4 skillsets per iteration), same logic as filterSkillsetIndicesAVX2.
+    */
+    TTM_TARGET_SSE42
+    static size_t filterSkillsetIndicesSSE42(const SIND* combinations, size_t count, const SkillsetFilterMasks& filter, SIND* filtered) {
+        const __m128i includeFilter = _mm_set1_epi64x(static_cast<long long>(filter.includeFilter));
+        const __m128i excludeFilter = _mm_set1_epi64x(static_cast<long long>(filter.excludeFilter));
+        const __m128i orFilter = _mm_set1_epi64x(static_cast<long long>(filter.orFilter));
+        const bool checkOr = filter.orFilter != 0;
+        size_t survivors = 0;
+        size_t i = 0;
+        alignas(16) SIND lanes[4];
+        for (; i + 4 <= count; i += 4) {
+            __m128i skillsetsLow = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&combinations[i]));
+            __m128i skillsetsHigh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&combinations[i + 2]));
+            int survivorMask = checkSkillsetLanesSSE42(skillsetsLow, includeFilter, excludeFilter, orFilter, checkOr, filter)
+                | (checkSkillsetLanesSSE42(skillsetsHigh, includeFilter, excludeFilter, orFilter, checkOr, filter) << 2);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), skillsetsLow);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 2), skillsetsHigh);
+            for (int lane = 0; lane < 4; lane++) {
+                filtered[survivors] = lanes[lane];
+                survivors += (survivorMask >> lane) & 1;
+            }
+        }
+        return survivors + filterSkillsetIndicesScalar<SIND>(&combinations[i], count - i, filter, &filtered[survivors]);
+    }
+#endif
+
+    /*
+    Batch filter kernel for 64 bit skillset indices, writes all count combinations that pass the filter to filtered (in order) and
+    returns their number. filtered needs room for count combinations and may be the same array as combinations (in place filtering).
+    Uses AVX2 or SSE4.2 if the CPU supports it and a scalar fallback otherwise.
+    */
+    size_t filterSkillsetIndices(const SIND* combinations, size_t count, const SkillsetFilterMasks& filter, SIND* filtered) {
+        static const FilterKernelType kernelType = detectFilterKernelType();
+#if defined(TTM_X86_SIMD)
+        switch (kernelType) {
+        case FilterKernelType::AVX2: return filterSkillsetIndicesAVX2(combinations, count, filter, filtered);
+        case FilterKernelType::SSE42: return filterSkillsetIndicesSSE42(combinations, count, filter, filtered);
+        default: break;
+        }
+#endif
+        return filterSkillsetIndicesScalar<SIND>(combinations, count, filter, filtered);
+    }
+
+    template<typename IndexType>
+    static size_t filterSkillsetIndicesImpl(const SIND* combinations, size_t count, const BasicSkillsetFilterMasks<IndexType>& filter, SIND* filtered) {
+        return filterSkillsetIndicesScalar<IndexType>(combinations, count, filter, filtered);
+    }
+
+    template<>
+    size_t filterSkillsetIndicesImpl<SIND>(const SIND* combinations, size_t count, const SkillsetFilterMasks& filter, SIND* filtered) {
+        return filterSkillsetIndices(combinations, count, filter, filtered);
+    }
+
+    bool CombinationFilterBits::isEmpty() const {
+        return includeBits.size() == 0 && excludeBits.size() == 0 && orBits.size() == 0 && oneBits.size() == 0;
+    }
+
+    bool CombinationFilterBits::operator==(const CombinationFilterBits& other) const {
+        return includeBits == other.includeBits && excludeBits == other.excludeBits && orBits == other.orBits && oneBits == other.oneBits;
+    }
+
+    /*
+    Returns true if every combination that passes this filter also passes other (i.e. this filter is at least as strict),
+    bit lists are sorted so subset checks are std::includes. Only sufficient conditions are checked, a false negative just
+    means the incremental filtering falls back to a larger working set.
+    */
+    bool CombinationFilterBits::isRefinementOf(const CombinationFilterBits& other) const {
+        if (!std::includes(includeBits.begin(), includeBits.end(), other.includeBits.begin(), other.includeBits.end())) {
+            return false;
+        }
+        if (!std::includes(excludeBits.begin(), excludeBits.end(), other.excludeBits.begin(), other.excludeBits.end())) {
+            return false;
+        }
+        if (other.orBits.size() > 0) {
+            //either the or group got smaller or one of its talents is included now
+            bool orRefined = orBits.size() > 0 && std::includes(other.orBits.begin(), other.orBits.end(), orBits.begin(), orBits.end());
+            for (int bit : includeBits) {
+                orRefined |= std::binary_search(other.orBits.begin(), other.orBits.end(), bit);
+            }
+            if (!orRefined) {
+                return false;
+            }
+        }
+        return other.oneBits.size() == 0 || oneBits == other.oneBits;
+    }
+
+    bool CombinationFilterBits::matches(const SIND* skillsetIndex) const {
+        for (int bit : includeBits) {
+            if (!isTalentSelected(skillsetIndex, bit)) {
+                return false;
+            }
+        }
+        for (int bit : excludeBits) {
+            if (isTalentSelected(skillsetIndex, bit)) {
+                return false;
             }
         }
+        if (orBits.size() > 0 && std::none_of(orBits.begin(), orBits.end(), [&](int bit) { return isTalentSelected(skillsetIndex, bit); })) {
+            return false;
+        }
+        if (oneBits.size() == 0) {
+            return true;
+        }
+        size_t matchingGroups = 0;
+        for (auto& groupBits : oneBits) {
+            bool groupMatches = std::all_of(groupBits.first.begin(), groupBits.first.end(), [&](int bit) { return isTalentSelected(skillsetIndex, bit); })
+                && std::none_of(groupBits.second.begin(), groupBits.second.end(), [&](int bit) { return isTalentSelected(skillsetIndex, bit); });
+            matchingGroups += groupMatches ? 1 : 0;
+        }
+        return matchingGroups == 1;
+    }
+
+    static size_t getCombinationsMemoryUsage(const vec2d<SIND>& combinations) {
+        size_t memoryUsage = 0;
+        for (auto& bucket : combinations) {
+            memoryUsage += bucket.size() * sizeof(SIND);
+        }
+        return memoryUsage;
+    }
+
+    template<typename IndexType>
+    static void filterSolvedSkillsetsImpl(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        BasicSkillsetFilterMasks<IndexType> filterMasks = createSkillsetFilterMasks<IndexType>(tree, *treeDAG, filter);
+        CombinationFilterBits filterBits = createCombinationFilterBits(tree, *treeDAG, filter);
 
         vec2d<SIND> filteredCombinations;
-        if (includeFilter == 0 && excludeFilter == 0 && orFilter == 0 && oneFilter.size() == 0) {
+        if (filterBits.isEmpty()) {
             treeDAG->filteredCombinations = treeDAG->allCombinations;
+            treeDAG->hasCurrentFilter = false;
+            treeDAG->filterGenerations.clear();
             return;
         }
-        for (int i = 0; i < treeDAG->allCombinations.size(); i++) {
-            std::vector<SIND> combs;
-            combs.reserve(treeDAG->allCombinations[i].size());
-            for (int j = 0; j < treeDAG->allCombinations[i].size(); j++) {
-                SIND skillset = treeDAG->allCombinations[i][j];
-                if ((skillset & excludeFilter) == 0 && ((~skillset) & includeFilter) == 0 && (orFilter == 0 || (skillset & orFilter) > 0)) {
-                    if (oneFilter.size() == 0) {
-                        combs.push_back(skillset);
-                    }
-                    else {
-                        size_t matches = 0;
-                        for (auto& filterPair : oneFilter) {
-                            if (((~skillset) & filterPair.first) == 0 && (skillset & filterPair.second) == 0) {
-                                matches += 1;
-                            }
-                        }
-                        if (matches == 1) {
-                            combs.push_back(skillset);
-                        }
-                    }
+        std::vector<FilterGeneration>& generations = treeDAG->filterGenerations;
+        if (treeDAG->hasCurrentFilter && filterBits == treeDAG->currentFilter) {
+            return;
+        }
+        if (treeDAG->hasCurrentFilter && filterBits.isRefinementOf(treeDAG->currentFilter)) {
+            //stricter filter: the current result becomes the working set and stays available for a later relaxation
+            generations.push_back({ std::move(treeDAG->currentFilter), std::move(treeDAG->filteredCombinations) });
+            //the oldest generations are dropped first, they are the largest and the cheapest to filter again from allCombinations
+            size_t memoryBudget = getSolverMemoryBudget();
+            size_t memoryUsage = getCombinationsMemoryUsage(treeDAG->allCombinations);
+            for (auto& generation : generations) {
+                memoryUsage += getCombinationsMemoryUsage(generation.combinations);
+            }
+            while (generations.size() > 0 && (generations.size() > FILTER_GENERATION_LIMIT || memoryUsage > memoryBudget)) {
+                memoryUsage -= getCombinationsMemoryUsage(generations.front().combinations);
+                generations.erase(generations.begin());
+            }
+        }
+        else {
+            //relaxed (or unrelated) filter: drop generations until one is a superset of the new result
+            while (generations.size() > 0 && !filterBits.isRefinementOf(generations.back().filter)) {
+                generations.pop_back();
+            }
+            if (generations.size() > 0 && generations.back().filter == filterBits) {
+                treeDAG->currentFilter = std::move(generations.back().filter);
+                treeDAG->filteredCombinations = std::move(generations.back().combinations);
+                treeDAG->hasCurrentFilter = true;
+                generations.pop_back();
+                return;
+            }
+        }
+        treeDAG->currentFilter = filterBits;
+        treeDAG->hasCurrentFilter = true;
+
+        const size_t indexWords = SkillsetIndexTraits<IndexType>::words;
+        std::shared_ptr<const CombinationBitmapIndex> bitmapIndex = std::atomic_load(&treeDAG->bitmapIndex);
+        if (generations.size() == 0 && bitmapIndex) {
+            //bitmap index gives the surviving rows directly, only those have to be copied
+            std::vector<size_t> rows;
+            for (int i = 0; i < treeDAG->allCombinations.size(); i++) {
+                const std::vector<SIND>& combinations = treeDAG->allCombinations[i];
+                rows.clear();
+                bitmapIndex->getFilteredRows(i, filterBits, rows);
+                std::vector<SIND> combs(rows.size() * indexWords);
+                for (size_t r = 0; r < rows.size(); r++) {
+                    std::memcpy(&combs[r * indexWords], &combinations[rows[r] * indexWords], indexWords * sizeof(SIND));
                 }
+                filteredCombinations.push_back(std::move(combs));
             }
-            filteredCombinations.push_back(combs);
+            treeDAG->filteredCombinations = std::move(filteredCombinations);
+            return;
+        }
+        const vec2d<SIND>& workingSet = generations.size() > 0 ? generations.back().combinations : treeDAG->allCombinations;
+        for (int i = 0; i < workingSet.size(); i++) {
+            const std::vector<SIND>& combinations = workingSet[i];
+            std::vector<SIND> combs(combinations.size());
+            if (combinations.size() > 0) {
+                size_t survivors = filterSkillsetIndicesImpl<IndexType>(combinations.data(), combinations.size() / indexWords, filterMasks, combs.data());
+                combs.resize(survivors * indexWords);
+                combs.shrink_to_fit();
+            }
+            filteredCombinations.push_back(std::move(combs));
         }
 
         treeDAG->filteredCombinations = std::move(filteredCombinations);
     }
 
+    /*
+    Filters the skillsets that are created by the tree solver with the given filter. Stricter versions of the previous filter
+    only filter the previous result, relaxations go back to the latest earlier filter generation that is still a superset.
+    */
+    void filterSolvedSkillsets(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter) {
+        dispatchSkillsetIndexType(treeDAG->indexWords, [&](auto indexTag) {
+            filterSolvedSkillsetsImpl<decltype(indexTag)>(tree, treeDAG, filter);
+        });
+    }
+
     inline bool checkSkillsetFilter(
         const SIND skillset, 
         const SIND includeFilter,
         const SIND excludeFilter,
         const SIND orFilter,
-        const std::vector<std::pair<SIND, SIND>> oneFilter) {
+        const std::vector<std::pair<SIND, SIND>>& oneFilter) {
         if (includeFilter == 0 && excludeFilter == 0 && orFilter == 0 && oneFilter.size() == 0) {
             return true;
         }
@@ -1014,12 +2523,25 @@ namespace Engine {
     }
 
     /*
-    Creates a skillset with a given uint64 index
+    Creates a skillset with a given uint64 index, only valid for trees that fit into a single SIND (TreeDAGInfo::indexWords == 1)
     */
     std::shared_ptr<TalentSkillset> skillsetIndexToSkillset(
         const TalentTree& tree, 
         std::shared_ptr<TreeDAGInfo> treeDAG, 
         SIND skillsetIndex) 
+    {
+        if (treeDAG->indexWords != 1)
+            throw std::logic_error("Skillset index of a wide tree has to be passed as TreeDAGInfo::indexWords SINDs");
+        return skillsetIndexToSkillset(tree, treeDAG, &skillsetIndex);
+    }
+
+    /*
+    Creates a skillset with a given index that consists of TreeDAGInfo::indexWords SINDs (i.e. a combination of allCombinations/filteredCombinations)
+    */
+    std::shared_ptr<TalentSkillset> skillsetIndexToSkillset(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        const SIND* skillsetIndex)
     {
         std::map<int, int> expandedToCompactIndexMap;
         for (auto& talent : tree.orderedTalents) {
@@ -1041,7 +2563,7 @@ namespace Engine {
             skillset->assignedSkillPoints[talent.first] = 0;
         }
         for (int i = 0; i < treeDAG->sortedTalents.size(); i++) {
-            bool checkBit = (skillsetIndex) & (1ULL << i);
+            bool checkBit = isTalentSelected(skillsetIndex, i);
             if (checkBit) {
                 int compactIndex = expandedToCompactIndexMap[treeDAG->sortedTalents[i]->index];
                 skillset->talentPointsSpent += 1;
@@ -1061,10 +2583,189 @@ namespace Engine {
         return skillset;
     }
 
-    void setSafetyGuard(TreeDAGInfo& treeDAGInfo) {
+    /*
+    Reverse of skillsetIndexToSkillset: creates the skillset index (TreeDAGInfo::indexWords SINDs) of the points a skillset assigns.
+    The skillset doesn't have to be a valid build, points above the max points of a talent are clamped and preselected talents
+    are ignored since they are not part of the sorted DAG.
+    */
+    std::vector<SIND> skillsetToSkillsetIndex(
+        const TalentTree& tree,
+        const TreeDAGInfo& treeDAG,
+        std::shared_ptr<TalentSkillset> skillset)
+    {
+        std::vector<SIND> skillsetIndex(treeDAG.indexWords, 0);
+        if (!skillset) {
+            return skillsetIndex;
+        }
+        std::map<int, int> expandedToPosIndexMap;
+        for (int i = 0; i < treeDAG.sortedTalents.size(); i++) {
+            expandedToPosIndexMap[treeDAG.sortedTalents[i]->index] = i;
+        }
+        for (auto& indexPointsPair : skillset->assignedSkillPoints) {
+            auto talentIt = tree.orderedTalents.find(indexPointsPair.first);
+            if (talentIt == tree.orderedTalents.end() || indexPointsPair.second <= 0) {
+                continue;
+            }
+            const Talent_s& talent = talentIt->second;
+            int points = talent->type == TalentType::SWITCH ? 1 : std::min(indexPointsPair.second, talent->maxPoints);
+            for (int i = 0; i < points; i++) {
+                //same expanded indexing as skillsetIndexToSkillset
+                int expandedTalentIndex = i == 0 ? talent->index : (talent->index + 1) * tree.maxTalentPoints + (i - 1);
+                auto posIt = expandedToPosIndexMap.find(expandedTalentIndex);
+                if (posIt != expandedToPosIndexMap.end()) {
+                    skillsetIndex[posIt->second >> 6] |= 1ULL << (posIt->second & 63);
+                }
+            }
+        }
+        return skillsetIndex;
+    }
+
+    /*
+    Converts a skillset index that consists of indexWords SINDs (see TreeDAGInfo::indexWords) to its decimal representation
+    (identical to std::to_string for trees that fit into a single SIND).
+    */
+    std::string skillsetIndexToString(const SIND* skillsetIndex, int indexWords) {
+        if (indexWords == 1) {
+            return std::to_string(skillsetIndex[0]);
+        }
+        //long division by 10^9 on 32 bit limbs (most significant first)
+        std::vector<std::uint32_t> limbs;
+        for (int i = indexWords - 1; i >= 0; i--) {
+            limbs.push_back(static_cast<std::uint32_t>(skillsetIndex[i] >> 32));
+            limbs.push_back(static_cast<std::uint32_t>(skillsetIndex[i]));
+        }
+        std::vector<std::uint32_t> chunks;
+        bool isZero = false;
+        while (!isZero) {
+            std::uint64_t remainder = 0;
+            isZero = true;
+            for (auto& limb : limbs) {
+                std::uint64_t value = (remainder << 32) | limb;
+                limb = static_cast<std::uint32_t>(value / 1000000000);
+                remainder = value % 1000000000;
+                if (limb != 0) {
+                    isZero = false;
+                }
+            }
+            chunks.push_back(static_cast<std::uint32_t>(remainder));
+        }
+        std::string result = std::to_string(chunks.back());
+        for (int i = static_cast<int>(chunks.size()) - 2; i >= 0; i--) {
+            std::string chunk = std::to_string(chunks[i]);
+            result += std::string(9 - chunk.size(), '0') + chunk;
+        }
+        return result;
+    }
+
+    /*
+    Returns the number of combinations in a bucket of allCombinations/filteredCombinations.
+    */
+    size_t getCombinationCount(const TreeDAGInfo& treeDAG, const std::vector<SIND>& combinations) {
+        return combinations.size() / treeDAG.indexWords;
+    }
+
+    /*
+    Exact decimal total of allCombinationsSum, the counts of the count only solver can exceed 64 bit (see exactCombinationCounts).
+    */
+    std::string getCombinationsSumString(const TreeDAGInfo& treeDAG) {
+        if (treeDAG.combinationCounts.size() == 0) {
+            return std::to_string(treeDAG.allCombinationsSum);
+        }
+        BigCount sum;
+        for (size_t i = 0; i < treeDAG.combinationCounts.size(); i++) {
+            sum += i < treeDAG.exactCombinationCounts.size() ? treeDAG.exactCombinationCounts[i] : BigCount(treeDAG.combinationCounts[i]);
+        }
+        return sum.toString();
+    }
+
+    //0 means the budget is derived from the physical memory (see getSolverMemoryBudget)
+    static std::atomic<size_t> solverMemoryBudget = 0;
+
+    /*
+    Returns the total physical memory in bytes or 0 if it can't be determined. Reads MemTotal from /proc/meminfo on Linux and falls
+    back to sysconf on other POSIX systems.
+    */
+    size_t getPhysicalMemorySize() {
+#ifdef _WIN32
         MEMORYSTATUSEX status;
         status.dwLength = sizeof(status);
-        GlobalMemoryStatusEx(&status);
-        treeDAGInfo.safetyGuard = static_cast<size_t>((status.ullTotalPhys - RESERVED_MEMORY_LIMIT) * 0.5 * 0.125);
+        if (!GlobalMemoryStatusEx(&status)) {
+            return 0;
+        }
+        return static_cast<size_t>(status.ullTotalPhys);
+#else
+        std::ifstream meminfo("/proc/meminfo");
+        std::string key;
+        size_t value = 0;
+        std::string unit;
+        while (meminfo >> key >> value >> unit) {
+            if (key == "MemTotal:") {
+                return value * 1024;
+            }
+        }
+        long pages = sysconf(_SC_PHYS_PAGES);
+        long pageSize = sysconf(_SC_PAGE_SIZE);
+        if (pages <= 0 || pageSize <= 0) {
+            return 0;
+        }
+        return static_cast<size_t>(pages) * static_cast<size_t>(pageSize);
+#endif
+    }
+
+    /*
+    Sets the number of bytes solvers may use for combinations that are kept in memory, 0 restores the default.
+    */
+    void setSolverMemoryBudget(size_t memoryBudget) {
+        solverMemoryBudget = memoryBudget;
+    }
+
+    /*
+    Returns the memory budget for combinations in bytes, by default half of the physical memory that is left after RESERVED_MEMORY_LIMIT
+    (at least SOLVER_MIN_MEMORY_BUDGET).
+    */
+    size_t getSolverMemoryBudget() {
+        size_t memoryBudget = solverMemoryBudget;
+        if (memoryBudget > 0) {
+            return memoryBudget;
+        }
+        size_t physicalMemory = getPhysicalMemorySize();
+        if (physicalMemory > RESERVED_MEMORY_LIMIT) {
+            memoryBudget = static_cast<size_t>((physicalMemory - RESERVED_MEMORY_LIMIT) / 2);
+        }
+        return (std::max)(memoryBudget, SOLVER_MIN_MEMORY_BUDGET);
     }
+
+    void setSafetyGuard(TreeDAGInfo& treeDAGInfo) {
+        //wide trees need indexWords SINDs per combination
+        treeDAGInfo.safetyGuard = getSolverMemoryBudget() / (sizeof(SIND) * treeDAGInfo.indexWords);
+    }
+
+    //solver kernels are compiled for every skillset index width, the solvers pick one at runtime (see dispatchSkillsetIndexType)
+    template BasicTreeDAGMasks<SIND> createTreeDAGMasks<SIND>(const TreeDAGInfo&, int);
+    template BasicTreeDAGMasks<SIND128> createTreeDAGMasks<SIND128>(const TreeDAGInfo&, int);
+    template BasicTreeDAGMasks<SIND256> createTreeDAGMasks<SIND256>(const TreeDAGInfo&, int);
+    template BasicFrontierFrame<SIND> createRootFrontierFrame<SIND>(const BasicTreeDAGMasks<SIND>&);
+    template BasicFrontierFrame<SIND128> createRootFrontierFrame<SIND128>(const BasicTreeDAGMasks<SIND128>&);
+    template BasicFrontierFrame<SIND256> createRootFrontierFrame<SIND256>(const BasicTreeDAGMasks<SIND256>&);
+    template void visitTalentsFrontierSingle<SIND>(const BasicTreeDAGMasks<SIND>&, int, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierSingle<SIND128>(const BasicTreeDAGMasks<SIND128>&, int, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierSingle<SIND256>(const BasicTreeDAGMasks<SIND256>&, int, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierFiltered<SIND>(
+        const BasicTreeDAGMasks<SIND>&, int, const BasicSkillsetFilterMasks<SIND>&, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierFiltered<SIND128>(
+        const BasicTreeDAGMasks<SIND128>&, int, const BasicSkillsetFilterMasks<SIND128>&, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierFiltered<SIND256>(
+        const BasicTreeDAGMasks<SIND256>&, int, const BasicSkillsetFilterMasks<SIND256>&, std::vector<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierParallel<SIND>(const BasicTreeDAGMasks<SIND>&, int, vec2d<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierParallel<SIND128>(const BasicTreeDAGMasks<SIND128>&, int, vec2d<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierParallel<SIND256>(const BasicTreeDAGMasks<SIND256>&, int, vec2d<SIND>&, size_t&, size_t, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierStreaming<SIND>(
+        const BasicTreeDAGMasks<SIND>&, int, bool, const BasicSkillsetFilterMasks<SIND>*, CombinationSink&, size_t&, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierStreaming<SIND128>(
+        const BasicTreeDAGMasks<SIND128>&, int, bool, const BasicSkillsetFilterMasks<SIND128>*, CombinationSink&, size_t&, bool&, int, SolveHandle*);
+    template void visitTalentsFrontierStreaming<SIND256>(
+        const BasicTreeDAGMasks<SIND256>&, int, bool, const BasicSkillsetFilterMasks<SIND256>*, CombinationSink&, size_t&, bool&, int, SolveHandle*);
+    template BasicSkillsetFilterMasks<SIND> createSkillsetFilterMasks<SIND>(const TalentTree&, const TreeDAGInfo&, std::shared_ptr<TalentSkillset>);
+    template BasicSkillsetFilterMasks<SIND128> createSkillsetFilterMasks<SIND128>(const TalentTree&, const TreeDAGInfo&, std::shared_ptr<TalentSkillset>);
+    template BasicSkillsetFilterMasks<SIND256> createSkillsetFilterMasks<SIND256>(const TalentTree&, const TreeDAGInfo&, std::shared_ptr<TalentSkillset>);
 }
\ No newline at end of file
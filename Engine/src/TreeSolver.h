@@ -1,14 +1,181 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "TTMEnginePresets.h"
 #include "TalentTrees.h"
+#include "BigCount.h"
 
 constexpr unsigned long long RESERVED_MEMORY_LIMIT = 4294967296;
+//lower bound of the default solver memory budget for machines with little (or unknown) physical memory
+constexpr size_t SOLVER_MIN_MEMORY_BUDGET = 268435456;
+//max number of expanded talents the solvers can handle (widest skillset index is 256 bit)
+constexpr int MAX_SOLVER_TALENTS = 256;
+//the threaded solver splits the search tree until there are at least this many subtree tasks per thread (or max split depth is reached)
+constexpr size_t SOLVER_TASKS_PER_THREAD = 32;
+constexpr int SOLVER_MAX_SPLIT_DEPTH = 8;
+//checkpointed and sharded solves split the search tree into at least this many subtree tasks regardless of the number of threads,
+//so checkpoints can be resumed with a different thread count and every shard process gets the same task slots
+constexpr size_t SOLVER_FIXED_LAYOUT_TASKS = 1024;
+//streaming solves hand combinations to the sink in blocks of this many combinations
+constexpr size_t SOLVER_STREAM_BLOCK_SIZE = 4096;
+//solver kernels publish their counters to the solve handle and check for cancellation every this many visited nodes
+constexpr size_t SOLVE_PROGRESS_INTERVAL = 16384;
+//filterSolvedSkillsets keeps at most this many earlier filter generations to go back to when a filter gets relaxed (fewer if they
+//don't fit into the solver memory budget next to allCombinations)
+constexpr size_t FILTER_GENERATION_LIMIT = 8;
 
 namespace Engine {
+    //number of builds for a given amount of talent points, used by the count only solver
+    using CombinationCount = std::uint64_t;
+
+    /*
+    Skillset index for trees with more than 64 expanded talents, bit i is stored in words[i / 64] at position i % 64.
+    Solvers store these as Words consecutive SINDs per combination (see TreeDAGInfo::indexWords) so trees that fit into
+    a single SIND keep their layout and the kernels for them are not affected by the wide variants.
+    */
+    template<size_t Words>
+    struct WideSkillsetIndex {
+        SIND words[Words] = {};
+
+        WideSkillsetIndex operator&(const WideSkillsetIndex& other) const {
+            WideSkillsetIndex result;
+            for (size_t i = 0; i < Words; i++) {
+                result.words[i] = words[i] & other.words[i];
+            }
+            return result;
+        }
+        WideSkillsetIndex operator|(const WideSkillsetIndex& other) const {
+            WideSkillsetIndex result;
+            for (size_t i = 0; i < Words; i++) {
+                result.words[i] = words[i] | other.words[i];
+            }
+            return result;
+        }
+        WideSkillsetIndex operator~() const {
+            WideSkillsetIndex result;
+            for (size_t i = 0; i < Words; i++) {
+                result.words[i] = ~words[i];
+            }
+            return result;
+        }
+        WideSkillsetIndex& operator&=(const WideSkillsetIndex& other) {
+            for (size_t i = 0; i < Words; i++) {
+                words[i] &= other.words[i];
+            }
+            return *this;
+        }
+        WideSkillsetIndex& operator|=(const WideSkillsetIndex& other) {
+            for (size_t i = 0; i < Words; i++) {
+                words[i] |= other.words[i];
+            }
+            return *this;
+        }
+        bool operator==(const WideSkillsetIndex& other) const {
+            for (size_t i = 0; i < Words; i++) {
+                if (words[i] != other.words[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        bool operator!=(const WideSkillsetIndex& other) const {
+            return !(*this == other);
+        }
+    };
+    using SIND128 = WideSkillsetIndex<2>;
+    using SIND256 = WideSkillsetIndex<4>;
+
+    /*
+    Number of SIND words of a skillset index type.
+    */
+    template<typename IndexType>
+    struct SkillsetIndexTraits {
+        static constexpr int words = 1;
+    };
+    template<size_t Words>
+    struct SkillsetIndexTraits<WideSkillsetIndex<Words>> {
+        static constexpr int words = static_cast<int>(Words);
+    };
+
+    /*
+    Hash of skillset indices for the states of the dynamic programs.
+    */
+    struct SkillsetIndexHash {
+        size_t operator()(SIND skillsetIndex) const {
+            return std::hash<SIND>()(skillsetIndex);
+        }
+
+        template<size_t Words>
+        size_t operator()(const WideSkillsetIndex<Words>& skillsetIndex) const {
+            size_t hash = 0;
+            for (size_t i = 0; i < Words; i++) {
+                hash ^= std::hash<SIND>()(skillsetIndex.words[i]) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            }
+            return hash;
+        }
+    };
+
+    /*
+    Calls solve with a default constructed skillset index of the width that belongs to indexWords (see getSkillsetIndexWords), i.e.
+    picks the compile time specialized kernels at runtime.
+    */
+    template<typename Function>
+    void dispatchSkillsetIndexType(int indexWords, Function&& solve) {
+        switch (indexWords) {
+        case 1: solve(SIND()); break;
+        case 2: solve(SIND128()); break;
+        case 4: solve(SIND256()); break;
+        default: throw std::logic_error("Unsupported skillset index width");
+        }
+    }
+
+    /*
+    Filter masks as sorted lists of skillset index bits (see BasicSkillsetFilterMasks and createCombinationFilterBits), used by
+    the bitmap index queries and the incremental filtering since they are independent of the skillset index width.
+    */
+    struct CombinationFilterBits {
+        std::vector<int> includeBits;
+        std::vector<int> excludeBits;
+        std::vector<int> orBits;
+        std::vector<std::pair<std::vector<int>, std::vector<int>>> oneBits;
+
+        bool isEmpty() const;
+        bool operator==(const CombinationFilterBits& other) const;
+        bool isRefinementOf(const CombinationFilterBits& other) const;
+        //same semantics as checkSkillsetFilter for a single skillset index
+        bool matches(const SIND* skillsetIndex) const;
+    };
+
+    /*
+    Earlier result of filterSolvedSkillsets that is kept to go back to when a filter gets relaxed again.
+    */
+    struct FilterGeneration {
+        CombinationFilterBits filter;
+        vec2d<SIND> combinations;
+    };
+
+    /*
+    Compressed sparse row layout of TreeDAGInfo::minimalTreeDAG and the talent properties the solver kernels need, so hot loops read
+    contiguous integer arrays instead of chasing the shared_ptrs of sortedTalents. All arrays are indexed by the sorted talent index,
+    the children of talent i are childIndices[childOffsets[i]] up to childIndices[childOffsets[i + 1]] (exclusive).
+    */
+    struct FlatTreeDAG {
+        std::vector<int> childOffsets;
+        std::vector<int> childIndices;
+        std::vector<int> pointsRequired;
+        //1 for regular talents and 2 for switch talents (same as minimalTreeDAG[i][0])
+        std::vector<int> weights;
+        std::vector<TalentType> types;
+    };
 
     /*
     This is the container for the heavily optimized, topologically sorted DAG variant of the talent tree.
@@ -17,29 +184,232 @@ namespace Engine {
     NOTE: The talents aren't selected (i.e. Talent::points incremented) at all but a flag is set in a uint64 which is used
     as an indexer. There exist routines that translate from uint64 to a regular tree and in the future maybe vice versa.
     */
+    class CombinationBitmapIndex;
+    class NearestBuildIndex;
+    class CombinationRanker;
+    class CombinationStoreReader;
+
     struct TreeDAGInfo {
         vec2d<int> minimalTreeDAG;
         TalentVec sortedTalents;
+        //same DAG as minimalTreeDAG/sortedTalents for the solver kernels (see createFlatTreeDAG)
+        FlatTreeDAG flatTreeDAG;
         std::vector<std::pair<int, int>> switchTalentChoices;
         std::vector<int> rootIndices;
         std::shared_ptr<TalentTree> processedTree;
         vec2d<SIND> allCombinations;
         size_t allCombinationsSum = 0;
         vec2d<SIND> filteredCombinations;
+        //filter of filteredCombinations and the stack of less strict earlier filter generations (back() is the latest),
+        //filterSolvedSkillsets only filters the smallest known superset of the new result instead of allCombinations
+        CombinationFilterBits currentFilter;
+        bool hasCurrentFilter = false;
+        std::vector<FilterGeneration> filterGenerations;
+        //number of SINDs per combination in allCombinations/filteredCombinations (1, 2 or 4, see getSkillsetIndexWords)
+        int indexWords = 1;
+        //only filled by the count only solver, index i holds the number of builds with i + 1 talent points
+        //(weighted counts include every switch talent variation of a build)
+        std::vector<CombinationCount> combinationCounts;
+        std::vector<CombinationCount> weightedCombinationCounts;
+        //exact counts if one of the counts doesn't fit into a CombinationCount (empty otherwise), combinationCounts and
+        //allCombinationsSum then saturate at UINT64_MAX (see getCombinationsSumString)
+        std::vector<BigCount> exactCombinationCounts;
+        std::vector<BigCount> exactWeightedCombinationCounts;
+        //optional per talent index over allCombinations for fast filter queries (see createCombinationBitmapIndex)
+        //(possibly on another thread, only access it with std::atomic_load/atomic_store)
+        std::shared_ptr<const CombinationBitmapIndex> bitmapIndex;
+        //optional substring index over allCombinations for nearest build queries (see findNearestBuilds), created after the solve
+        //(possibly on another thread, only access it with std::atomic_load/atomic_store, see createNearestBuildIndex)
+        std::shared_ptr<const NearestBuildIndex> nearestBuildIndex;
+        //only filled for browsing without solving (see countConfigurationsRanked), index i ranks the builds with i + 1 talent points
+        //and allCombinations stays empty, rankers are created on first use (see getCombinationRanker)
+        std::vector<std::shared_ptr<CombinationRanker>> combinationRankers;
+        //only filled for solves whose combinations exceed the memory budget, they are spilled into a temporary combination store
+        //(removed with the tree DAG) and browsed from disk while allCombinations keeps empty buckets (see countConfigurationsSpilled)
+        std::shared_ptr<CombinationStoreReader> combinationStore;
         double elapsedTime = 0.0;
+        //the solve was loaded from the solve cache instead of enumerating the tree (see SolveCache.h)
+        bool loadedFromSolveCache = false;
         bool safetyGuardTriggered = false;
         size_t safetyGuard = 500000000;
     };
 
-    struct TreeDAGInfoLegacy {
-        vec2d<int> minimalTreeDAG;
-        TalentVec sortedTalents;
-        std::vector<int> rootIndices;
-        std::shared_ptr<TalentTree> processedTree;
-        vec2d<std::pair<SIND, int>> allCombinations;
-        vec2d<std::pair<SIND, int>> filteredCombinations;
-        double elapsedTime = 0.0;
-        bool safetyGuardTriggered = false;
+    struct FilterExpression;
+    template<typename IndexType>
+    struct BasicFilterProgram;
+    class SolveCheckpoint;
+
+    /*
+    Filter masks that are created from a filter skillset (see createSkillsetFilterMasks) and checked against a skillset index.
+    */
+    template<typename IndexType>
+    struct BasicSkillsetFilterMasks {
+        IndexType includeFilter = {}; //this talent has to have exactly the specified amount of talent points
+        IndexType excludeFilter = {}; //this talent must not have any talent points assigned
+        IndexType orFilter = {}; //this group of talents has to have at least one talent point assigned
+        std::vector<std::pair<IndexType, IndexType>> oneFilter; //exactly one talent in this group has to be maxed while all others must not have any points
+        std::shared_ptr<const BasicFilterProgram<IndexType>> program; //optional compiled filter expression (see FilterExpression.h)
+        //reachability table for pruning, index i holds talent i and every talent that reaches it without passing an excluded talent
+        //(empty if there is no include, or and one filter), orAncestorMask is the union over the or filter talents
+        std::vector<IndexType> ancestorMasks;
+        IndexType orAncestorMask = {};
+    };
+    using SkillsetFilterMasks = BasicSkillsetFilterMasks<SIND>;
+
+    /*
+    Bit mask representation of the sorted DAG that is used by the bitmask frontier kernels (visitTalentsFrontier*).
+    Bit i always corresponds to the talent with index i in TreeDAGInfo::sortedTalents.
+    */
+    template<typename IndexType>
+    struct BasicTreeDAGMasks {
+        int talentCount = 0;
+        IndexType rootMask = {};
+        std::vector<IndexType> childMasks;
+        //index i contains all talents whose points required are fulfilled with i talent points spent
+        std::vector<IndexType> unlockedMasks;
+    };
+    using TreeDAGMasks = BasicTreeDAGMasks<SIND>;
+
+    /*
+    A single depth of the explicit stack of the frontier kernels. Holds the current path, all talents that were reachable so far
+    (roots and children of visited talents) and the talents that still have to be visited from this path.
+    */
+    template<typename IndexType>
+    struct BasicFrontierFrame {
+        IndexType visitedTalents = {};
+        IndexType possibleTalents = {};
+        IndexType candidates = {};
+    };
+    using FrontierFrame = BasicFrontierFrame<SIND>;
+
+    /*
+    Block of combinations of a streaming solve (see countConfigurationsStreaming), all combinations have talentPoints talent points
+    and consist of indexWords SINDs each (same layout as TreeDAGInfo::allCombinations).
+    */
+    struct CombinationBlock {
+        int talentPoints = 0;
+        int indexWords = 1;
+        std::vector<SIND> combinations;
+    };
+
+    /*
+    Receiver of the combinations of a streaming solve. push is called from the solver threads (possibly concurrently) whenever a
+    block is full, sinks may take the combinations vector of the block (e.g. by moving it). Returning false cancels the solve.
+    With more than one solver thread blocks of different subtrees arrive in no particular order, single threaded solves
+    push combinations in the same order as countConfigurationsSingle/Parallel store them.
+    */
+    class CombinationSink {
+    public:
+        virtual ~CombinationSink() = default;
+        //called once after the sorted DAG was created and before the first push
+        virtual void begin(const TreeDAGInfo&) {}
+        //single threaded sharded solves (see SolveShard) call this before the combinations of every task slot of the shard
+        virtual void beginTask(size_t) {}
+        virtual bool push(CombinationBlock& block) = 0;
+        //called once after the solve finished or was canceled
+        virtual void finish() {}
+    };
+
+    /*
+    Sink that calls a function for every single combination (skillset index with TreeDAGInfo::indexWords SINDs and its talent points).
+    Calls are serialized, returning false cancels the solve.
+    */
+    class CallbackCombinationSink : public CombinationSink {
+    public:
+        explicit CallbackCombinationSink(std::function<bool(const SIND* skillsetIndex, int talentPoints)> callback);
+        bool push(CombinationBlock& block) override;
+
+    private:
+        std::function<bool(const SIND*, int)> callback;
+        std::mutex callbackMutex;
+    };
+
+    /*
+    Bounded lock-free ring buffer of combination blocks that decouples the solver threads from a consumer on another thread
+    (multi producer multi consumer queue with per slot sequence numbers). Producers wait while the buffer is full so memory usage
+    is limited to capacity blocks. The consumer calls tryPop until isDone returns true, cancel stops all waiting producers and the solve.
+    */
+    class CombinationRingBuffer : public CombinationSink {
+    public:
+        explicit CombinationRingBuffer(size_t capacity);
+        bool push(CombinationBlock& block) override;
+        void finish() override;
+        bool tryPop(CombinationBlock& block);
+        bool isDone();
+        void cancel();
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence{ 0 };
+            CombinationBlock block;
+        };
+        std::unique_ptr<Slot[]> slots;
+        size_t slotMask = 0;
+        alignas(64) std::atomic<size_t> enqueuePosition{ 0 };
+        alignas(64) std::atomic<size_t> dequeuePosition{ 0 };
+        std::atomic<bool> finished{ false };
+        std::atomic<bool> canceled{ false };
+    };
+
+    /*
+    Part of a solve that is distributed over several processes. The threaded kernels split every tree into the same task slots
+    (subtree tasks in search order, see SOLVER_FIXED_LAYOUT_TASKS), shard index of count solves the slots with slot % count == index
+    so every shard gets a similar mix of large and small subtrees. count = 1 solves the whole tree.
+    */
+    struct SolveShard {
+        int index = 0;
+        int count = 1;
+    };
+
+    /*
+    Handle of a running solve that is shared between the solver threads and observers (UI, CLI progress output). All members are
+    atomic so observers can poll it while the solve is running. Progress is measured in finished root subtrees (tasks of the threaded
+    kernel or root talents of the single threaded kernel), the ETA extrapolates the elapsed time linearly.
+    cancel stops the kernels within SOLVE_PROGRESS_INTERVAL nodes (the solve counts as canceled, see safetyGuardTriggered).
+    Solvers never mark the handle as finished themselves, whoever runs the solve calls markFinished after the results were published
+    so observers can read them safely once isFinished returns true.
+    A checkpoint (see SolveCheckpoint) and a shard have to be set before the solve starts.
+    */
+    class SolveHandle {
+    public:
+        SolveHandle();
+
+        void cancel();
+        bool isCanceled() const;
+        void markFinished();
+        bool isFinished() const;
+
+        void addTasks(size_t count);
+        void finishTasks(size_t count);
+        void addVisitedNodes(size_t count);
+        void addResults(size_t count);
+
+        size_t getTaskCount() const;
+        size_t getFinishedTaskCount() const;
+        size_t getVisitedNodes() const;
+        size_t getResultCount() const;
+        //fraction of finished tasks (0 to 1)
+        double getProgress() const;
+        double getElapsedSeconds() const;
+        //negative as long as no task finished
+        double getEstimatedSecondsLeft() const;
+
+        void setCheckpoint(std::shared_ptr<SolveCheckpoint> checkpoint);
+        SolveCheckpoint* getCheckpoint() const;
+        void setShard(SolveShard shard);
+        SolveShard getShard() const;
+
+    private:
+        std::atomic<size_t> taskCount{ 0 };
+        std::atomic<size_t> finishedTaskCount{ 0 };
+        std::atomic<size_t> visitedNodes{ 0 };
+        std::atomic<size_t> resultCount{ 0 };
+        std::atomic<bool> canceled{ false };
+        std::atomic<bool> finished{ false };
+        //steady clock ticks at construction
+        long long startTime = 0;
+        std::shared_ptr<SolveCheckpoint> checkpoint;
+        SolveShard shard;
     };
 
     void countConfigurationsFiltered(
@@ -48,97 +418,317 @@ namespace Engine {
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
-        bool& safetyGuardTriggered
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        std::shared_ptr<SolveHandle> solveHandle = nullptr,
+        std::shared_ptr<FilterExpression> filterExpression = nullptr
     );
     void countConfigurationsSingle(
         TalentTree tree,
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
-        bool& safetyGuardTriggered
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        std::shared_ptr<SolveHandle> solveHandle = nullptr
     );
     void countConfigurationsParallel(
+        TalentTree tree,
+        int talentPointsLimit,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        std::shared_ptr<SolveHandle> solveHandle = nullptr);
+    void countConfigurationsStreaming(
+        TalentTree tree,
+        std::shared_ptr<Engine::TalentSkillset> filter,
+        int talentPointsLimit,
+        bool onlyLimitSolve,
+        CombinationSink& sink,
+        std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
+        bool& inProgress,
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        std::shared_ptr<SolveHandle> solveHandle = nullptr,
+        std::shared_ptr<FilterExpression> filterExpression = nullptr);
+    void countConfigurationsCountOnly(
         TalentTree tree,
         int talentPointsLimit,
         std::shared_ptr<TreeDAGInfo>& treeDAGInfo,
         bool& inProgress,
         bool& safetyGuardTriggered);
-    TreeDAGInfo createSortedMinimalDAG(TalentTree tree);
-    TreeDAGInfoLegacy createSortedMinimalDAGLegacy(TalentTree tree);
-    void visitTalentFiltered(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
+    //return false if a count overflowed, the counts are invalid then and the BigCount version has to be used
+    bool countCombinationsDP(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<CombinationCount>& combinationCounts,
+        std::vector<CombinationCount>& weightedCombinationCounts);
+    void countCombinationsDP(
         const TreeDAGInfo& sortedTreeDAG,
+        int talentPointsLimit,
+        std::vector<BigCount>& combinationCounts,
+        std::vector<BigCount>& weightedCombinationCounts);
+    TreeDAGInfo createSortedMinimalDAG(TalentTree tree);
+    FlatTreeDAG createFlatTreeDAG(const TreeDAGInfo& sortedTreeDAG);
+    int getSkillsetIndexWords(size_t talentCount);
+    template<typename IndexType = SIND>
+    BasicTreeDAGMasks<IndexType> createTreeDAGMasks(const TreeDAGInfo& sortedTreeDAG, int talentPointsLimit);
+    template<typename IndexType>
+    BasicFrontierFrame<IndexType> createRootFrontierFrame(const BasicTreeDAGMasks<IndexType>& masks);
+    template<typename IndexType>
+    void visitTalentsFrontierSingle(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
         std::vector<SIND>& combinations,
-        int& runningCount,
+        size_t& runningCount,
+        size_t safetyGuard,
         bool& safetyGuardTriggered,
-        SIND& includeFilter,
-        SIND& excludeFilter,
-        SIND& orFilter,
-        std::vector<std::pair<SIND, SIND>>& oneFilter
+        int threadCount = 0,
+        SolveHandle* solveHandle = nullptr
     );
-    void visitTalentSingle(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfo& sortedTreeDAG,
+    template<typename IndexType>
+    void visitTalentsFrontierFiltered(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        const BasicSkillsetFilterMasks<IndexType>& filter,
         std::vector<SIND>& combinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        SolveHandle* solveHandle = nullptr
     );
-    void visitTalentParallel(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfo& sortedTreeDAG,
+    template<typename IndexType>
+    void visitTalentsFrontierParallel(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
         vec2d<SIND>& combinations,
-        std::vector<int>& allCombinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
+        size_t& runningCount,
+        size_t safetyGuard,
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        SolveHandle* solveHandle = nullptr
     );
-    void visitTalentParallelLegacy(
-        std::pair<int, int> talentIndexReqPair,
-        SIND visitedTalents,
-        int currentPosTalIndex,
-        int currentMultiplier,
-        int talentPointsSpent,
-        int talentPointsLeft,
-        std::vector<std::pair<int, int>> possibleTalents,
-        const TreeDAGInfoLegacy& sortedTreeDAG,
-        vec2d<std::pair<SIND, int>>& combinations,
-        std::vector<int>& allCombinations,
-        int& runningCount,
-        bool& safetyGuardTriggered
+    template<typename IndexType>
+    void visitTalentsFrontierStreaming(
+        const BasicTreeDAGMasks<IndexType>& masks,
+        int talentPointsLimit,
+        bool storeAllLengths,
+        const BasicSkillsetFilterMasks<IndexType>* filter,
+        CombinationSink& sink,
+        size_t& runningCount,
+        bool& safetyGuardTriggered,
+        int threadCount = 0,
+        SolveHandle* solveHandle = nullptr
     );
-    inline void setTalent(SIND& talent, int index);
+    /*
+    Small helpers that let the kernels treat SIND and WideSkillsetIndex the same way.
+    */
+    inline void setTalent(SIND& talent, int index) {
+        talent |= 1ULL << index;
+    }
+    template<size_t Words>
+    inline void setTalent(WideSkillsetIndex<Words>& talent, int index) {
+        talent.words[index >> 6] |= 1ULL << (index & 63);
+    }
+    inline bool hasTalents(SIND talents) {
+        return talents != 0;
+    }
+    template<size_t Words>
+    inline bool hasTalents(const WideSkillsetIndex<Words>& talents) {
+        for (size_t i = 0; i < Words; i++) {
+            if (talents.words[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+    //SINDs of a skillset index in the allCombinations layout
+    inline const SIND* getMaskWords(const SIND& mask) {
+        return &mask;
+    }
+    template<size_t Words>
+    inline const SIND* getMaskWords(const WideSkillsetIndex<Words>& mask) {
+        return mask.words;
+    }
+    inline bool isTalentSelected(const SIND* skillsetIndex, int index) {
+        return (skillsetIndex[index >> 6] >> (index & 63)) & 1ULL;
+    }
+    //skillset index from the SINDs of a combination in the allCombinations layout
+    inline void loadMaskWords(const SIND* skillsetIndex, SIND& mask) {
+        mask = skillsetIndex[0];
+    }
+    template<size_t Words>
+    inline void loadMaskWords(const SIND* skillsetIndex, WideSkillsetIndex<Words>& mask) {
+        std::copy(skillsetIndex, skillsetIndex + Words, mask.words);
+    }
+    template<typename IndexType>
+    inline IndexType loadSkillsetIndex(const SIND* skillsetIndex) {
+        IndexType mask;
+        loadMaskWords(skillsetIndex, mask);
+        return mask;
+    }
+
+    /*
+    Values of the take/skip states of a sorted DAG for completions to exactly talentPoints talent points (see createTreeStateTable).
+    A state is the set of reachable undecided talents before talent i is decided, levels[i] maps it to the offset of its row in values
+    (talentPoints + 1 entries, indexed by talent points spent). States without any completion are not stored and have emptyValue.
+    Talents in includeMask can't be skipped and talents in excludeMask can't be taken.
+    */
+    template<typename IndexType, typename Value>
+    struct BasicTreeStateTable {
+        int talentPoints = 0;
+        BasicTreeDAGMasks<IndexType> masks;
+        IndexType includeMask = {};
+        IndexType excludeMask = {};
+        std::vector<int> pointsRequired;
+        Value emptyValue = {};
+        Value completeValue = {};
+        std::vector<std::unordered_map<IndexType, size_t, SkillsetIndexHash>> levels;
+        std::vector<Value> values;
+
+        Value getValue(size_t level, const IndexType& mask, int talentPointsSpent) const {
+            if (level == levels.size()) {
+                return talentPointsSpent == talentPoints ? completeValue : emptyValue;
+            }
+            auto it = levels[level].find(mask);
+            if (it == levels[level].end()) {
+                return emptyValue;
+            }
+            return values[it->second + talentPointsSpent];
+        }
+
+        size_t getStateCount() const {
+            return values.size() / (talentPoints + 1);
+        }
+
+        bool isSkippable(size_t talent) const {
+            return !isTalentSelected(getMaskWords(includeMask), static_cast<int>(talent));
+        }
+
+        //talent has to be reachable from mask, allowed by the filter and unlocked with talentPointsSpent points
+        bool isTakeable(size_t talent, const IndexType& mask, int talentPointsSpent) const {
+            return isTalentSelected(getMaskWords(mask), static_cast<int>(talent))
+                && !isTalentSelected(getMaskWords(excludeMask), static_cast<int>(talent))
+                && talentPointsSpent >= pointsRequired[talent] && talentPointsSpent < talentPoints;
+        }
+
+        IndexType getSkipMask(size_t talent, const IndexType& mask) const {
+            IndexType talentBit = {};
+            setTalent(talentBit, static_cast<int>(talent));
+            return mask & ~talentBit;
+        }
+
+        IndexType getTakeMask(size_t talent, const IndexType& mask) const {
+            IndexType talentBit = {};
+            setTalent(talentBit, static_cast<int>(talent));
+            return (mask | masks.childMasks[talent]) & ~talentBit;
+        }
+    };
+
+    /*
+    Creates the state table of the take/skip decisions of the sorted talents (same states as countCombinationsDP). A forward pass
+    collects the reachable states of every level, a backward pass fills the rows from the last talent to the first with
+    combine(talent, skipValue, takeValue), where skipValue/takeValue are the values of the successor states or emptyValue if the
+    decision isn't allowed. Completions to exactly talentPoints talent points have completeValue, e.g. path counts use 0, 1 and a sum.
+    */
+    template<typename IndexType, typename Value, typename CombineFunction>
+    BasicTreeStateTable<IndexType, Value> createTreeStateTable(
+        const TreeDAGInfo& sortedTreeDAG,
+        int talentPoints,
+        const std::vector<int>& includeBits,
+        const std::vector<int>& excludeBits,
+        Value emptyValue,
+        Value completeValue,
+        CombineFunction&& combine)
+    {
+        BasicTreeStateTable<IndexType, Value> table;
+        table.talentPoints = talentPoints;
+        table.masks = createTreeDAGMasks<IndexType>(sortedTreeDAG, talentPoints);
+        table.emptyValue = emptyValue;
+        table.completeValue = completeValue;
+        for (auto& talent : sortedTreeDAG.sortedTalents) {
+            table.pointsRequired.push_back(talent->pointsRequired);
+        }
+        for (int bit : includeBits) {
+            setTalent(table.includeMask, bit);
+        }
+        for (int bit : excludeBits) {
+            setTalent(table.excludeMask, bit);
+        }
+        size_t talentCount = static_cast<size_t>(table.masks.talentCount);
+
+        //the points spent are not tracked by the forward pass since every state gets a full row
+        std::vector<std::unordered_set<IndexType, SkillsetIndexHash>> reachable(talentCount + 1);
+        reachable[0].insert(table.masks.rootMask);
+        for (size_t i = 0; i < talentCount; i++) {
+            reachable[i + 1].reserve(2 * reachable[i].size());
+            for (const IndexType& mask : reachable[i]) {
+                reachable[i + 1].insert(table.getSkipMask(i, mask));
+                if (isTalentSelected(getMaskWords(mask), static_cast<int>(i))) {
+                    reachable[i + 1].insert(table.getTakeMask(i, mask));
+                }
+            }
+        }
+
+        table.levels.resize(talentCount);
+        std::vector<Value> row(talentPoints + 1);
+        for (size_t i = talentCount; i-- > 0;) {
+            bool skippable = table.isSkippable(i);
+            table.levels[i].reserve(reachable[i].size());
+            for (const IndexType& mask : reachable[i]) {
+                IndexType skipMask = table.getSkipMask(i, mask);
+                IndexType takeMask = table.getTakeMask(i, mask);
+                bool empty = true;
+                for (int s = 0; s <= talentPoints; s++) {
+                    Value skipValue = skippable ? table.getValue(i + 1, skipMask, s) : emptyValue;
+                    Value takeValue = table.isTakeable(i, mask, s) ? table.getValue(i + 1, takeMask, s + 1) : emptyValue;
+                    row[s] = combine(i, skipValue, takeValue);
+                    empty &= row[s] == emptyValue;
+                }
+                if (empty) {
+                    continue;
+                }
+                table.levels[i][mask] = table.values.size();
+                table.values.insert(table.values.end(), row.begin(), row.end());
+            }
+            //the next level is only needed for lookups while this level gets filled
+            reachable[i + 1].clear();
+        }
+        return table;
+    }
 
     std::string fillOutTreeWithBinaryIndexToString(SIND comb, TalentTree tree, TreeDAGInfo treeDAG);
-    void insertIntoVector(std::vector<std::pair<int, int>>& v, std::pair<int, int>& t);
 
+    template<typename IndexType = SIND>
+    BasicSkillsetFilterMasks<IndexType> createSkillsetFilterMasks(const TalentTree& tree, const TreeDAGInfo& treeDAG, std::shared_ptr<TalentSkillset> filter);
     void filterSolvedSkillsets(const TalentTree& tree, std::shared_ptr<TreeDAGInfo> treeDAG, std::shared_ptr<TalentSkillset> filter);
+    size_t filterSkillsetIndices(const SIND* combinations, size_t count, const SkillsetFilterMasks& filter, SIND* filtered);
     bool checkSkillsetFilter(
         const SIND visitedTalents,
         const SIND includeFilter,
         const SIND excludeFilter,
         const SIND orFilter,
-        const std::vector<std::pair<SIND, SIND>> oneFilter);
+        const std::vector<std::pair<SIND, SIND>>& oneFilter);
     std::shared_ptr<TalentSkillset> skillsetIndexToSkillset(
         const TalentTree& tree,
         std::shared_ptr<TreeDAGInfo> treeDAG,
         SIND skillsetIndex);
+    std::shared_ptr<TalentSkillset> skillsetIndexToSkillset(
+        const TalentTree& tree,
+        std::shared_ptr<TreeDAGInfo> treeDAG,
+        const SIND* skillsetIndex);
+    std::vector<SIND> skillsetToSkillsetIndex(
+        const TalentTree& tree,
+        const TreeDAGInfo& treeDAG,
+        std::shared_ptr<TalentSkillset> skillset);
+    std::string skillsetIndexToString(const SIND* skillsetIndex, int indexWords);
+    size_t getCombinationCount(const TreeDAGInfo& treeDAG, const std::vector<SIND>& combinations);
+    std::string getCombinationsSumString(const TreeDAGInfo& treeDAG);
 
+    size_t getPhysicalMemorySize();
+    void setSolverMemoryBudget(size_t memoryBudget);
+    size_t getSolverMemoryBudget();
     void setSafetyGuard(TreeDAGInfo& treeDAGInfo);
 }
\ No newline at end of file
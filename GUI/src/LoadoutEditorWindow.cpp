@@ -457,6 +457,66 @@ namespace TTM {
                     }
                 }
 
+                uiData.hoveredEditorSkillset = nullptr;
+                if (ImGui::CollapsingHeader("Closest legal builds"))
+                {
+                    std::shared_ptr<Engine::TreeDAGInfo> treeDAG = talentTreeCollection.activeTreeData().treeDAGInfo;
+                    bool hasCombinations = false;
+                    if (treeDAG && !talentTreeCollection.activeTreeData().isTreeSolveInProgress) {
+                        for (auto& combinations : treeDAG->allCombinations) {
+                            hasCombinations |= combinations.size() > 0;
+                        }
+                    }
+                    if (!hasCombinations || talentTreeCollection.activeTree().loadout.size() == 0) {
+                        ImGui::TextWrapped("Solve the tree in the loadout solver (without ranked/count only mode) or load a saved solution to get "
+                            "the closest legal builds of the active skillset.");
+                    }
+                    else {
+                        ImGui::Text("Max. talent point difference:");
+                        ImGui::SliderInt("##loadoutEditorNearestBuildDistanceSlider", &uiData.loadoutEditorNearestBuildDistance, 0, 8, "%d", ImGuiSliderFlags_AlwaysClamp);
+                        updateNearestBuilds(uiData, talentTreeCollection);
+                        if (uiData.loadoutEditorNearestBuilds.size() == 0) {
+                            ImGui::Text("No legal build within %d talent points.", uiData.loadoutEditorNearestBuildDistance);
+                        }
+                        else if (uiData.loadoutEditorNearestBuilds[0].distance == 0) {
+                            ImGui::Text("Active skillset is a legal build.");
+                        }
+                        float boxHeight = ImGui::CalcTextSize("@").y;
+                        if (uiData.loadoutEditorNearestBuilds.size() > 0
+                            && ImGui::BeginListBox("##loadoutEditorNearestBuildsListbox", ImVec2(ImGui::GetContentRegionAvail().x, 10 * boxHeight)))
+                        {
+                            for (int n = 0; n < uiData.loadoutEditorNearestBuilds.size(); n++) {
+                                const Engine::NearestBuild& build = uiData.loadoutEditorNearestBuilds[n];
+                                std::string label = std::to_string(build.distance) + " changes, " + std::to_string(build.talentPoints) + " points";
+                                if (ImGui::Selectable((label + "##loadoutEditorNearestBuild" + std::to_string(n)).c_str(), false)) {
+                                    //replace the points of the active skillset but keep its name and level cap settings
+                                    std::shared_ptr<Engine::TalentSkillset> sk = Engine::skillsetIndexToSkillset(
+                                        talentTreeCollection.activeTree(),
+                                        treeDAG,
+                                        build.skillsetIndex.data()
+                                    );
+                                    Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), sk);
+                                    talentTreeCollection.activeSkillset()->assignedSkillPoints = sk->assignedSkillPoints;
+                                    talentTreeCollection.activeSkillset()->talentPointsSpent = sk->talentPointsSpent;
+                                    Engine::activateSkillset(talentTreeCollection.activeTree(), talentTreeCollection.activeTree().activeSkillsetIndex);
+                                }
+                                if (ImGui::IsItemHovered()) {
+                                    uiData.hoveredEditorSkillset = Engine::skillsetIndexToSkillset(
+                                        talentTreeCollection.activeTree(),
+                                        treeDAG,
+                                        build.skillsetIndex.data()
+                                    );
+                                    Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), uiData.hoveredEditorSkillset);
+                                }
+                            }
+                            ImGui::EndListBox();
+                        }
+                        ImGui::SameLine();
+                        HelperTooltip("?", "Legal builds of the solved tree that differ from the active skillset in the fewest talent points.\n"
+                            "Hover to preview, click to apply it to the active skillset.");
+                    }
+                }
+
                 if (ImGui::CollapsingHeader("SimulationCraft exports"))
                 {
                     ImGui::Text("Export active skillset to SimC:");
@@ -913,4 +973,28 @@ namespace TTM {
             uiData.scrollBuffer.y = std::clamp(targetScreenPosAbs.y, 0.0f, uiData.maxScrollBuffer.y);
         }
     }
+
+    /*
+    Searches the closest legal builds of the active skillset in the solved combinations of the active tree, results are cached
+    until the assigned points, the solve or the max. distance change so this can run every frame.
+    */
+    void updateNearestBuilds(UIData& uiData, TalentTreeCollection& talentTreeCollection) {
+        std::shared_ptr<Engine::TreeDAGInfo> treeDAG = talentTreeCollection.activeTreeData().treeDAGInfo;
+        std::shared_ptr<Engine::TalentSkillset> skillset = talentTreeCollection.activeSkillset();
+        if (uiData.loadoutEditorNearestBuildsTreeDAG == treeDAG.get()
+            && uiData.loadoutEditorNearestBuildsDistance == uiData.loadoutEditorNearestBuildDistance
+            && uiData.loadoutEditorNearestBuildsSkillPoints == skillset->assignedSkillPoints) {
+            return;
+        }
+        uiData.loadoutEditorNearestBuilds = Engine::findNearestBuilds(
+            talentTreeCollection.activeTree(),
+            treeDAG,
+            skillset,
+            uiData.loadoutEditorNearestBuildDistance,
+            50
+        );
+        uiData.loadoutEditorNearestBuildsTreeDAG = treeDAG.get();
+        uiData.loadoutEditorNearestBuildsDistance = uiData.loadoutEditorNearestBuildDistance;
+        uiData.loadoutEditorNearestBuildsSkillPoints = skillset->assignedSkillPoints;
+    }
 }
\ No newline at end of file
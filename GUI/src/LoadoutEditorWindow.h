@@ -14,4 +14,5 @@ namespace TTM {
 
 
 	void placeLoadoutEditorTreeElements(UIData& uiData, TalentTreeCollection& talentTreeCollection);
+	void updateNearestBuilds(UIData& uiData, TalentTreeCollection& talentTreeCollection);
 }
\ No newline at end of file
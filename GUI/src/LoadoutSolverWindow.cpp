@@ -28,9 +28,27 @@
 #include <thread>
 #include <numeric>
 #include <iterator>
+#include <climits>
 #include <algorithm>
 
 namespace TTM {
+    /*
+    Adds the number of builds of the selected talent point bucket with and without the talent (and per rank for multi point talents)
+    to a tooltip, i.e. the result of including or excluding the talent in the filter.
+    */
+    static void AddTalentInclusionText(const UIData& uiData, Engine::Talent_s talent)
+    {
+        auto countsIt = uiData.loadoutSolverInclusionCounts.find(talent->index);
+        if (uiData.loadoutSolverInclusionBucket < 0 || countsIt == uiData.loadoutSolverInclusionCounts.end() || countsIt->second.size() == 0) {
+            return;
+        }
+        const std::vector<Engine::CombinationCount>& counts = countsIt->second;
+        ImGui::Text(("Builds with talent: " + std::to_string(counts[0]) + ", without: " + std::to_string(uiData.loadoutSolverInclusionTotal - counts[0])).c_str());
+        for (size_t r = 1; r < counts.size(); r++) {
+            ImGui::Text(("Builds with at least " + std::to_string(r + 1) + " points: " + std::to_string(counts[r])).c_str());
+        }
+    }
+
     static void AttachLoadoutSolverTooltip(const UIData& uiData, Engine::Talent_s talent, int assignedPointsTarget)
     {
         if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled) && !ImGui::IsKeyDown(ImGuiKey_LeftAlt))
@@ -70,6 +88,7 @@ namespace TTM {
                 else if (assignedPointsTarget == -3) {
                     ImGui::Text(("Points: exactly 1 in group maxed, points required: " + std::to_string(talent->pointsRequired)).c_str());
                 }
+                AddTalentInclusionText(uiData, talent);
                 ImGui::Spacing();
                 ImGui::Spacing();
 
@@ -102,6 +121,7 @@ namespace TTM {
                 else {
                     ImGui::Text(("Points: exclude, points required: " + std::to_string(talent->pointsRequired)).c_str());
                 }
+                AddTalentInclusionText(uiData, talent);
                 ImGui::Spacing();
                 ImGui::Spacing();
                 ImGui::PushTextWrapPos(ImGui::GetFontSize() * 15.0f);
@@ -182,7 +202,7 @@ namespace TTM {
             ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
             if (ImGui::BeginPopupModal("Talent tree too large", NULL, ImGuiWindowFlags_AlwaysAutoResize))
             {
-                ImGui::Text("Talent tree has too many possible talent points!\nMaximum number of possible talent points spent is 64.");
+                ImGui::Text("Talent tree has too many possible talent points!\nMaximum number of possible talent points spent is %d.", uiData.loadoutSolverMaxTalentPoints);
 
                 ImGui::SetItemDefaultFocus();
                 if (ImGui::Button("OK", ImVec2(120, 0))) { ImGui::CloseCurrentPopup(); }
@@ -207,25 +227,64 @@ namespace TTM {
                 case LoadoutSolverPage::SolutionResults: {
                     ImGui::PushTextWrapPos(ImGui::GetContentRegionAvail().x);
                     if (talentTreeCollection.activeTreeData().treeDAGInfo->safetyGuardTriggered) {
-                        ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "Safety guard triggered! There were more than %d combinations in total or solve was canceled! Values below will not be accurate!", talentTreeCollection.activeTreeData().treeDAGInfo->safetyGuard);
+                        ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "Safety guard triggered! There were more than %zu combinations in total (memory budget) or solve was canceled! Values below will not be accurate!", talentTreeCollection.activeTreeData().treeDAGInfo->safetyGuard);
                     }
                     if (talentTreeCollection.activeTreeData().onlyLimitSolve) {
-                        ImGui::Text("%s has %d different skillset combinations with %d talent points (This does not include variations with different switch talent choices).",
-                            talentTreeCollection.activeTree().name.c_str(), talentTreeCollection.activeTreeData().treeDAGInfo->allCombinationsSum, talentTreeCollection.activeTreeData().treeDAGInfo->allCombinations.size());
+                        ImGui::Text("%s has %s different skillset combinations with %zu talent points (This does not include variations with different switch talent choices).",
+                            talentTreeCollection.activeTree().name.c_str(), Engine::getCombinationsSumString(*talentTreeCollection.activeTreeData().treeDAGInfo).c_str(), talentTreeCollection.activeTreeData().treeDAGInfo->allCombinations.size());
+                    }
+                    else {
+                        ImGui::Text("%s has %s different skillset combinations with 1 to %zu talent points (This does not include variations with different switch talent choices).",
+                            talentTreeCollection.activeTree().name.c_str(), Engine::getCombinationsSumString(*talentTreeCollection.activeTreeData().treeDAGInfo).c_str(), talentTreeCollection.activeTreeData().treeDAGInfo->allCombinations.size());
+                    }
+                    if (talentTreeCollection.activeTreeData().treeDAGInfo->loadedFromSolveCache) {
+                        ImGui::Text("Loading from solve cache took %.3f seconds.", talentTreeCollection.activeTreeData().treeDAGInfo->elapsedTime);
+                    }
+                    else if (talentTreeCollection.activeTreeData().treeDAGInfo->combinationRankers.size() > 0) {
+                        ImGui::Text("Counting took %.3f seconds, combinations are created while browsing.", talentTreeCollection.activeTreeData().treeDAGInfo->elapsedTime);
+                    }
+                    else if (talentTreeCollection.activeTreeData().treeDAGInfo->combinationStore) {
+                        ImGui::Text("Processing took %.3f seconds, combinations exceeded the memory budget and are read from disk while browsing.", talentTreeCollection.activeTreeData().treeDAGInfo->elapsedTime);
                     }
                     else {
-                        ImGui::Text("%s has %d different skillset combinations with 1 to %d talent points (This does not include variations with different switch talent choices).",
-                            talentTreeCollection.activeTree().name.c_str(), talentTreeCollection.activeTreeData().treeDAGInfo->allCombinationsSum, talentTreeCollection.activeTreeData().treeDAGInfo->allCombinations.size());
+                        ImGui::Text("Processing took %.3f seconds.", talentTreeCollection.activeTreeData().treeDAGInfo->elapsedTime);
                     }
-                    ImGui::Text("Processing took %.3f seconds.", talentTreeCollection.activeTreeData().treeDAGInfo->elapsedTime);
                     if (ImGui::Button("Reset solutions")) {
                         clearSolvingProcess(uiData, talentTreeCollection);
                     }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Save solution")) {
+                        //solutions are stored compressed in the app folder and can be loaded instead of solving the tree again
+                        std::filesystem::path storePath = Engine::getCombinationStorePath(talentTreeCollection.activeTree());
+                        try {
+                            Engine::writeCombinationStore(
+                                storePath,
+                                talentTreeCollection.activeTree(),
+                                *talentTreeCollection.activeTreeData().treeDAGInfo,
+                                talentTreeCollection.activeTreeData().onlyLimitSolve
+                            );
+                            uiData.loadoutSolverStoreMessage = "Solution saved to " + storePath.string();
+                        }
+                        catch (std::exception& e) {
+                            uiData.loadoutSolverStoreMessage = e.what();
+                        }
+                    }
+                    if (uiData.loadoutSolverStoreMessage != "") {
+                        ImGui::Text("%s", uiData.loadoutSolverStoreMessage.c_str());
+                    }
                     ImGui::Text("Hint: Include/Exclude talents on the left, then press filter to view all valid combinations.");
                     ImGui::Text("Different colors mean different things.");
                     ImGui::SameLine();
                     TTM::HelperTooltip("(?)", "Green/Yellow: At least selected points spent in this talent.\n\nRed: No points in this talent.\n\nBlue: At least one of all blue talents must have at least 1 point.\n\nPurple: Exactly one talent must be maxed out.");
+                    //ranked and spilled tree DAGs have no combinations in memory that could be filtered
+                    bool browseOnly = Engine::isBrowseOnly(*talentTreeCollection.activeTreeData().treeDAGInfo);
+                    if (browseOnly) {
+                        ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "Browsing without filters, filters require a solve that fits into the memory budget.");
+                    }
                     ImGui::PopTextWrapPos();
+                    if (browseOnly) {
+                        ImGui::BeginDisabled();
+                    }
                     if (ImGui::Checkbox("Auto apply filter", &uiData.loadoutSolverAutoApplyFilter)) {
                         if (uiData.loadoutSolverAutoApplyFilter) {
                             Engine::filterSolvedSkillsets(talentTreeCollection.activeTree(), talentTreeCollection.activeTreeData().treeDAGInfo, talentTreeCollection.activeTreeData().skillsetFilter);
@@ -259,6 +318,25 @@ namespace TTM {
                         uiData.loadoutSolverSkillsetResultPage = -1;
                         uiData.loadoutSolverBufferedPage = -1;
                     }
+                    if (browseOnly) {
+                        ImGui::EndDisabled();
+                    }
+                    if (std::atomic_load(&talentTreeCollection.activeTreeData().treeDAGInfo->bitmapIndex)) {
+                        //count queries on the bitmap index are cheap enough to show the result of the filter before applying it,
+                        //the index is created in the background (see createSolveIndicesAsync), counts are shown once it exists
+                        std::shared_ptr<Engine::TreeDAGInfo> treeDAG = talentTreeCollection.activeTreeData().treeDAGInfo;
+                        std::shared_ptr<Engine::TalentSkillset> skillsetFilter = talentTreeCollection.activeTreeData().skillsetFilter;
+                        if (uiData.loadoutSolverMatchingTreeDAG != treeDAG.get()
+                            || (skillsetFilter && uiData.loadoutSolverMatchingFilter != skillsetFilter->assignedSkillPoints)) {
+                            uiData.loadoutSolverMatchingCount = 0;
+                            for (size_t count : Engine::countFilteredSkillsets(talentTreeCollection.activeTree(), treeDAG, skillsetFilter)) {
+                                uiData.loadoutSolverMatchingCount += count;
+                            }
+                            uiData.loadoutSolverMatchingTreeDAG = treeDAG.get();
+                            uiData.loadoutSolverMatchingFilter = skillsetFilter ? skillsetFilter->assignedSkillPoints : std::map<int, int>();
+                        }
+                        ImGui::Text("Matching combinations with current filter: %zu", uiData.loadoutSolverMatchingCount);
+                    }
                     if (talentTreeCollection.activeTreeData().isTreeSolveFiltered) {
                         ImGui::Separator();
                         ImGui::Text("Number of talent points (number of combinations):");
@@ -295,7 +373,7 @@ namespace TTM {
                                 && talentTreeCollection.activeTree().maxTalentPoints > 0) {
                                 int rtp = talentTreeCollection.activeTreeData().restrictedTalentPoints;
                                 const bool is_selected = (uiData.loadoutSolverTalentPointSelection == rtp);
-                                if (ImGui::Selectable((std::to_string(rtp + 1) + " (" + std::to_string(talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[rtp].size()) + ")").c_str(), is_selected)) {
+                                if (ImGui::Selectable((std::to_string(rtp + 1) + " (" + Engine::getFilteredCombinationCountString(*talentTreeCollection.activeTreeData().treeDAGInfo, rtp) + ")").c_str(), is_selected)) {
                                     uiData.loadoutSolverTalentPointSelection = rtp;
                                     uiData.loadoutSolverSkillsetResultPage = 0;
                                     uiData.loadoutSolverBufferedPage = -1;
@@ -308,9 +386,9 @@ namespace TTM {
                             else {
                                 for (int n = 0; n < talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations.size(); n++)
                                 {
-                                    if (talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[n].size() > 0) {
+                                    if (Engine::getFilteredCombinationCount(*talentTreeCollection.activeTreeData().treeDAGInfo, n) > 0) {
                                         const bool is_selected = (uiData.loadoutSolverTalentPointSelection == n);
-                                        if (ImGui::Selectable((std::to_string(n + 1) + " (" + std::to_string(talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[n].size()) + ")").c_str(), is_selected)) {
+                                        if (ImGui::Selectable((std::to_string(n + 1) + " (" + Engine::getFilteredCombinationCountString(*talentTreeCollection.activeTreeData().treeDAGInfo, n) + ")").c_str(), is_selected)) {
                                             uiData.loadoutSolverTalentPointSelection = n;
                                             uiData.loadoutSolverSkillsetResultPage = 0;
                                             uiData.loadoutSolverBufferedPage = -1;
@@ -324,6 +402,9 @@ namespace TTM {
                             }
                             ImGui::EndListBox();
                         }
+                        ImGui::Checkbox("Show share of builds per talent", &uiData.loadoutSolverShowInclusionCounts);
+                        ImGui::SameLine();
+                        TTM::HelperTooltip("(?)", "Shows how many builds of the selected number of talent points contain each talent (i.e. remain when it gets included in the filter), hover a talent for the exact counts.");
                         if (uiData.loadoutSolverTalentPointSelection > -1) {
                             displayFilteredSkillsetSelector(uiData, talentTreeCollection);
                         }
@@ -347,10 +428,15 @@ namespace TTM {
                             ImGui::TableSetColumnIndex(0);
                             ImGui::Text("%s", currSolver.first.c_str());
                             ImGui::TableSetColumnIndex(1);
-                            ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                            if (currSolver.second->solveHandle) {
+                                ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving... %.0f%%", 100.0 * currSolver.second->solveHandle->getProgress());
+                            }
+                            else {
+                                ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                            }
                             ImGui::TableSetColumnIndex(2);
                             if (ImGui::Button(("cancel###" + currSolver.first).c_str())) {
-                                currSolver.second->safetyGuardTriggered = true;
+                                cancelSolve(*currSolver.second);
                                 updateSolverStatus(uiData, talentTreeCollection, true);
                             }
                         }
@@ -404,6 +490,29 @@ namespace TTM {
         }
     }
 
+    /*
+    Looks up the checkpoint of the solve that would be started with the current settings (the path is keyed on the tree structure, see
+    Engine::getSolveCheckpointPath), only when the settings changed or the checkpoint was marked outdated instead of every frame.
+    */
+    static void updateSolveCheckpointStatus(UIData& uiData, TalentTreeCollection& talentTreeCollection) {
+        Engine::TalentTree& tree = talentTreeCollection.activeTree();
+        //solves clamp the limit to the points of the tree
+        int talentPointsLimit = std::min(uiData.loadoutSolverTalentPointLimit, tree.maxTalentPoints - tree.preFilledTalentPoints);
+        if (!uiData.loadoutSolverCheckpointOutdated
+            && uiData.loadoutSolverCheckpointTreeIndex == talentTreeCollection.activeTreeIndex
+            && uiData.loadoutSolverCheckpointTalentPointLimit == talentPointsLimit
+            && uiData.loadoutSolverCheckpointOnlyLimitSolve == talentTreeCollection.activeTreeData().onlyLimitSolve) {
+            return;
+        }
+        uiData.loadoutSolverCheckpointOutdated = false;
+        uiData.loadoutSolverCheckpointTreeIndex = talentTreeCollection.activeTreeIndex;
+        uiData.loadoutSolverCheckpointTalentPointLimit = talentPointsLimit;
+        uiData.loadoutSolverCheckpointOnlyLimitSolve = talentTreeCollection.activeTreeData().onlyLimitSolve;
+        uiData.loadoutSolverCheckpointPath = Engine::getSolveCheckpointPath(tree, talentPointsLimit, talentTreeCollection.activeTreeData().onlyLimitSolve);
+        std::error_code ec;
+        uiData.loadoutSolverCheckpointAvailable = std::filesystem::is_regular_file(uiData.loadoutSolverCheckpointPath, ec);
+    }
+
     void placeLoadoutSolverTreeElements(UIData& uiData, TalentTreeCollection& talentTreeCollection) {
         updateSolverStatus(uiData, talentTreeCollection);
         Engine::TalentTree& tree = talentTreeCollection.activeTree();
@@ -436,10 +545,15 @@ namespace TTM {
                     ImGui::TableSetColumnIndex(0);
                     ImGui::Text("%s", currSolver.first.c_str());
                     ImGui::TableSetColumnIndex(1);
-                    ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                    if (currSolver.second->solveHandle) {
+                        ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving... %.0f%%", 100.0 * currSolver.second->solveHandle->getProgress());
+                    }
+                    else {
+                        ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                    }
                     ImGui::TableSetColumnIndex(2);
                     if (ImGui::Button(("cancel###" + currSolver.first).c_str())) {
-                        currSolver.second->safetyGuardTriggered = true;
+                        cancelSolve(*currSolver.second);
                         updateSolverStatus(uiData, talentTreeCollection, true);
                     }
                 }
@@ -507,7 +621,29 @@ namespace TTM {
             if (!allowNewSolver) {
                 ImGui::BeginDisabled();
             }
-            if (ImGui::Button("Process tree (max 3 solvers)", ImVec2(wrapWidth + 2 * boxPadding, 25))) {
+            bool processTree = ImGui::Button("Process tree (max 3 solvers)", ImVec2(wrapWidth + 2 * boxPadding, 25));
+            ImGui::SetCursorPosX(centerX - 0.5f * wrapWidth - boxPadding);
+            //counts and ranks builds instead of solving, works for trees that would trigger the safety guard but can't be filtered
+            bool browseTree = ImGui::Button("Browse without solving", ImVec2(wrapWidth + 2 * boxPadding, 25));
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Counts all combinations and creates only the ones on the current page, filters are not available.");
+            }
+            ImGui::SetCursorPosX(centerX - 0.5f * wrapWidth - boxPadding);
+            ImGui::Checkbox("Checkpoint solve", &uiData.loadoutSolverUseCheckpoints);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Periodically saves the progress of the solve, so a canceled solve (or closed app) can be resumed later.\nCheckpoints hold all combinations found so far and need as much disk space as the solution.");
+            }
+            //solves that ran longer than the checkpoint interval leave a checkpoint behind when they are canceled or the app is closed
+            updateSolveCheckpointStatus(uiData, talentTreeCollection);
+            bool resumeTree = false;
+            if (uiData.loadoutSolverCheckpointAvailable) {
+                ImGui::SetCursorPosX(centerX - 0.5f * wrapWidth - boxPadding);
+                resumeTree = ImGui::Button("Resume solve", ImVec2(wrapWidth + 2 * boxPadding, 25));
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("Continues the interrupted solve of this tree with the same talent point limit and \"solve only for max points\" setting\n(and keeps checkpointing it).");
+                }
+            }
+            if (processTree || browseTree || resumeTree) {
                 if (uiData.currentSolvers.size() >= uiData.maxConcurrentSolvers) {
                     return;
                 }
@@ -516,9 +652,8 @@ namespace TTM {
                     uiData.loadoutSolverTalentPointLimit = talentTreeCollection.activeTree().maxTalentPoints - talentTreeCollection.activeTree().preFilledTalentPoints;
                 }
                 if (uiData.loadoutSolverTalentPointLimit > uiData.loadoutSolverMaxTalentPoints
-                    // This check prevents trees with more than 64 spendable talent points from being handled
-                    // In a world where indexing would work with infite spendable talent poins (simple switch from uint64 to bitsets
-                    // this condition can be removed and everything should work fine
+                    // This check prevents trees with more spendable talent points than the widest skillset index (256 bit) from being handled
+                    // (the solver picks a 64, 128 or 256 bit index depending on the number of expanded talents)
                     || talentTreeCollection.activeTree().maxTalentPoints > uiData.loadoutSolverMaxTalentPoints) {
                     ImGui::OpenPopup("Talent tree too large");
                     return;
@@ -530,29 +665,89 @@ namespace TTM {
                 }
                 Engine::clearTree(tree);
 
-                if (talentTreeCollection.activeTreeData().onlyLimitSolve) {
-                    std::thread t(Engine::countConfigurationsSingle,
-                        tree,
-                        uiData.loadoutSolverTalentPointLimit,
-                        std::ref(talentTreeCollection.activeTreeData().treeDAGInfo),
-                        std::ref(talentTreeCollection.activeTreeData().isTreeSolveInProgress),
-                        std::ref(talentTreeCollection.activeTreeData().safetyGuardTriggered));
-                    t.detach();
-                }
-                else {
-                    std::thread t(Engine::countConfigurationsParallel,
-                        tree,
-                        uiData.loadoutSolverTalentPointLimit,
-                        std::ref(talentTreeCollection.activeTreeData().treeDAGInfo),
-                        std::ref(talentTreeCollection.activeTreeData().isTreeSolveInProgress),
-                        std::ref(talentTreeCollection.activeTreeData().safetyGuardTriggered));
-                    t.detach();
+                //the solver thread only writes into its own result, updateSolverStatus takes it over once the handle is finished
+                std::shared_ptr<Engine::SolveHandle> solveHandle = std::make_shared<Engine::SolveHandle>();
+                std::shared_ptr<SolverThreadResult> solverResult = std::make_shared<SolverThreadResult>();
+                if (!browseTree && (uiData.loadoutSolverUseCheckpoints || resumeTree)) {
+                    //the path was looked up with the current settings this frame (see updateSolveCheckpointStatus)
+                    solveHandle->setCheckpoint(std::make_shared<Engine::SolveCheckpoint>(uiData.loadoutSolverCheckpointPath, resumeTree));
                 }
+                uiData.loadoutSolverCheckpointOutdated = true;
+                talentTreeCollection.activeTreeData().solveHandle = solveHandle;
+                talentTreeCollection.activeTreeData().solverResult = solverResult;
+                talentTreeCollection.activeTreeData().isTreeSolveInProgress = true;
+                int talentPointsLimit = uiData.loadoutSolverTalentPointLimit;
+                bool onlyLimitSolve = talentTreeCollection.activeTreeData().onlyLimitSolve;
+                std::thread t([tree, talentPointsLimit, onlyLimitSolve, browseTree, solveHandle, solverResult]() {
+                    if (browseTree) {
+                        Engine::countConfigurationsRanked(
+                            tree,
+                            talentPointsLimit,
+                            onlyLimitSolve,
+                            solverResult->treeDAGInfo,
+                            solverResult->inProgress,
+                            solverResult->safetyGuardTriggered);
+                    }
+                    else if (onlyLimitSolve) {
+                        Engine::countConfigurationsSingle(
+                            tree,
+                            talentPointsLimit,
+                            solverResult->treeDAGInfo,
+                            solverResult->inProgress,
+                            solverResult->safetyGuardTriggered,
+                            0,
+                            solveHandle);
+                    }
+                    else {
+                        Engine::countConfigurationsParallel(
+                            tree,
+                            talentPointsLimit,
+                            solverResult->treeDAGInfo,
+                            solverResult->inProgress,
+                            solverResult->safetyGuardTriggered,
+                            0,
+                            solveHandle);
+                    }
+                    solveHandle->markFinished();
+                    });
+                t.detach();
                 updateSolverStatus(uiData, talentTreeCollection, true);
             }
             if (!allowNewSolver) {
                 ImGui::EndDisabled();
             }
+            std::filesystem::path storePath = Engine::getCombinationStorePath(tree);
+            std::error_code storeError;
+            if (std::filesystem::is_regular_file(storePath, storeError)) {
+                ImGui::SetCursorPosX(centerX - 0.5f * wrapWidth - boxPadding);
+                if (ImGui::Button("Load saved solution", ImVec2(wrapWidth + 2 * boxPadding, 25))) {
+                    clearSolvingProcess(uiData, talentTreeCollection);
+                    Engine::clearTree(tree);
+                    try {
+                        Engine::CombinationStoreMetadata metadata;
+                        talentTreeCollection.activeTreeData().treeDAGInfo = Engine::loadCombinationStore(storePath, tree, metadata);
+                        createSolveIndicesAsync(talentTreeCollection.activeTreeData().treeDAGInfo);
+                        talentTreeCollection.activeTreeData().onlyLimitSolve = metadata.onlyLimitSolve;
+                        talentTreeCollection.activeTreeData().safetyGuardTriggered = metadata.safetyGuardTriggered;
+                        uiData.loadoutSolverTalentPointLimit = metadata.talentPointsLimit;
+                        talentTreeCollection.activeTreeData().skillsetFilter = std::make_shared<Engine::TalentSkillset>();
+                        talentTreeCollection.activeTreeData().skillsetFilter->name = "SolverSkillset";
+                        for (auto& talent : tree.orderedTalents) {
+                            talentTreeCollection.activeTreeData().skillsetFilter->assignedSkillPoints[talent.first] = 0;
+                        }
+                        uiData.loadoutSolverStoreMessage = "";
+                    }
+                    catch (std::exception& e) {
+                        talentTreeCollection.activeTreeData().treeDAGInfo = nullptr;
+                        uiData.loadoutSolverStoreMessage = e.what();
+                    }
+                    updateSolverStatus(uiData, talentTreeCollection, true);
+                }
+            }
+            if (uiData.loadoutSolverStoreMessage != "") {
+                ImGui::SetCursorPosX(centerX - 0.5f * wrapWidth - boxPadding);
+                ImGui::Text("%s", uiData.loadoutSolverStoreMessage.c_str());
+            }
             return;
         }
         else if (talentTreeCollection.activeTreeData().isTreeSolveInProgress) {
@@ -581,10 +776,15 @@ namespace TTM {
                     ImGui::TableSetColumnIndex(0);
                     ImGui::Text("%s", currSolver.first.c_str());
                     ImGui::TableSetColumnIndex(1);
-                    ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                    if (currSolver.second->solveHandle) {
+                        ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving... %.0f%%", 100.0 * currSolver.second->solveHandle->getProgress());
+                    }
+                    else {
+                        ImGui::TextColored(Presets::GET_TOOLTIP_TALENT_TYPE_COLOR(uiData.style), "solving...");
+                    }
                     ImGui::TableSetColumnIndex(2);
                     if (ImGui::Button(("cancel###" + currSolver.first).c_str())) {
-                        currSolver.second->safetyGuardTriggered = true;
+                        cancelSolve(*currSolver.second);
                         updateSolverStatus(uiData, talentTreeCollection, true);
                     }
                 }
@@ -611,15 +811,29 @@ namespace TTM {
             ImVec2 textSize = ImGui::CalcTextSize("Processing...");
             ImGui::SetCursorPos(ImVec2(0.5f * contentRegion.x - 0.5f * textSize.x, 0.5f * contentRegion.y - 0.5f * textSize.y));
             ImGui::Text("Processing...");
+            std::shared_ptr<Engine::SolveHandle> solveHandle = talentTreeCollection.activeTreeData().solveHandle;
+            if (solveHandle) {
+                float progressWidth = 2 * textSize.x + 100.0f;
+                ImGui::SetCursorPosX(0.5f * contentRegion.x - 0.5f * progressWidth);
+                ImGui::ProgressBar(static_cast<float>(solveHandle->getProgress()), ImVec2(progressWidth, 0));
+                ImGui::SetCursorPosX(0.5f * contentRegion.x - 0.5f * progressWidth);
+                ImGui::Text("%zu combinations, %zu nodes", solveHandle->getResultCount(), solveHandle->getVisitedNodes());
+                ImGui::SetCursorPosX(0.5f * contentRegion.x - 0.5f * progressWidth);
+                double secondsLeft = solveHandle->getEstimatedSecondsLeft();
+                if (secondsLeft < 0.0) {
+                    ImGui::Text("Elapsed: %.0fs, remaining: unknown", solveHandle->getElapsedSeconds());
+                }
+                else {
+                    ImGui::Text("Elapsed: %.0fs, remaining: ~%.0fs", solveHandle->getElapsedSeconds(), secondsLeft);
+                }
+            }
             ImGui::SetCursorPosX(0.5f * contentRegion.x - 0.5f * textSize.x);
             if (ImGui::Button("Cancel##loadoutSolverCancelSolveButton", ImVec2(textSize.x, 0))) {
-                talentTreeCollection.activeTreeData().safetyGuardTriggered = true;
+                cancelSolve(talentTreeCollection.activeTreeData());
             }
             ImGui::SetCursorPosX(0.5f * contentRegion.x - 0.5f * 2 * textSize.x);
             if (ImGui::Button("Cancel all solves##loadoutSolverCancelAllButton", ImVec2(2 * textSize.x, 0))) {
-                for (auto& treeData : talentTreeCollection.trees) {
-                    treeData.safetyGuardTriggered = true;
-                }
+                stopAllSolvers(talentTreeCollection);
             }
             return;
         }
@@ -627,11 +841,18 @@ namespace TTM {
             && talentTreeCollection.activeTreeData().treeDAGInfo) {
             //TTMTODO: is this complication even necessary?
             for (auto& talentPointsCombinations : talentTreeCollection.activeTreeData().treeDAGInfo->allCombinations) {
-                talentTreeCollection.activeTreeData().treeDAGInfo->allCombinationsSum += talentPointsCombinations.size();
+                talentTreeCollection.activeTreeData().treeDAGInfo->allCombinationsSum += Engine::getCombinationCount(*talentTreeCollection.activeTreeData().treeDAGInfo, talentPointsCombinations);
+            }
+            if (Engine::isBrowseOnly(*talentTreeCollection.activeTreeData().treeDAGInfo)) {
+                //ranked and spilled tree DAGs can't be filtered, show the talent point buckets right away
+                Engine::filterSolvedSkillsets(talentTreeCollection.activeTree(), talentTreeCollection.activeTreeData().treeDAGInfo, talentTreeCollection.activeTreeData().skillsetFilter);
+                talentTreeCollection.activeTreeData().isTreeSolveFiltered = true;
             }
             talentTreeCollection.activeTreeData().isTreeSolveProcessed = true;
         }
 
+        updateTalentInclusionCounts(uiData, talentTreeCollection);
+
         int talentHalfSpacing = static_cast<int>(uiData.treeEditorBaseTalentHalfSpacing * uiData.treeEditorZoomFactor);
         int talentSize = static_cast<int>(uiData.treeEditorBaseTalentSize * uiData.treeEditorZoomFactor);
         float talentWindowPaddingX = static_cast<float>(uiData.treeEditorTalentWindowPaddingX);
@@ -716,7 +937,7 @@ namespace TTM {
                 if (talentTreeCollection.activeTreeData().skillsetFilter->assignedSkillPoints[talent.first] > talent.second->maxPoints) {
                     talentTreeCollection.activeTreeData().skillsetFilter->assignedSkillPoints[talent.first] = -3;
                 }
-                if (uiData.loadoutSolverAutoApplyFilter) {
+                if (uiData.loadoutSolverAutoApplyFilter && !Engine::isBrowseOnly(*talentTreeCollection.activeTreeData().treeDAGInfo)) {
                     Engine::filterSolvedSkillsets(talentTreeCollection.activeTree(), talentTreeCollection.activeTreeData().treeDAGInfo, talentTreeCollection.activeTreeData().skillsetFilter);
                     talentTreeCollection.activeTreeData().isTreeSolveFiltered = true;
                     uiData.loadoutSolverTalentPointSelection = -1;
@@ -834,6 +1055,26 @@ namespace TTM {
                 talentTreeCollection.activeTreeData().skillsetFilter,
                 searchActive,
                 talentIsSearchedFor);
+            auto inclusionCountsIt = uiData.loadoutSolverInclusionCounts.find(talent.second->index);
+            if (uiData.loadoutSolverShowInclusionCounts && uiData.loadoutSolverInclusionTotal > 0
+                && inclusionCountsIt != uiData.loadoutSolverInclusionCounts.end() && inclusionCountsIt->second.size() > 0) {
+                //share of the builds of the selected bucket that would remain if this talent got included
+                Presets::PUSH_FONT(uiData.fontsize, 3);
+                std::string inclusionLabel = std::to_string(static_cast<int>(100.0 * inclusionCountsIt->second[0] / uiData.loadoutSolverInclusionTotal + 0.5)) + "%";
+                ImVec2 topLeft(posX + ImGui::GetWindowPos().x - ImGui::GetScrollX(), posY + ImGui::GetWindowPos().y - ImGui::GetScrollY());
+                ImVec2 labelSize = ImGui::CalcTextSize(inclusionLabel.c_str());
+                drawList->AddRectFilled(
+                    ImVec2(topLeft.x - 0.1f * talentSize, topLeft.y - 0.1f * talentSize),
+                    ImVec2(topLeft.x - 0.1f * talentSize + labelSize.x + 4.0f, topLeft.y - 0.1f * talentSize + labelSize.y),
+                    ImColor(imStyle.Colors[ImGuiCol_WindowBg])
+                );
+                drawList->AddText(
+                    ImVec2(topLeft.x - 0.1f * talentSize + 2.0f, topLeft.y - 0.1f * talentSize),
+                    ImColor(imStyle.Colors[ImGuiCol_Text]),
+                    inclusionLabel.c_str()
+                );
+                Presets::POP_FONT();
+            }
             if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
                 uiData.loadoutEditorRightClickIndex = talent.first;
             }
@@ -842,7 +1083,7 @@ namespace TTM {
                 if (talentTreeCollection.activeTreeData().skillsetFilter->assignedSkillPoints[talent.first] < -3) {
                     talentTreeCollection.activeTreeData().skillsetFilter->assignedSkillPoints[talent.first] = talent.second->maxPoints;
                 }
-                if (uiData.loadoutSolverAutoApplyFilter) {
+                if (uiData.loadoutSolverAutoApplyFilter && !Engine::isBrowseOnly(*talentTreeCollection.activeTreeData().treeDAGInfo)) {
                     Engine::filterSolvedSkillsets(talentTreeCollection.activeTree(), talentTreeCollection.activeTreeData().treeDAGInfo, talentTreeCollection.activeTreeData().skillsetFilter);
                     talentTreeCollection.activeTreeData().isTreeSolveFiltered = true;
                     uiData.loadoutSolverTalentPointSelection = -1;
@@ -916,20 +1157,22 @@ namespace TTM {
         ImGui::Text("Filtered skillsets: (hover to preview)");
 
         uiData.hoveredFilteredSkillset = nullptr;
+        int indexWords = talentTreeCollection.activeTreeData().treeDAGInfo->indexWords;
         if (ImGui::BeginListBox("##loadoutSolverFilteredSkillsetPageListbox", ImVec2(ImGui::GetContentRegionAvail().x, 0)))
         {
-            for (int n = 0; n < uiData.loadoutSolverPageResults.size(); n++)
+            for (int n = 0; n < uiData.loadoutSolverPageResults.size() / indexWords; n++)
             {
                 const bool is_selected = (uiData.selectedFilteredSkillsetIndex == n);
-                if (ImGui::Selectable(("Id: " + std::to_string(uiData.loadoutSolverPageResults[n])).c_str(), is_selected)) {
+                const Engine::SIND* skillsetIndex = &uiData.loadoutSolverPageResults[n * indexWords];
+                if (ImGui::Selectable(("Id: " + Engine::skillsetIndexToString(skillsetIndex, indexWords)).c_str(), is_selected)) {
                     uiData.selectedFilteredSkillsetIndex = n;
-                    uiData.selectedFilteredSkillset = uiData.loadoutSolverPageResults[n];
+                    uiData.selectedFilteredSkillset.assign(skillsetIndex, skillsetIndex + indexWords);
                 }
                 if (ImGui::IsItemHovered()) {
                     uiData.hoveredFilteredSkillset = Engine::skillsetIndexToSkillset(
                             talentTreeCollection.activeTree(),
                             talentTreeCollection.activeTreeData().treeDAGInfo,
-                            uiData.loadoutSolverPageResults[n]
+                            skillsetIndex
                         );
                 }
 
@@ -975,6 +1218,13 @@ namespace TTM {
             uiData.loadoutSolverSkillsetResultPage = maxPage;
             uiData.selectedFilteredSkillsetIndex = 0;
         }
+        int jumpPage = uiData.loadoutSolverSkillsetResultPage + 1;
+        ImGui::SetNextItemWidth(150.0f);
+        if (ImGui::InputInt("Go to page##loadoutSolverFilterJumpInputInt", &jumpPage, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue)) {
+            jumpPage = jumpPage < 1 ? 1 : jumpPage;
+            uiData.loadoutSolverSkillsetResultPage = jumpPage - 1 > maxPage ? maxPage : jumpPage - 1;
+            uiData.selectedFilteredSkillsetIndex = 0;
+        }
 
         ImGui::Separator();
         ImGui::Text("Switch talent choices:");
@@ -993,7 +1243,8 @@ namespace TTM {
         ImGui::Separator();
         ImGui::Text("Prefix:");
         ImGui::InputText("##loadoutSolverSkillsetPrefixInputText", &uiData.loadoutSolverSkillsetPrefix, 0, TextFilters::FilterNameLetters);
-        if (ImGui::Button("Add selected to loadout##loadoutSolverAddToLoadoutButton") && uiData.selectedFilteredSkillsetIndex >= 0) {
+        if (ImGui::Button("Add selected to loadout##loadoutSolverAddToLoadoutButton") && uiData.selectedFilteredSkillsetIndex >= 0
+            && uiData.selectedFilteredSkillset.size() == static_cast<size_t>(indexWords)) {
             std::string switchSuffix = " ";
             for (auto& switchTalentChoice : talentTreeCollection.activeTreeData().treeDAGInfo->switchTalentChoices) {
                 switchSuffix += std::to_string(switchTalentChoice.second);
@@ -1001,10 +1252,10 @@ namespace TTM {
             std::shared_ptr<Engine::TalentSkillset> sk = Engine::skillsetIndexToSkillset(
                 talentTreeCollection.activeTree(),
                 talentTreeCollection.activeTreeData().treeDAGInfo,
-                uiData.selectedFilteredSkillset
+                uiData.selectedFilteredSkillset.data()
             );
             std::string prefix = uiData.loadoutSolverSkillsetPrefix == "" ? "Solved loadout " : uiData.loadoutSolverSkillsetPrefix + " ";
-            sk->name = prefix + std::to_string(uiData.selectedFilteredSkillset) + switchSuffix;
+            sk->name = prefix + Engine::skillsetIndexToString(uiData.selectedFilteredSkillset.data(), indexWords) + switchSuffix;
             Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), sk);
             talentTreeCollection.activeTree().loadout.push_back(sk);
             ImGui::OpenPopup("Add to loadout successfull");
@@ -1014,20 +1265,24 @@ namespace TTM {
             for (auto& switchTalentChoice : talentTreeCollection.activeTreeData().treeDAGInfo->switchTalentChoices) {
                 switchSuffix += std::to_string(switchTalentChoice.second);
             }
-            for (uint64_t& skillsetIndex : uiData.loadoutSolverPageResults) {
+            for (size_t i = 0; i < uiData.loadoutSolverPageResults.size(); i += indexWords) {
+                const Engine::SIND* skillsetIndex = &uiData.loadoutSolverPageResults[i];
                 std::shared_ptr<Engine::TalentSkillset> sk = Engine::skillsetIndexToSkillset(
                     talentTreeCollection.activeTree(),
                     talentTreeCollection.activeTreeData().treeDAGInfo,
                     skillsetIndex
                 );
                 std::string prefix = uiData.loadoutSolverSkillsetPrefix == "" ? "Solved loadout " : uiData.loadoutSolverSkillsetPrefix + " ";
-                sk->name = prefix + std::to_string(skillsetIndex) + switchSuffix;
+                sk->name = prefix + Engine::skillsetIndexToString(skillsetIndex, indexWords) + switchSuffix;
                 Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), sk);
                 talentTreeCollection.activeTree().loadout.push_back(sk);
             }
             ImGui::OpenPopup("Add to loadout successfull");
         }
-        int maxAddRandomLimit = static_cast<int>(talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection].size());
+        Engine::CombinationCount selectionCount = Engine::getFilteredCombinationCount(
+            *talentTreeCollection.activeTreeData().treeDAGInfo,
+            uiData.loadoutSolverTalentPointSelection);
+        int maxAddRandomLimit = selectionCount > static_cast<Engine::CombinationCount>(uiData.loadoutSolverAddAllLimit) ? uiData.loadoutSolverAddAllLimit : static_cast<int>(selectionCount);
         ImGui::SliderInt("##loadoutSolverAddRandomToLoadoutSlider", &uiData.loadoutSolverAddRandomLoadoutCount, 1, uiData.loadoutSolverAddAllLimit > maxAddRandomLimit ? maxAddRandomLimit : uiData.loadoutSolverAddAllLimit, "%d", ImGuiSliderFlags_AlwaysClamp);
         if (ImGui::Button(("Add " + std::to_string(uiData.loadoutSolverAddRandomLoadoutCount) + " random skillsets to loadout").c_str())) {
             std::string switchSuffix = " ";
@@ -1038,23 +1293,23 @@ namespace TTM {
             std::random_device rd;     // only used once to initialise (seed) engine
             std::mt19937 rng(rd());    // random-number engine used (Mersenne-Twister in this case)
 
-            auto& SINDintPairs = talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection];
-            if (uiData.loadoutSolverAddRandomLoadoutCount > SINDintPairs.size()) {
-                uiData.loadoutSolverAddRandomLoadoutCount = static_cast<int>(SINDintPairs.size());
+            Engine::CombinationCount combinationCount = selectionCount;
+            if (uiData.loadoutSolverAddRandomLoadoutCount > combinationCount) {
+                uiData.loadoutSolverAddRandomLoadoutCount = static_cast<int>(combinationCount);
             }
 
             //TTMNOTE: Probably cleaner to just fisher yates shuffle and backtrack
-            std::vector<int> randomIndices;
+            std::vector<Engine::CombinationCount> randomIndices;
             randomIndices.reserve(uiData.loadoutSolverAddRandomLoadoutCount);
-            if (SINDintPairs.size() < uiData.loadoutSolverAddAllLimit * 10) {
-                std::vector<int> indices (SINDintPairs.size());
+            if (combinationCount < uiData.loadoutSolverAddAllLimit * 10) {
+                std::vector<Engine::CombinationCount> indices (combinationCount);
                 std::iota(indices.begin(), indices.end(), 0);
                 std::sample(indices.begin(), indices.end(), std::back_inserter(randomIndices), uiData.loadoutSolverAddRandomLoadoutCount, rng);
             }
             else {
-                std::uniform_int_distribution<int> uni(0, static_cast<int>(SINDintPairs.size()));
+                std::uniform_int_distribution<Engine::CombinationCount> uni(0, combinationCount - 1);
                 while(randomIndices.size() < uiData.loadoutSolverAddRandomLoadoutCount) {
-                    int randPick = uni(rng);
+                    Engine::CombinationCount randPick = uni(rng);
                     bool duplicate = false;
                     bool inc1 = false;
                     bool inc2 = false;
@@ -1063,23 +1318,23 @@ namespace TTM {
                         if (randomIndices[j] == randPick) {
                             duplicate = true;
                         }
-                        if (randomIndices[j] == (randPick + 1) % SINDintPairs.size()) {
+                        if (randomIndices[j] == (randPick + 1) % combinationCount) {
                             inc1 = true;
                         }
-                        if (randomIndices[j] == (randPick + 2) % SINDintPairs.size()) {
+                        if (randomIndices[j] == (randPick + 2) % combinationCount) {
                             inc2  = true;
                         }
-                        if (randomIndices[j] == (randPick + 3) % SINDintPairs.size()) {
+                        if (randomIndices[j] == (randPick + 3) % combinationCount) {
                             inc3 = true;
                         }
                     }
                     if (duplicate) {
                         if (!inc1) {
-                            randomIndices.push_back((randPick + 1) % SINDintPairs.size());
+                            randomIndices.push_back((randPick + 1) % combinationCount);
                         } else if (!inc2) {
-                            randomIndices.push_back((randPick + 2) % SINDintPairs.size());
+                            randomIndices.push_back((randPick + 2) % combinationCount);
                         } else if (!inc3) {
-                            randomIndices.push_back((randPick + 3) % SINDintPairs.size());
+                            randomIndices.push_back((randPick + 3) % combinationCount);
                         }
                     }
                     else {
@@ -1089,14 +1344,18 @@ namespace TTM {
             }
 
 
-            for (int randomIndex : randomIndices) {
+            std::vector<Engine::SIND> randomSkillsetIndex;
+            for (Engine::CombinationCount randomIndex : randomIndices) {
+                randomSkillsetIndex.clear();
+                Engine::getFilteredCombinations(*talentTreeCollection.activeTreeData().treeDAGInfo, uiData.loadoutSolverTalentPointSelection, randomIndex, 1, randomSkillsetIndex);
+                const Engine::SIND* skillsetIndex = randomSkillsetIndex.data();
                 std::shared_ptr<Engine::TalentSkillset> sk = Engine::skillsetIndexToSkillset(
                     talentTreeCollection.activeTree(),
                     talentTreeCollection.activeTreeData().treeDAGInfo,
-                    talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection][randomIndex]
+                    skillsetIndex
                 );
                 std::string prefix = uiData.loadoutSolverSkillsetPrefix == "" ? "Solved loadout " : uiData.loadoutSolverSkillsetPrefix + " ";
-                sk->name = prefix + std::to_string(talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection][randomIndex]) + switchSuffix;
+                sk->name = prefix + Engine::skillsetIndexToString(skillsetIndex, indexWords) + switchSuffix;
                 Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), sk);
                 talentTreeCollection.activeTree().loadout.push_back(sk);
             }
@@ -1108,14 +1367,17 @@ namespace TTM {
                 switchSuffix += std::to_string(switchTalentChoice.second);
             }
             size_t count = 0;
-            for (uint64_t& skillsetIndex : talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection]) {
+            std::vector<Engine::SIND> filteredResults;
+            Engine::getFilteredCombinations(*talentTreeCollection.activeTreeData().treeDAGInfo, uiData.loadoutSolverTalentPointSelection, 0, uiData.loadoutSolverAddAllLimit, filteredResults);
+            for (size_t i = 0; i < filteredResults.size(); i += indexWords) {
+                const Engine::SIND* skillsetIndex = &filteredResults[i];
                 std::shared_ptr<Engine::TalentSkillset> sk = Engine::skillsetIndexToSkillset(
                     talentTreeCollection.activeTree(),
                     talentTreeCollection.activeTreeData().treeDAGInfo,
                     skillsetIndex
                 );
                 std::string prefix = uiData.loadoutSolverSkillsetPrefix == "" ? "Solved loadout " : uiData.loadoutSolverSkillsetPrefix + " ";
-                sk->name = prefix + std::to_string(skillsetIndex) + switchSuffix;
+                sk->name = prefix + Engine::skillsetIndexToString(skillsetIndex, indexWords) + switchSuffix;
                 Engine::applyPreselectedTalentsToSkillset(talentTreeCollection.activeTree(), sk);
                 talentTreeCollection.activeTree().loadout.push_back(sk);
                 count++;
@@ -1129,24 +1391,56 @@ namespace TTM {
         ImGui::Text("(Limited to %d)", uiData.loadoutSolverAddAllLimit);
     }
 
+    /*
+    Keeps the talent inclusion counts of the selected talent point bucket up to date, they are only recomputed when the bucket, the applied
+    filter or the tree DAG changes since filtered buckets have to be scanned once.
+    */
+    void updateTalentInclusionCounts(UIData& uiData, TalentTreeCollection& talentTreeCollection) {
+        std::shared_ptr<Engine::TreeDAGInfo> treeDAG = talentTreeCollection.activeTreeData().treeDAGInfo;
+        int bucket = uiData.loadoutSolverTalentPointSelection;
+        if (!treeDAG || bucket < 0 || !talentTreeCollection.activeTreeData().isTreeSolveFiltered) {
+            uiData.loadoutSolverInclusionCounts.clear();
+            uiData.loadoutSolverInclusionTotal = 0;
+            uiData.loadoutSolverInclusionTreeDAG = nullptr;
+            uiData.loadoutSolverInclusionBucket = -1;
+            return;
+        }
+        Engine::CombinationFilterBits appliedFilter = treeDAG->hasCurrentFilter ? treeDAG->currentFilter : Engine::CombinationFilterBits();
+        if (uiData.loadoutSolverInclusionTreeDAG == treeDAG.get() && uiData.loadoutSolverInclusionBucket == bucket
+            && uiData.loadoutSolverInclusionFilter == appliedFilter) {
+            return;
+        }
+        uiData.loadoutSolverInclusionCounts = Engine::getTalentPointInclusionCounts(talentTreeCollection.activeTree(), *treeDAG, bucket);
+        uiData.loadoutSolverInclusionTotal = Engine::getFilteredCombinationCount(*treeDAG, bucket);
+        uiData.loadoutSolverInclusionTreeDAG = treeDAG.get();
+        uiData.loadoutSolverInclusionBucket = bucket;
+        uiData.loadoutSolverInclusionFilter = appliedFilter;
+    }
+
     int getResultsPage(UIData& uiData, TalentTreeCollection& talentTreeCollection, int pageNumber) {
-        std::vector<Engine::SIND>& filteredResults = talentTreeCollection.activeTreeData().treeDAGInfo->filteredCombinations[uiData.loadoutSolverTalentPointSelection];
-        int maxPage = static_cast<int>((filteredResults.size() - 1) / uiData.loadoutSolverResultsPerPage);
+        Engine::TreeDAGInfo& treeDAG = *talentTreeCollection.activeTreeData().treeDAGInfo;
+        int indexWords = treeDAG.indexWords;
+        Engine::CombinationCount resultCount = Engine::getFilteredCombinationCount(treeDAG, uiData.loadoutSolverTalentPointSelection);
+        //browsing without solving can have more pages than an int can count
+        Engine::CombinationCount pageCount = resultCount > 0 ? (resultCount - 1) / uiData.loadoutSolverResultsPerPage : 0;
+        int maxPage = pageCount > INT_MAX ? INT_MAX : static_cast<int>(pageCount);
         if (pageNumber == uiData.loadoutSolverBufferedPage) {
             return maxPage;
         }
         uiData.loadoutSolverBufferedPage = pageNumber;
         uiData.loadoutSolverPageResults.clear();
-        int maxIndex = (pageNumber + 1) * uiData.loadoutSolverResultsPerPage;
-        maxIndex = maxIndex > filteredResults.size() ? static_cast<int>(filteredResults.size()) : maxIndex;
-        if (maxIndex == 0) {
+        if (pageNumber < 0) {
             return maxPage;
         }
-        for (int i = pageNumber * uiData.loadoutSolverResultsPerPage; i < maxIndex; i++) {
-            uiData.loadoutSolverPageResults.push_back(filteredResults[i]);
-        }
+        //ranked tree DAGs unrank only the builds of this page, so any page is available right away
+        Engine::getFilteredCombinations(
+            treeDAG,
+            uiData.loadoutSolverTalentPointSelection,
+            static_cast<Engine::CombinationCount>(pageNumber) * uiData.loadoutSolverResultsPerPage,
+            uiData.loadoutSolverResultsPerPage,
+            uiData.loadoutSolverPageResults);
         if (uiData.loadoutSolverPageResults.size() > 0) {
-            uiData.selectedFilteredSkillset = uiData.loadoutSolverPageResults[0];
+            uiData.selectedFilteredSkillset.assign(uiData.loadoutSolverPageResults.begin(), uiData.loadoutSolverPageResults.begin() + indexWords);
         }
         return maxPage;
     }
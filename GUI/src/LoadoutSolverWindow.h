@@ -1,13 +1,19 @@
 #pragma once
 
 #include "TalentTrees.h"
+#include "CombinationStore.h"
+#include "CombinationBitmapIndex.h"
+#include "CombinationRanker.h"
+#include "SolveCheckpoint.h"
 #include "TalentTreeManagerDefinitions.h"
 
 namespace TTM {
+	static void AddTalentInclusionText(const UIData& uiData, Engine::Talent_s talent);
 	static void AttachLoadoutSolverTooltip(const UIData& uiData, Engine::Talent_s talent, int assignedPointsTarget);
 	void RenderLoadoutSolverWindow(UIData& uiData, TalentTreeCollection& talentTreeCollection);
 	void placeLoadoutSolverTreeElements(UIData& uiData, TalentTreeCollection& talentTreeCollection);
 	void displayFilteredSkillsetSelector(UIData& uiData, TalentTreeCollection& talentTreeCollection);
 	int getResultsPage(UIData& uiData, TalentTreeCollection& talentTreeCollection, int pageNumber);
+	void updateTalentInclusionCounts(UIData& uiData, TalentTreeCollection& talentTreeCollection);
 	
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 
 #include "TTMGUIPresets.h"
 #include "TTMEnginePresets.h"
+#include "SolveCache.h"
 
 #include "Updater.h"
 #include "ImageHandler.h"
@@ -204,6 +205,21 @@ namespace TTM {
                 if (ImGui::MenuItem("Save", "Ctrl+S")) {
                     saveWorkspace(uiData, talentTreeCollection);
                 }
+                if (ImGui::BeginMenu("Solve cache")) {
+                    if (ImGui::MenuItem("Use solve cache", NULL, &uiData.enableSolveCache)) {
+                        Engine::setSolveCacheEnabled(uiData.enableSolveCache);
+                    }
+                    ImGui::SetNextItemWidth(120);
+                    if (ImGui::InputInt("Disk budget (MB)", &uiData.solveCacheBudget, 256, 1024)) {
+                        uiData.solveCacheBudget = uiData.solveCacheBudget < 0 ? 0 : uiData.solveCacheBudget;
+                        Engine::setSolveCacheDiskBudget(static_cast<std::uintmax_t>(uiData.solveCacheBudget) * 1024 * 1024);
+                    }
+                    std::string clearLabel = "Clear solve cache (" + std::to_string(Engine::getSolveCacheSize() / (1024 * 1024)) + " MB)";
+                    if (ImGui::MenuItem(clearLabel.c_str())) {
+                        Engine::clearSolveCache();
+                    }
+                    ImGui::EndMenu();
+                }
                 if (ImGui::MenuItem("Close")) {
                     saveWorkspace(uiData, talentTreeCollection);
                     done = true;
@@ -895,6 +911,8 @@ namespace TTM {
                 }
                 if (uiData.editorView != EditorView::LoadoutSolver) {
                     uiData.editorView = EditorView::LoadoutSolver;
+                    //the tree might have been edited meanwhile
+                    uiData.loadoutSolverCheckpointOutdated = true;
                     //saveWorkspace(uiData, talentTreeCollection);
                 }
                 uiData.isLoadoutInitValidated = false;
@@ -1073,6 +1091,8 @@ namespace TTM {
         else {
             settings += "GLOW=0\n";
         }
+        settings += uiData.enableSolveCache ? "SOLVECACHE=1\n" : "SOLVECACHE=0\n";
+        settings += "SOLVECACHEBUDGET=" + std::to_string(uiData.solveCacheBudget) + "\n";
         switch (uiData.fontsize) {
         case Presets::FONTSIZE::MINI: {settings += "FONTSIZE=MINI\n"; } break;
         case Presets::FONTSIZE::SMALL: {settings += "FONTSIZE=SMALL\n"; } break;
@@ -1158,6 +1178,13 @@ namespace TTM {
                         uiData.fontsize = Presets::FONTSIZE::HUGE;
                     }
                 }
+                if (line.find("SOLVECACHEBUDGET") != std::string::npos) {
+                    int budget = std::stoi(line.substr(line.find("=") + 1));
+                    uiData.solveCacheBudget = budget < 0 ? 0 : budget;
+                }
+                else if (line.find("SOLVECACHE") != std::string::npos) {
+                    uiData.enableSolveCache = (line == "SOLVECACHE=1");
+                }
                 //WINDOWPLACEMENT is loaded in a separate function cause it needs to happen earlier
                 if (line.find("DIVIDERRATIO") != std::string::npos) {
                     std::string ratioStr = line.substr(line.find("=") + 1);
@@ -1165,6 +1192,8 @@ namespace TTM {
                 }
             }
         }
+        Engine::setSolveCacheEnabled(uiData.enableSolveCache);
+        Engine::setSolveCacheDiskBudget(static_cast<std::uintmax_t>(uiData.solveCacheBudget) * 1024 * 1024);
         //init talent tree collection
         TalentTreeCollection col;
         if (!std::filesystem::is_regular_file(appPath / "workspace.txt")) {
@@ -1320,5 +1349,7 @@ namespace TTM {
         uiData.style = Presets::STYLES::LIGHT_MODE;
         uiData.enableGlow = false;
         uiData.fontsize = Presets::FONTSIZE::DEFAULT;
+        uiData.enableSolveCache = true;
+        uiData.solveCacheBudget = static_cast<int>(SOLVE_CACHE_DEFAULT_DISK_BUDGET / (1024 * 1024));
     }
 }
\ No newline at end of file
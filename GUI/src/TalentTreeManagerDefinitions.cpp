@@ -24,6 +24,7 @@
 #include "imgui_internal.h"
 
 #include <ppl.h>
+#include <thread>
 
 namespace TTM {
     void refreshIconMap(UIData& uiData) {
@@ -1359,7 +1360,37 @@ namespace TTM {
         }
     }
 
+    /*
+    Creates the bitmap and nearest build index of a solved tree DAG on a background thread, filters and nearest build queries scan the
+    combinations until the indices are published (see Engine::createCombinationBitmapIndex and Engine::createNearestBuildIndex).
+    */
+    void createSolveIndicesAsync(std::shared_ptr<Engine::TreeDAGInfo> treeDAG) {
+        //browse only tree DAGs have no combinations in memory
+        if (!treeDAG || Engine::isBrowseOnly(*treeDAG)) {
+            return;
+        }
+        std::thread t([treeDAG]() {
+            Engine::createCombinationBitmapIndex(treeDAG);
+            Engine::createNearestBuildIndex(treeDAG);
+            });
+        t.detach();
+    }
+
     void updateSolverStatus(UIData& uiData, TalentTreeCollection& talentTreeCollection, bool forceUpdate) {
+        //take over the results of finished solver threads, the handle guarantees they are completely written
+        for (auto& talentTreeData : talentTreeCollection.trees) {
+            if (talentTreeData.isTreeSolveInProgress && talentTreeData.solveHandle && talentTreeData.solveHandle->isFinished()) {
+                talentTreeData.treeDAGInfo = talentTreeData.solverResult->treeDAGInfo;
+                talentTreeData.safetyGuardTriggered = talentTreeData.solverResult->safetyGuardTriggered;
+                createSolveIndicesAsync(talentTreeData.treeDAGInfo);
+                talentTreeData.isTreeSolveInProgress = false;
+                talentTreeData.solveHandle = nullptr;
+                talentTreeData.solverResult = nullptr;
+                //canceled solves leave a checkpoint behind, completed ones remove theirs
+                uiData.loadoutSolverCheckpointOutdated = true;
+                forceUpdate = true;
+            }
+        }
         auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - uiData.currentSolversLastUpdateTime);
         if (milliseconds > uiData.currentSolversUpdateInterval || forceUpdate) {
             uiData.currentSolversLastUpdateTime = std::chrono::steady_clock::now();
@@ -1384,9 +1415,16 @@ namespace TTM {
 
     void stopAllSolvers(TalentTreeCollection& talentTreeCollection) {
         for (auto& talentTreeData : talentTreeCollection.trees) {
-            if (talentTreeData.isTreeSolveInProgress) {
-                talentTreeData.safetyGuardTriggered = true;
-            }
+            cancelSolve(talentTreeData);
+        }
+    }
+
+    /*
+    Asks the solver thread of a tree to stop, the tree keeps its partial results (marked as canceled) once the thread finished.
+    */
+    void cancelSolve(TalentTreeData& talentTreeData) {
+        if (talentTreeData.isTreeSolveInProgress && talentTreeData.solveHandle) {
+            talentTreeData.solveHandle->cancel();
         }
     }
 
@@ -1810,9 +1848,11 @@ namespace TTM {
         uiData.loadoutSolverTalentPointSelection = -1;
         uiData.loadoutSolverSkillsetResultPage = -1;
         uiData.loadoutSolverBufferedPage = -1;
-        uiData.selectedFilteredSkillset = 0;
+        uiData.selectedFilteredSkillset.clear();
         uiData.selectedFilteredSkillsetIndex = -1;
         uiData.loadoutSolverAutoApplyFilter = false;
+        uiData.loadoutSolverStoreMessage = "";
+        uiData.loadoutSolverMatchingTreeDAG = nullptr;
         if (onlyUIData) {
             return;
         }
@@ -1820,7 +1860,11 @@ namespace TTM {
         talentTreeCollection.activeTreeData().isTreeSolveProcessed = false;
         talentTreeCollection.activeTreeData().isTreeSolveFiltered = false;
         talentTreeCollection.activeTreeData().safetyGuardTriggered = false;
+        //a running solve is stopped and its results are dropped
+        cancelSolve(talentTreeCollection.activeTreeData());
         talentTreeCollection.activeTreeData().isTreeSolveInProgress = false;
+        talentTreeCollection.activeTreeData().solveHandle = nullptr;
+        talentTreeCollection.activeTreeData().solverResult = nullptr;
         talentTreeCollection.activeTreeData().skillsetFilter = nullptr;
         talentTreeCollection.activeTreeData().treeDAGInfo = nullptr;
     }
@@ -1829,13 +1873,18 @@ namespace TTM {
         uiData.loadoutSolverTalentPointSelection = -1;
         uiData.loadoutSolverSkillsetResultPage = -1;
         uiData.loadoutSolverBufferedPage = -1;
-        uiData.selectedFilteredSkillset = 0;
+        uiData.selectedFilteredSkillset.clear();
         uiData.selectedFilteredSkillsetIndex = -1;
         uiData.loadoutSolverAutoApplyFilter = false;
+        uiData.loadoutSolverStoreMessage = "";
+        uiData.loadoutSolverMatchingTreeDAG = nullptr;
         talentTreeData.isTreeSolveProcessed = false;
         talentTreeData.isTreeSolveFiltered = false;
         talentTreeData.safetyGuardTriggered = false;
+        cancelSolve(talentTreeData);
         talentTreeData.isTreeSolveInProgress = false;
+        talentTreeData.solveHandle = nullptr;
+        talentTreeData.solverResult = nullptr;
         talentTreeData.skillsetFilter = nullptr;
         talentTreeData.treeDAGInfo = nullptr;
     }
@@ -15,6 +15,9 @@
 #include "ImageHandler.h"
 #include "TalentTrees.h"
 #include "TreeSolver.h"
+#include "NearestBuildIndex.h"
+#include "CombinationBitmapIndex.h"
+#include "CombinationRanker.h"
 #include "TTMGUIPresets.h"
 
 namespace TTM {
@@ -72,6 +75,15 @@ namespace TTM {
 		Settings, Breakdown, Ranking
 	};
 
+	/*
+	Results of a solver thread, only the solver thread writes them until the solve handle of the tree is finished.
+	*/
+	struct SolverThreadResult {
+		std::shared_ptr<Engine::TreeDAGInfo> treeDAGInfo;
+		bool inProgress = true;
+		bool safetyGuardTriggered = false;
+	};
+
 	struct TalentTreeData {
 		Engine::TalentTree tree;
 
@@ -82,6 +94,9 @@ namespace TTM {
 		bool isTreeSolveFiltered = false;
 		bool safetyGuardTriggered = false;
 		std::shared_ptr<Engine::TreeDAGInfo> treeDAGInfo;
+		//set while a solver thread is running, see updateSolverStatus
+		std::shared_ptr<Engine::SolveHandle> solveHandle;
+		std::shared_ptr<SolverThreadResult> solverResult;
 		std::shared_ptr<Engine::TalentSkillset> skillsetFilter;
 		bool onlyLimitSolve = true;
 		bool restrictTalentPoints = false;
@@ -145,6 +160,10 @@ namespace TTM {
 
 		Presets::FONTSIZE fontsize = Presets::FONTSIZE::DEFAULT;
 
+		//solve cache settings (see SolveCache.h), disk budget in MB
+		bool enableSolveCache = true;
+		int solveCacheBudget = 2048;
+
 		std::string menuBarUpdateLabel = "";
 
 		bool treeSwitchCD = false;
@@ -260,6 +279,12 @@ namespace TTM {
 		std::pair<int, int> loadoutEditorImportSkillsetsResult;
 		std::shared_ptr<Engine::TalentSkillset> hoveredEditorSkillset = nullptr;
 		std::shared_ptr<std::pair<Engine::TalentTree*, std::shared_ptr<Engine::TalentSkillset>>> hoveredBlizzHashCombo = nullptr;
+		//closest legal builds of the active skillset (see Engine::findNearestBuilds), recomputed when the skillset, solve or distance changes
+		int loadoutEditorNearestBuildDistance = 3;
+		std::vector<Engine::NearestBuild> loadoutEditorNearestBuilds;
+		std::map<int, int> loadoutEditorNearestBuildsSkillPoints;
+		const Engine::TreeDAGInfo* loadoutEditorNearestBuildsTreeDAG = nullptr;
+		int loadoutEditorNearestBuildsDistance = -1;
 
 		//############# LOADOUT SOLVER VARIABLES ########################
 		const int maxConcurrentSolvers = 3;
@@ -267,7 +292,7 @@ namespace TTM {
 		std::chrono::steady_clock::time_point currentSolversLastUpdateTime = std::chrono::steady_clock::now();
 		std::vector<std::pair<std::string, TalentTreeData*>> currentSolvers;
 		std::vector<std::pair<std::string, TalentTreeData*>> solvedTrees;
-		const int loadoutSolverMaxTalentPoints = 64;
+		const int loadoutSolverMaxTalentPoints = MAX_SOLVER_TALENTS;
 		int loadoutSolverTalentPointLimit = 30;
 		LoadoutSolverPage loadoutSolverPage = LoadoutSolverPage::SolutionResults;
 		int loadoutSolverTalentPointSelection = -1;
@@ -280,9 +305,34 @@ namespace TTM {
 		const int loadoutSolverAddAllLimit = 20000;
 		//the currently buffered results page which should differ from the selected/requested page only for 1 frame
 		int loadoutSolverBufferedPage = -1;
+		//skillset indices of the buffered page, TreeDAGInfo::indexWords SINDs per skillset
 		std::vector<Engine::SIND> loadoutSolverPageResults;
+		//result of the last save/load of a solution (combination store)
+		std::string loadoutSolverStoreMessage = "";
+		//checkpoints are opt in since every checkpoint record holds all combinations found so far (see Engine::SolveCheckpoint)
+		bool loadoutSolverUseCheckpoints = false;
+		//checkpoint of the solve the solver would start next, recomputed when the tree or the solve settings change, when the solver
+		//tab is opened or a solve finished (loadoutSolverCheckpointOutdated), see updateSolveCheckpointStatus
+		std::filesystem::path loadoutSolverCheckpointPath;
+		bool loadoutSolverCheckpointAvailable = false;
+		bool loadoutSolverCheckpointOutdated = true;
+		int loadoutSolverCheckpointTreeIndex = -1;
+		int loadoutSolverCheckpointTalentPointLimit = -1;
+		bool loadoutSolverCheckpointOnlyLimitSolve = false;
+		//live combination count of the current filter (bitmap index query), recomputed when the filter or tree DAG changes
+		std::map<int, int> loadoutSolverMatchingFilter;
+		const Engine::TreeDAGInfo* loadoutSolverMatchingTreeDAG = nullptr;
+		size_t loadoutSolverMatchingCount = 0;
+		//number of builds of the selected talent point bucket with at least r + 1 points per talent (see Engine::getTalentPointInclusionCounts),
+		//recomputed when the bucket, the applied filter or the tree DAG changes
+		bool loadoutSolverShowInclusionCounts = true;
+		std::map<int, std::vector<Engine::CombinationCount>> loadoutSolverInclusionCounts;
+		Engine::CombinationCount loadoutSolverInclusionTotal = 0;
+		const Engine::TreeDAGInfo* loadoutSolverInclusionTreeDAG = nullptr;
+		int loadoutSolverInclusionBucket = -1;
+		Engine::CombinationFilterBits loadoutSolverInclusionFilter;
 		int selectedFilteredSkillsetIndex = -1;
-		Engine::SIND selectedFilteredSkillset = 0;
+		std::vector<Engine::SIND> selectedFilteredSkillset;
 		std::shared_ptr<Engine::TalentSkillset> hoveredFilteredSkillset = nullptr;
 
 		//############# SIM ANALYSIS VARIABLES ########################
@@ -412,8 +462,10 @@ namespace TTM {
 
 	void clearTextboxes(UIData& uiData);
 	void resetComplementaryIndices(TalentTreeCollection& talentTreeCollection);
+	void createSolveIndicesAsync(std::shared_ptr<Engine::TreeDAGInfo> treeDAG);
 	void updateSolverStatus(UIData& uiData, TalentTreeCollection& talentTreeCollection, bool forceUpdate = false);
 	void stopAllSolvers(TalentTreeCollection& talentTreeCollection);
+	void cancelSolve(TalentTreeData& talentTreeData);
 	void clearSolvingProcess(UIData& uiData, TalentTreeCollection& talentTreeCollection, bool onlyUIData = false);
 	void clearSolvingProcess(UIData& uiData, TalentTreeData& talentTreeData);
 	void clearSimAnalysisProcess(UIData& uiData, TalentTreeCollection& talentTreeCollection, bool onlyUIData = false);